@@ -5,6 +5,12 @@
  * A test experiment in C. Mainly for use on Windows, where other programming
  * languages can be somewhat cludgy to use cleanly.
  *
+ * It's also the reference for both init program protocols. If the first line
+ * we get is "MOLTINIT <version> <nx> <ny> <nz> <scale>", we answer with
+ * "MOLTINIT <version>", and write the whole volume out as raw doubles, x
+ * fastest. Otherwise, the first line is the (scaled) dimensions, every line
+ * after it is a point, and we answer each one with a line of our own.
+ *
  * TO COMPILE
  *   gcc -o test.exe test.c -lm
  */
@@ -14,6 +20,14 @@
 #include <string.h>
 #include <math.h>
 
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#define INIT_MAGIC   "MOLTINIT"
+#define INIT_VERSION 1
+
 #define C0 299792458
 #define EI 4
 #define C  (C0 / sqrt(EI))
@@ -24,6 +38,8 @@ typedef double f64;
 f64 funcf(f64 dim[3], f64 curr[3]);
 f64 funcg(f64 dim[3], f64 curr[3]);
 
+int binary(char *header, int velocitymode);
+
 int main(int argc, char **argv)
 {
 	f64 dim[3];
@@ -48,7 +64,15 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	for (line = 0; buf == fgets(buf, sizeof(buf), stdin); line++) {
+	if (buf != fgets(buf, sizeof(buf), stdin)) {
+		return 0;
+	}
+
+	if (strncmp(buf, INIT_MAGIC " ", strlen(INIT_MAGIC " ")) == 0) {
+		return binary(buf, velocitymode);
+	}
+
+	for (line = 0; line == 0 || buf == fgets(buf, sizeof(buf), stdin); line++) {
 		rc = sscanf(buf, "%lf\t%lf\t%lf\n", &curr[0], &curr[1], &curr[2]);
 
 		if (rc != 3) {
@@ -72,6 +96,57 @@ int main(int argc, char **argv)
 	return 0;
 }
 
+int binary(char *header, int velocitymode)
+{
+	f64 dim[3];
+	f64 curr[3];
+	f64 scale, *row;
+	int n[3], version;
+	int x, y, z;
+
+#ifdef _WIN32
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	if (sscanf(header + strlen(INIT_MAGIC), "%d %d %d %d %lf", &version, &n[0], &n[1], &n[2], &scale) != 5) {
+		fprintf(stderr, "Bad header [%s]\n", header);
+		return 1;
+	}
+
+	if (version != INIT_VERSION) {
+		fprintf(stderr, "Unsupported protocol version %d\n", version);
+		return 1;
+	}
+
+	printf("%s %d\n", INIT_MAGIC, INIT_VERSION);
+
+	dim[0] = n[0] * scale;
+	dim[1] = n[1] * scale;
+	dim[2] = n[2] * scale;
+
+	row = calloc(n[0], sizeof(f64));
+
+	for (z = 0; z < n[2]; z++) {
+		for (y = 0; y < n[1]; y++) {
+			for (x = 0; x < n[0]; x++) {
+				curr[0] = x * scale;
+				curr[1] = y * scale;
+				curr[2] = z * scale;
+				row[x] = velocitymode ? funcg(dim, curr) : funcf(dim, curr);
+			}
+
+			if (fwrite(row, sizeof(f64), n[0], stdout) != (size_t)n[0]) {
+				free(row);
+				return 1;
+			}
+		}
+	}
+
+	free(row);
+
+	return 0;
+}
+
 f64 funcf(f64 dim[3], f64 curr[3])
 {
 	f64 xinit, yinit, zinit, interim;
@@ -0,0 +1,56 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 02:55
+ *
+ * The same initial conditions as test.c, as an init library, for the
+ * initamp_lib and initvel_lib config options. molt calls these from several
+ * threads at once, a plane at a time, so there's no state in here.
+ *
+ * TO COMPILE
+ *   gcc -fPIC -shared -o testlib.so testlib.c -lm
+ */
+
+#include <math.h>
+
+#define C0 299792458
+#define EI 4
+#define C  (C0 / sqrt(EI))
+
+typedef unsigned long long u64;
+typedef double f64;
+
+static f64 funcf(const f64 dim[3], const f64 curr[3])
+{
+	f64 xinit, yinit, zinit;
+
+	xinit = pow((2 * curr[0] / dim[0] - 1), 2);
+	yinit = pow((2 * curr[1] / dim[1] - 1), 2);
+	zinit = pow((2 * curr[2] / dim[2] - 1), 2);
+
+	return exp(-13.0 * (xinit + yinit + zinit));
+}
+
+static f64 funcg(const f64 dim[3], const f64 curr[3])
+{
+	return C * 2 * 13 * 2 / dim[0] * (2 * curr[0] / dim[0] - 1) * funcf(dim, curr);
+}
+
+/* molt_initamp_fill : the initial amplitude at n points */
+void molt_initamp_fill(const f64 *xyz, f64 *out, u64 n, const f64 *extent)
+{
+	u64 i;
+
+	for (i = 0; i < n; i++) {
+		out[i] = funcf(extent, xyz + i * 3);
+	}
+}
+
+/* molt_initvel_fill : the initial velocity at n points */
+void molt_initvel_fill(const f64 *xyz, f64 *out, u64 n, const f64 *extent)
+{
+	u64 i;
+
+	for (i = 0; i < n; i++) {
+		out[i] = funcg(extent, xyz + i * 3);
+	}
+}
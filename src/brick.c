@@ -0,0 +1,418 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 02:22
+ *
+ * Bricked Volumes
+ *
+ * Every brick gets gathered out of the flat volume into a little x fastest
+ * volume of its own, which then goes through the codec (or doesn't). Bricks
+ * are spread across the cores, just like codec chunks are.
+ *
+ * A relative error bound is resolved against the whole volume before any
+ * bricks get encoded, so every brick is held to the same absolute bound it'd
+ * have been held to without bricking.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "sys.h"
+#include "codec.h"
+#include "brick.h"
+
+#define BRICK_MAGIC *(u32 *)"BRIK"
+
+struct brickjob_t {
+	int codec;
+	struct codecparams_t *params;
+	struct brickhdr_t *hdr;
+	struct brickent_t *ents;
+	u8 *data;     // where the bricks go (or come from)
+	size_t slot;  // worst case size of one brick, while encoding
+	f64 *vol;
+	int thread, threads;
+	int rc;
+};
+
+/* brick_grid : works out how many bricks there are along each axis, returns the total */
+u64 brick_grid(ivec3_t dim, s32 brick, ivec3_t grid)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		grid[i] = (dim[i] + brick - 1) / brick;
+	}
+
+	return grid[0] * (u64)grid[1] * grid[2];
+}
+
+/* brick_extent : gets the part of the volume brick i covers */
+void brick_extent(struct brickhdr_t *hdr, u64 i, ivec3_t start, ivec3_t count)
+{
+	ivec3_t dim, grid;
+	int j;
+
+	Vec3Set(dim, hdr->dim[0], hdr->dim[1], hdr->dim[2]);
+
+	brick_grid(dim, hdr->brick, grid);
+
+	start[0] = (i % grid[0]) * hdr->brick;
+	start[1] = (i / grid[0] % grid[1]) * hdr->brick;
+	start[2] = (i / grid[0] / grid[1]) * hdr->brick;
+
+	for (j = 0; j < 3; j++) {
+		count[j] = dim[j] - start[j] < (s32)hdr->brick ? dim[j] - start[j] : (s32)hdr->brick;
+	}
+}
+
+/* brick_copy : copies a count sized box between two x fastest volumes */
+void brick_copy(f64 *dst, ivec3_t dstdim, ivec3_t dstoff, f64 *src, ivec3_t srcdim, ivec3_t srcoff, ivec3_t count)
+{
+	u64 d, s;
+	s32 y, z;
+
+	for (z = 0; z < count[2]; z++) {
+		for (y = 0; y < count[1]; y++) {
+			d = ((dstoff[2] + z) * (u64)dstdim[1] + dstoff[1] + y) * dstdim[0] + dstoff[0];
+			s = ((srcoff[2] + z) * (u64)srcdim[1] + srcoff[1] + y) * srcdim[0] + srcoff[0];
+			memcpy(dst + d, src + s, count[0] * sizeof(f64));
+		}
+	}
+}
+
+/* brick_slot : worst case size of one encoded brick */
+static size_t brick_slot(int codec, s32 brick)
+{
+	size_t raw;
+
+	raw = sizeof(f64) * brick * (u64)brick * brick;
+
+	if (codec == CODEC_NONE) {
+		return raw;
+	}
+
+	return raw < codec_bound(codec, raw) ? codec_bound(codec, raw) : raw;
+}
+
+/* brick_bound : returns the most bytes bricking a dim volume can take */
+size_t brick_bound(int codec, ivec3_t dim, s32 brick)
+{
+	ivec3_t grid;
+	u64 bricks;
+
+	bricks = brick_grid(dim, brick, grid);
+
+	return sizeof(struct brickhdr_t) + bricks * (sizeof(struct brickent_t) + brick_slot(codec, brick));
+}
+
+/* brick_encodethread : encodes every brick belonging to this thread */
+static void *brick_encodethread(void *arg)
+{
+	struct brickjob_t *job;
+	struct brickent_t *ent;
+	ivec3_t dim, start, count, zero;
+	f64 *buf;
+	u8 *slot;
+	size_t len, raw;
+	f64 maxerr;
+	u64 i, flags;
+	int codec;
+
+	job = arg;
+
+	Vec3Set(dim, job->hdr->dim[0], job->hdr->dim[1], job->hdr->dim[2]);
+	Vec3Set(zero, 0, 0, 0);
+
+	buf = malloc(sizeof(f64) * job->hdr->brick * (u64)job->hdr->brick * job->hdr->brick);
+	if (buf == NULL) {
+		job->rc = -1;
+	}
+
+	for (i = job->thread; job->rc == 0 && i < job->hdr->bricks; i += job->threads) {
+		ent = job->ents + i;
+		slot = job->data + i * job->slot;
+
+		brick_extent(job->hdr, i, start, count);
+		brick_copy(buf, count, zero, job->vol, dim, start, count);
+
+		raw = sizeof(f64) * count[0] * (u64)count[1] * count[2];
+
+		memset(ent, 0, sizeof(*ent));
+
+		// same as whole lumps, a brick the codec can't shrink is stored raw
+		if (job->codec != CODEC_NONE) {
+			len = codec_encode(job->codec, job->params, slot, job->slot, buf, raw, NULL, 0);
+			if (0 < len && len < raw && codec_getinfo(slot, len, &codec, &maxerr, &flags) == 0) {
+				ent->size = len;
+				ent->codec = codec;
+				ent->maxerr = maxerr;
+				continue;
+			}
+		}
+
+		memcpy(slot, buf, raw);
+		ent->size = raw;
+		ent->codec = CODEC_NONE;
+	}
+
+	free(buf);
+
+	return NULL;
+}
+
+/* brick_decodethread : decodes every brick belonging to this thread */
+static void *brick_decodethread(void *arg)
+{
+	struct brickjob_t *job;
+	ivec3_t dim, start, count, zero;
+	f64 *buf;
+	u64 i;
+	int rc;
+
+	job = arg;
+
+	Vec3Set(dim, job->hdr->dim[0], job->hdr->dim[1], job->hdr->dim[2]);
+	Vec3Set(zero, 0, 0, 0);
+
+	buf = malloc(sizeof(f64) * job->hdr->brick * (u64)job->hdr->brick * job->hdr->brick);
+	if (buf == NULL) {
+		job->rc = -1;
+	}
+
+	for (i = job->thread; job->rc == 0 && i < job->hdr->bricks; i += job->threads) {
+		brick_extent(job->hdr, i, start, count);
+
+		rc = brick_decodeone(buf, sizeof(f64) * count[0] * (u64)count[1] * count[2], job->ents + i, job->data + job->ents[i].offset);
+		if (rc < 0) {
+			job->rc = -1;
+			break;
+		}
+
+		brick_copy(job->vol, dim, start, buf, count, zero, count);
+	}
+
+	free(buf);
+
+	return NULL;
+}
+
+/* brick_run : runs func over the bricks on as many threads as make sense */
+static int brick_run(struct brickjob_t *proto, void *(*func)(void *arg))
+{
+	struct brickjob_t *jobs;
+	struct sys_thread **threads;
+	int i, n, rc;
+
+	n = sys_numcores();
+	if (proto->hdr->bricks < n) {
+		n = proto->hdr->bricks;
+	}
+
+	if (n <= 1) { // not worth a thread
+		proto->thread = 0;
+		proto->threads = 1;
+		proto->rc = 0;
+		func(proto);
+		return proto->rc;
+	}
+
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	if (jobs == NULL || threads == NULL) {
+		free(jobs);
+		free(threads);
+		return -1;
+	}
+
+	// every thread has its own share of the work, so if one doesn't start,
+	// the ones that did are waited on, and the whole thing fails
+	for (i = 0, rc = 0; i < n; i++) {
+		jobs[i] = *proto;
+		jobs[i].thread = i;
+		jobs[i].threads = n;
+		jobs[i].rc = 0;
+
+		threads[i] = sys_threadcreate();
+		if (threads[i] == NULL) {
+			rc = -1;
+			break;
+		}
+
+		sys_threadsetfunc(threads[i], func);
+		sys_threadsetarg(threads[i], &jobs[i]);
+
+		if (sys_threadstart(threads[i]) != 0) {
+			sys_threadfree(threads[i]);
+			threads[i] = NULL;
+			rc = -1;
+			break;
+		}
+	}
+
+	for (i = 0; i < n && threads[i]; i++) {
+		sys_threadwait(threads[i]);
+		sys_threadfree(threads[i]);
+		if (jobs[i].rc < 0) {
+			rc = -1;
+		}
+	}
+
+	free(jobs);
+	free(threads);
+
+	return rc;
+}
+
+/* brick_encode : bricks (and encodes) src into dst, returns the size, 0 on failure */
+size_t brick_encode(int codec, struct codecparams_t *params, void *dst, size_t dstlen, f64 *src, ivec3_t dim, s32 brick, int *used, f64 *maxerr)
+{
+	struct codecparams_t abs;
+	struct brickhdr_t hdr;
+	struct brickjob_t job;
+	ivec3_t grid;
+	size_t off;
+	u64 i;
+	int rc;
+
+	if (brick <= 0 || codec < 0 || CODEC_TOTAL <= codec || dstlen < brick_bound(codec, dim, brick)) {
+		return 0;
+	}
+
+	memset(&abs, 0, sizeof(abs));
+
+	if (codec == CODEC_LOSSY) {
+		abs.tolerance = codec_maxerr(params, src, dim[0] * (u64)dim[1] * dim[2]);
+		if (!(0 < abs.tolerance && isfinite(abs.tolerance))) {
+			codec = CODEC_LOSSLESS;
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+
+	hdr.magic = BRICK_MAGIC;
+	hdr.brick = brick;
+	hdr.dim[0] = dim[0];
+	hdr.dim[1] = dim[1];
+	hdr.dim[2] = dim[2];
+	hdr.bricks = brick_grid(dim, brick, grid);
+
+	memset(&job, 0, sizeof(job));
+
+	job.codec = codec;
+	job.params = &abs;
+	job.hdr = &hdr;
+	job.ents = (struct brickent_t *)((u8 *)dst + sizeof(hdr));
+	job.data = (u8 *)dst + sizeof(hdr) + hdr.bricks * sizeof(struct brickent_t);
+	job.slot = brick_slot(codec, brick);
+	job.vol = src;
+
+	// every brick gets coded into its own worst case sized spot...
+	rc = brick_run(&job, brick_encodethread);
+	if (rc < 0) {
+		return 0;
+	}
+
+	// ...then they get packed down against each other
+	*used = CODEC_NONE;
+	*maxerr = 0;
+
+	for (i = 0, off = 0; i < hdr.bricks; i++) {
+		memmove(job.data + off, job.data + i * job.slot, job.ents[i].size);
+		job.ents[i].offset = off;
+		off += job.ents[i].size;
+
+		if (job.ents[i].codec != CODEC_NONE) {
+			*used = *used == CODEC_LOSSY ? CODEC_LOSSY : job.ents[i].codec;
+		}
+
+		if (*maxerr < job.ents[i].maxerr) {
+			*maxerr = job.ents[i].maxerr;
+		}
+	}
+
+	memcpy(dst, &hdr, sizeof(hdr));
+
+	return sizeof(hdr) + hdr.bricks * sizeof(struct brickent_t) + off;
+}
+
+/* brick_decodeone : decodes a single brick's data into dst */
+int brick_decodeone(f64 *dst, size_t dstlen, struct brickent_t *ent, void *src)
+{
+	if (ent->codec == CODEC_NONE) {
+		if (ent->size != dstlen) {
+			return -1;
+		}
+
+		memcpy(dst, src, dstlen);
+
+		return 0;
+	}
+
+	return codec_decode(dst, dstlen, src, ent->size, NULL);
+}
+
+/* brick_decode : puts a bricked volume back together, dst holds the whole volume */
+int brick_decode(f64 *dst, size_t dstlen, void *src, size_t srclen)
+{
+	struct brickhdr_t hdr;
+	struct brickjob_t job;
+	ivec3_t dim, grid;
+	size_t datalen;
+	u64 i;
+	int j;
+
+	if (srclen < sizeof(hdr)) {
+		return -1;
+	}
+
+	memcpy(&hdr, src, sizeof(hdr));
+
+	if (hdr.magic != BRICK_MAGIC || hdr.brick == 0) {
+		return -1;
+	}
+
+	if (sizeof(f64) * hdr.dim[0] * hdr.dim[1] * hdr.dim[2] != dstlen) {
+		return -1;
+	}
+
+	Vec3Set(dim, hdr.dim[0], hdr.dim[1], hdr.dim[2]);
+
+	if (hdr.bricks != brick_grid(dim, hdr.brick, grid)) {
+		return -1;
+	}
+
+	if ((srclen - sizeof(hdr)) / sizeof(struct brickent_t) < hdr.bricks) {
+		return -1;
+	}
+
+	memset(&job, 0, sizeof(job));
+
+	job.hdr = &hdr;
+	job.ents = calloc(hdr.bricks + 1, sizeof(*job.ents));
+	if (job.ents == NULL) {
+		return -1;
+	}
+
+	job.data = (u8 *)src + sizeof(hdr) + hdr.bricks * sizeof(struct brickent_t);
+	job.vol = dst;
+
+	memcpy(job.ents, (u8 *)src + sizeof(hdr), hdr.bricks * sizeof(struct brickent_t));
+
+	datalen = srclen - sizeof(hdr) - hdr.bricks * sizeof(struct brickent_t);
+
+	for (i = 0; i < hdr.bricks; i++) {
+		if (datalen < job.ents[i].offset || datalen - job.ents[i].offset < job.ents[i].size) {
+			free(job.ents);
+			return -1;
+		}
+	}
+
+	j = brick_run(&job, brick_decodethread);
+
+	free(job.ents);
+
+	return j;
+}
@@ -0,0 +1,57 @@
+#ifndef BRICK_H
+#define BRICK_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 02:22
+ *
+ * Bricked Volumes
+ *
+ * A bricked volume is an f64 volume cut up into brick^3 bricks (the ones on
+ * the far edges are cut short), each stored x fastest, and each encoded on its
+ * own. It's a small header, an index with one entry per brick, then the bricks
+ * themselves, in x fastest brick order. Reading a sub-box only has to touch the
+ * bricks it overlaps.
+ */
+
+#include "common.h"
+#include "codec.h"
+
+struct brickhdr_t {
+	u32 magic;
+	u32 brick;  // edge length of a brick, in f64s
+	u64 dim[3]; // the whole volume
+	u64 bricks;
+};
+
+struct brickent_t {
+	u64 offset; // from the end of the index
+	u64 size;
+	u32 codec;  // CODEC_NONE for a brick stored as is
+	u32 pad;
+	f64 maxerr;
+};
+
+/* brick_grid : works out how many bricks there are along each axis, returns the total */
+u64 brick_grid(ivec3_t dim, s32 brick, ivec3_t grid);
+
+/* brick_extent : gets the part of the volume brick i covers */
+void brick_extent(struct brickhdr_t *hdr, u64 i, ivec3_t start, ivec3_t count);
+
+/* brick_copy : copies a count sized box between two x fastest volumes */
+void brick_copy(f64 *dst, ivec3_t dstdim, ivec3_t dstoff, f64 *src, ivec3_t srcdim, ivec3_t srcoff, ivec3_t count);
+
+/* brick_bound : returns the most bytes bricking a dim volume can take */
+size_t brick_bound(int codec, ivec3_t dim, s32 brick);
+
+/* brick_encode : bricks (and encodes) src into dst, returns the size, 0 on failure */
+size_t brick_encode(int codec, struct codecparams_t *params, void *dst, size_t dstlen, f64 *src, ivec3_t dim, s32 brick, int *used, f64 *maxerr);
+
+/* brick_decode : puts a bricked volume back together, dst holds the whole volume */
+int brick_decode(f64 *dst, size_t dstlen, void *src, size_t srclen);
+
+/* brick_decodeone : decodes a single brick's data into dst */
+int brick_decodeone(f64 *dst, size_t dstlen, struct brickent_t *ent, void *src);
+
+#endif // BRICK_H
+
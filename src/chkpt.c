@@ -0,0 +1,209 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 01:45
+ *
+ * Checkpoints
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <sys/time.h>
+
+#include "common.h"
+#include "molt.h"
+#include "config.h"
+#include "chkpt.h"
+#include "codec.h"
+#include "lump.h"
+
+/* chkpt_state : collects the volumes a checkpoint saves and restores */
+void chkpt_state(f64 **state, struct molt_cfg_t *config, f64 *prev, f64 *curr)
+{
+	int i;
+
+	state[0] = prev;
+	state[1] = curr;
+
+	for (i = 0; i < MOLT_WORKSTORE_AMT; i++) {
+		state[2 + i] = config->workstore[i];
+	}
+}
+
+/* chkpt_due : returns true if a checkpoint is due, every so many steps or secs, whichever is set */
+int chkpt_due(s64 every, f64 secs, u64 steps, struct timeval *last)
+{
+	struct timeval now;
+	f64 elapsed;
+
+	if (0 < every && every <= steps) {
+		gettimeofday(last, NULL);
+		return 1;
+	}
+
+	if (0 < secs) {
+		gettimeofday(&now, NULL);
+
+		elapsed =  now.tv_sec + (1e-6 * now.tv_usec);
+		elapsed -= last->tv_sec + (1e-6 * last->tv_usec);
+
+		if (secs <= elapsed) {
+			*last = now;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* chkpt_write : writes the simulation state over the oldest of keep checkpoint slots */
+int chkpt_write(s64 keep, struct molt_cfg_t *config, f64 **state, u64 elems, s64 t, u32 flags)
+{
+	struct lumpheader_t lheader;
+	struct chkpt_t chkpt, slot;
+	size_t volumebytes, size;
+	u64 entries, oldest, seq, i;
+	void *zero;
+	int rc;
+
+	/*
+	 * NOTE
+	 * Checkpoints live in a ring of 'keep' CHECKPNT lumps that are rewritten
+	 * in place, oldest first. The slot's seq is zeroed before anything else
+	 * goes down, and the real header is written last, so a crash halfway
+	 * through only ever costs us the slot being written, never the others.
+	 */
+
+	if (keep <= 0) {
+		keep = MOLT_CHKPT_KEEP;
+	}
+
+	volumebytes = sizeof(f64) * elems;
+	size = sizeof(chkpt) + CHKPT_VOLUMES * volumebytes;
+
+	rc = lump_getnumentries(MOLTSTR_CHKPT, &entries);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// find the slot to write into, and the next sequence number
+	for (i = 0, oldest = 0, seq = 0; i < entries; i++) {
+		rc = lump_read_range(MOLTSTR_CHKPT, i, 0, sizeof(slot), &slot);
+		if (rc < 0) {
+			return -1;
+		}
+
+		if (seq < slot.seq) {
+			seq = slot.seq;
+		}
+
+		if (i == 0 || slot.seq < chkpt.seq) {
+			oldest = i;
+			chkpt.seq = slot.seq;
+		}
+	}
+
+	if (entries < keep) { // the ring isn't full yet, add a fresh slot
+		zero = calloc(1, size);
+		rc = lump_write(MOLTSTR_CHKPT, size, zero, &oldest);
+		free(zero);
+		if (rc < 0) {
+			return -1;
+		}
+	} else {
+		chkpt.seq = 0;
+		rc = lump_write_range(MOLTSTR_CHKPT, oldest, 0, sizeof(chkpt.seq), &chkpt.seq);
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		rc = lump_write_range(MOLTSTR_CHKPT, oldest, sizeof(chkpt) + i * volumebytes, volumebytes, state[i]);
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	rc = lump_getheader(&lheader);
+	if (rc < 0) {
+		return -1;
+	}
+
+	memset(&chkpt, 0, sizeof(chkpt));
+
+	chkpt.seq = seq + 1;
+	chkpt.lumps = lheader.lumps;
+	chkpt.t = t;
+	chkpt.flags = flags;
+	chkpt.volumes = CHKPT_VOLUMES;
+	chkpt.config = *config;
+
+	return lump_write_range(MOLTSTR_CHKPT, oldest, 0, sizeof(chkpt), &chkpt);
+}
+
+/* chkpt_restore : loads the newest checkpoint, rolling the file back to it */
+s64 chkpt_restore(struct molt_cfg_t *config, f64 **state, u64 elems, s64 *t, u32 *flags)
+{
+	struct chkpt_t chkpt, slot;
+	size_t volumebytes, size;
+	u64 entries, newest, i;
+	int rc;
+
+	volumebytes = sizeof(f64) * elems;
+
+	rc = lump_getnumentries(MOLTSTR_CHKPT, &entries);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// torn slots have a zero seq, so they never win
+	for (i = 0, newest = 0, chkpt.seq = 0; i < entries; i++) {
+		rc = lump_readsize(MOLTSTR_CHKPT, i, &size);
+		if (rc < 0 || size != sizeof(slot) + CHKPT_VOLUMES * volumebytes) {
+			continue;
+		}
+
+		rc = lump_read_range(MOLTSTR_CHKPT, i, 0, sizeof(slot), &slot);
+		if (rc < 0) {
+			return -1;
+		}
+
+		if (chkpt.seq < slot.seq && slot.volumes == CHKPT_VOLUMES) {
+			chkpt = slot;
+			newest = i;
+		}
+	}
+
+	if (chkpt.seq == 0) {
+		return 0;
+	}
+
+	// everything up to the working storage pointers has to match
+	if (memcmp(&chkpt.config, config, offsetof(struct molt_cfg_t, workstore)) != 0) {
+		fprintf(stderr, "ERR : checkpoint %ld doesn't match the lump file's config\n", chkpt.seq);
+		return -1;
+	}
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		rc = lump_read_range(MOLTSTR_CHKPT, newest, sizeof(chkpt) + i * volumebytes, volumebytes, state[i]);
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	// drop whatever was written after the checkpoint, it gets written again
+	rc = lump_truncate(chkpt.lumps);
+	if (rc < 0) {
+		return -1;
+	}
+
+	*t = chkpt.t;
+	*flags = chkpt.flags;
+
+	fprintf(stderr, "restarting at t = %ld, from checkpoint %ld\n", *t, chkpt.seq);
+
+	return (*t - config->t_params[MOLT_PARAM_START]) / config->t_params[MOLT_PARAM_STEP];
+}
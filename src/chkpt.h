@@ -0,0 +1,50 @@
+#ifndef CHKPT_H
+#define CHKPT_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 01:45
+ *
+ * Checkpoints
+ *
+ * Everything the time loop needs to carry on bit for bit, written into the
+ * open lump file every so often, so --restart doesn't have to fall back on
+ * the last two AMP entries (see restart.h).
+ */
+
+#include <sys/time.h>
+
+#include "common.h"
+#include "molt.h"
+
+/*
+ * NOTE
+ * A CHECKPNT lump is this header, followed by 'volumes' f64 volumes: prev,
+ * curr, then every workstore buffer. The workstore has to come along,
+ * because the C operator reads buffers that still hold the last step's
+ * values, and without them a resumed run drifts away from the original.
+ */
+struct chkpt_t {
+	u64 seq;     // 0 if the slot doesn't hold a finished checkpoint
+	u64 lumps;   // lumps in the file when the checkpoint was taken
+	s64 t;       // time index of the next step to take
+	u32 flags;   // flags to take that step with
+	u32 volumes;
+	struct molt_cfg_t config;
+};
+
+#define CHKPT_VOLUMES (2 + MOLT_WORKSTORE_AMT)
+
+/* chkpt_state : collects the volumes a checkpoint saves and restores */
+void chkpt_state(f64 **state, struct molt_cfg_t *config, f64 *prev, f64 *curr);
+
+/* chkpt_due : returns true if a checkpoint is due, every so many steps or secs, whichever is set */
+int chkpt_due(s64 every, f64 secs, u64 steps, struct timeval *last);
+
+/* chkpt_write : writes the simulation state over the oldest of keep checkpoint slots */
+int chkpt_write(s64 keep, struct molt_cfg_t *config, f64 **state, u64 elems, s64 t, u32 flags);
+
+/* chkpt_restore : loads the newest checkpoint, rolling the file back to it */
+s64 chkpt_restore(struct molt_cfg_t *config, f64 **state, u64 elems, s64 *t, u32 *flags);
+
+#endif // CHKPT_H
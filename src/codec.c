@@ -0,0 +1,1038 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 01:51
+ *
+ * Lump Codecs
+ *
+ * The lossless codec works on a chunk of f64s in three passes:
+ *
+ *   1. every value is XOR'd with its neighbour in x, so the sign, exponent and
+ *      high mantissa bits of a smooth field mostly come out as zeroes
+ *   2. the 8 bytes of each word are shuffled out into 8 byte planes, so those
+ *      zeroes end up next to each other
+ *   3. each plane is entropy coded on its own, with an order 0 rANS coder
+ *
+ * A plane that's a single repeated byte (very common, early on, where the
+ * field is zero) is stored as that byte, and one rANS can't shrink is stored
+ * as is.
+ *
+ * The lossy codec swaps the first pass out for error bounded quantization.
+ * Each value is predicted from the two before it (as they'll be decoded), and
+ * only the number of quantization steps it's off by gets stored. Those counts
+ * are small integers for a smooth field, so they go through the same byte
+ * planes and rANS. Values that can't be quantized (too far off, or not finite)
+ * are stored as they are, off to the side.
+ *
+ * Either codec can also code a lump as a delta from a reference, the previous
+ * time step of the same volume. Each value is then predicted as its value in
+ * the reference, plus however much it changed, going by how much the two
+ * before it changed. The lossy codec quantizes what's left over like before,
+ * and the lossless one stores it as the number of f64s between the value and
+ * its prediction. The reference the encoder is handed back is the lump as
+ * it'll decode, so a chain of lossy deltas never drifts further than one
+ * error bound.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "sys.h"
+#include "codec.h"
+
+#define CODEC_MAGIC    *(u32 *)"MCDC"
+#define CODEC_CHUNK    (1 << 20) // raw bytes per independently coded chunk
+
+#define RANS_SCALEBITS 12
+#define RANS_SCALE     (1 << RANS_SCALEBITS)
+#define RANS_L         (1u << 23) // lower bound of the coder state
+
+#define LOSSY_MAXQ     (1ll << 50) // most quantization steps a value can be off by
+
+enum {
+	PLANE_RAW,
+	PLANE_CONST,
+	PLANE_RANS
+};
+
+struct codechdr_t {
+	u32 magic;
+	u32 codec;
+	u64 rawsize;
+	u64 chunks;
+	u64 chunksize;
+	f64 maxerr; // absolute error bound the lossy codec held to
+	u64 flags;
+};
+
+struct codecjob_t {
+	int codec;
+	f64 maxerr;
+	u8 *dst;
+	u8 *src;
+	u8 *ref;      // previous frame (see codec_encode), or NULL
+	int delta;    // coded as a delta from ref
+	size_t rawsize;
+	u64 chunks;
+	u64 *sizes;   // encoded size of each chunk
+	u64 *offsets; // where each chunk goes (encoding) or comes from (decoding)
+	int thread, threads;
+	int rc;
+};
+
+/* codec_chunkbound : most bytes a chunk of len raw bytes can encode to */
+static size_t codec_chunkbound(int codec, size_t len)
+{
+	// every plane costs a byte or two on top of its data (two for an empty
+	// one), and the lossy codec can end up with every value escaped as well
+	if (codec == CODEC_LOSSY) {
+		return 2 * len + 24;
+	}
+
+	return len + 16;
+}
+
+/* rans_normalize : scales the symbol counts so the frequencies sum to RANS_SCALE */
+static void rans_normalize(u32 *count, u16 *freq, size_t n)
+{
+	u32 sum, take;
+	int i, best;
+
+	for (i = 0, sum = 0; i < 256; i++) {
+		freq[i] = 0;
+		if (count[i]) {
+			freq[i] = ((u64)count[i] * RANS_SCALE) / n;
+			if (freq[i] == 0) {
+				freq[i] = 1; // every symbol we see needs a slot
+			}
+		}
+		sum += freq[i];
+	}
+
+	// give the error to (or take it from) the most common symbols
+	while (sum != RANS_SCALE) {
+		for (i = 1, best = 0; i < 256; i++) {
+			if (freq[best] < freq[i]) {
+				best = i;
+			}
+		}
+
+		if (sum < RANS_SCALE) {
+			freq[best] += RANS_SCALE - sum;
+			sum = RANS_SCALE;
+		} else {
+			take = sum - RANS_SCALE;
+			if (freq[best] - 1 < take) {
+				take = freq[best] - 1;
+			}
+			freq[best] -= take;
+			sum -= take;
+		}
+	}
+}
+
+/* rans_encode : codes n bytes from in, returns the coded length, 0 if it didn't fit */
+static size_t rans_encode(u8 *out, size_t outlen, u8 *in, size_t n, u16 *freq)
+{
+	u32 cum[256], x, xmax, f;
+	size_t i, len;
+	u8 *p;
+	int s;
+
+	for (s = 0, x = 0; s < 256; s++) {
+		cum[s] = x;
+		x += freq[s];
+	}
+
+	// rANS is last in, first out, so we code backwards from the end of out
+	x = RANS_L;
+	p = out + outlen;
+
+	for (i = n; i-- > 0;) {
+		s = in[i];
+		f = freq[s];
+
+		xmax = ((RANS_L >> RANS_SCALEBITS) << 8) * f;
+		while (x >= xmax) {
+			if (p == out) {
+				return 0;
+			}
+			*--p = x & 0xff;
+			x >>= 8;
+		}
+
+		x = ((x / f) << RANS_SCALEBITS) + (x % f) + cum[s];
+	}
+
+	if (p - out < 4) {
+		return 0;
+	}
+
+	p -= 4;
+	p[0] = x >>  0;
+	p[1] = x >>  8;
+	p[2] = x >> 16;
+	p[3] = x >> 24;
+
+	len = out + outlen - p;
+	memmove(out, p, len);
+
+	return len;
+}
+
+/* rans_decode : decodes n bytes into out */
+static int rans_decode(u8 *out, size_t n, u8 *in, size_t inlen, u16 *freq)
+{
+	u8 sym[RANS_SCALE];
+	u32 cum[256], x, slot;
+	u8 *end;
+	size_t i;
+	int s;
+
+	for (s = 0, x = 0; s < 256; s++) {
+		cum[s] = x;
+		x += freq[s];
+	}
+
+	if (x != RANS_SCALE || inlen < 4) {
+		return -1;
+	}
+
+	for (s = 0; s < 256; s++) {
+		memset(sym + cum[s], s, freq[s]);
+	}
+
+	end = in + inlen;
+
+	x = in[0] | (u32)in[1] << 8 | (u32)in[2] << 16 | (u32)in[3] << 24;
+	in += 4;
+
+	for (i = 0; i < n; i++) {
+		slot = x & (RANS_SCALE - 1);
+		s = sym[slot];
+
+		out[i] = s;
+
+		x = freq[s] * (x >> RANS_SCALEBITS) + slot - cum[s];
+		while (x < RANS_L) {
+			if (in == end) {
+				return -1;
+			}
+			x = (x << 8) | *in++;
+		}
+	}
+
+	return 0;
+}
+
+/* codec_putplane : codes a byte plane into out, returns the bytes used */
+static size_t codec_putplane(u8 *out, u8 *plane, size_t n, u8 *work)
+{
+	u32 count[256];
+	u16 freq[256];
+	size_t i, len;
+	int s;
+
+	memset(count, 0, sizeof(count));
+	for (i = 0; i < n; i++) {
+		count[plane[i]]++;
+	}
+
+	if (n == 0 || count[plane[0]] == n) {
+		out[0] = PLANE_CONST;
+		out[1] = n ? plane[0] : 0;
+		return 2;
+	}
+
+	rans_normalize(count, freq, n);
+
+	// the rANS stream is only worth it if it, and its table, beat raw bytes
+	len = rans_encode(work, n, plane, n, freq);
+	if (len == 0 || n <= len + sizeof(freq) + sizeof(u32)) {
+		out[0] = PLANE_RAW;
+		memcpy(out + 1, plane, n);
+		return 1 + n;
+	}
+
+	out[0] = PLANE_RANS;
+	out++;
+
+	for (s = 0; s < 256; s++) {
+		out[2 * s + 0] = freq[s] >> 0;
+		out[2 * s + 1] = freq[s] >> 8;
+	}
+	out += sizeof(freq);
+
+	memcpy(out, &len, sizeof(u32));
+	out += sizeof(u32);
+
+	memcpy(out, work, len);
+
+	return 1 + sizeof(freq) + sizeof(u32) + len;
+}
+
+/* codec_getplane : decodes a byte plane from in, returns the bytes consumed, 0 on error */
+static size_t codec_getplane(u8 *plane, size_t n, u8 *in, size_t inlen)
+{
+	u16 freq[256];
+	u32 len;
+	int s;
+
+	if (inlen < 1) {
+		return 0;
+	}
+
+	switch (in[0]) {
+	case PLANE_CONST:
+		if (inlen < 2) {
+			return 0;
+		}
+		memset(plane, in[1], n);
+		return 2;
+
+	case PLANE_RAW:
+		if (inlen < 1 + n) {
+			return 0;
+		}
+		memcpy(plane, in + 1, n);
+		return 1 + n;
+
+	case PLANE_RANS:
+		if (inlen < 1 + sizeof(freq) + sizeof(u32)) {
+			return 0;
+		}
+
+		for (s = 0; s < 256; s++) {
+			freq[s] = in[1 + 2 * s] | in[2 + 2 * s] << 8;
+		}
+
+		memcpy(&len, in + 1 + sizeof(freq), sizeof(u32));
+
+		in += 1 + sizeof(freq) + sizeof(u32);
+		inlen -= 1 + sizeof(freq) + sizeof(u32);
+
+		if (inlen < len || rans_decode(plane, n, in, len, freq) < 0) {
+			return 0;
+		}
+
+		return 1 + sizeof(freq) + sizeof(u32) + len;
+
+	default:
+		return 0;
+	}
+}
+
+/* codec_putplanes : codes all 8 byte planes of n words, returns the bytes used */
+static size_t codec_putplanes(u8 *dst, u8 *planes, size_t n, u8 *work)
+{
+	size_t used;
+	int b;
+
+	for (b = 0, used = 0; b < 8; b++) {
+		used += codec_putplane(dst + used, planes + b * n, n, work);
+	}
+
+	return used;
+}
+
+/* codec_getplanes : decodes all 8 byte planes of n words, returns the bytes used, 0 on error */
+static size_t codec_getplanes(u8 *planes, size_t n, u8 *src, size_t srclen)
+{
+	size_t used, rc;
+	int b;
+
+	for (b = 0, used = 0; b < 8; b++) {
+		rc = codec_getplane(planes + b * n, n, src + used, srclen - used);
+		if (rc == 0) {
+			return 0;
+		}
+		used += rc;
+	}
+
+	return used;
+}
+
+/* codec_getword : puts word i back together from the byte planes */
+static u64 codec_getword(u8 *planes, size_t n, size_t i)
+{
+	u64 word;
+	int b;
+
+	for (b = 0, word = 0; b < 8; b++) {
+		word |= (u64)planes[b * n + i] << (8 * b);
+	}
+
+	return word;
+}
+
+/* codec_putword : splits word i out into the byte planes */
+static void codec_putword(u8 *planes, size_t n, size_t i, u64 word)
+{
+	int b;
+
+	for (b = 0; b < 8; b++) {
+		planes[b * n + i] = word >> (8 * b);
+	}
+}
+
+/* codec_ordered : maps an f64's bits to an integer that sorts the same way the f64 does */
+static u64 codec_ordered(f64 v)
+{
+	u64 word;
+
+	memcpy(&word, &v, sizeof(word));
+
+	return word >> 63 ? ~word : word | 1ull << 63;
+}
+
+/* codec_unordered : undoes codec_ordered */
+static f64 codec_unordered(u64 word)
+{
+	f64 v;
+
+	word = word >> 63 ? word & ~(1ull << 63) : ~word;
+	memcpy(&v, &word, sizeof(v));
+
+	return v;
+}
+
+/* codec_deltapred : predicts a value from its reference, and the changes in the two before it */
+static f64 codec_deltapred(f64 p0, f64 d1, f64 d2)
+{
+	f64 pred;
+
+	pred = p0 + (d1 + (d1 - d2));
+
+	// a NaN's bits aren't the same everywhere, and those have to match exactly
+	return isfinite(pred) ? pred : 0;
+}
+
+/* codec_lossless_encode : encodes len raw bytes from src, returns the encoded size */
+static size_t codec_lossless_encode(u8 *dst, u8 *src, size_t len, u8 *ref, int delta, u8 *planes, u8 *work)
+{
+	u64 word, prev;
+	f64 v, p0, d1, d2;
+	size_t i, n, used;
+
+	n = len / sizeof(u64);
+
+	// predict each value from its neighbour, and split the residuals into planes
+	for (i = 0, prev = 0; i < n && !delta; i++) {
+		memcpy(&word, src + i * sizeof(u64), sizeof(u64));
+		codec_putword(planes, n, i, word ^ prev);
+		prev = word;
+	}
+
+	// a delta's residual is how far off its prediction is, counted in f64s
+	for (i = 0, d1 = d2 = 0; i < n && delta; i++) {
+		memcpy(&v, src + i * sizeof(f64), sizeof(f64));
+		memcpy(&p0, ref + i * sizeof(f64), sizeof(f64));
+
+		word = codec_ordered(v) - codec_ordered(codec_deltapred(p0, d1, d2));
+		codec_putword(planes, n, i, word << 1 ^ (u64)((s64)word >> 63));
+
+		d2 = d1;
+		d1 = v - p0;
+	}
+
+	// nothing's lost, so what decodes is exactly what came in
+	if (ref != NULL) {
+		memcpy(ref, src, len);
+	}
+
+	used = codec_putplanes(dst, planes, n, work);
+
+	// the odd bytes at the end of a lump that isn't all f64s go as they are
+	memcpy(dst + used, src + n * sizeof(u64), len - n * sizeof(u64));
+	used += len - n * sizeof(u64);
+
+	return used;
+}
+
+/* codec_lossless_decode : decodes a chunk of len raw bytes into dst */
+static int codec_lossless_decode(u8 *dst, size_t len, u8 *src, size_t srclen, u8 *ref, u8 *planes)
+{
+	u64 prev, code;
+	f64 v, p0, d1, d2;
+	size_t i, n, used;
+
+	n = len / sizeof(u64);
+
+	used = codec_getplanes(planes, n, src, srclen);
+	if (used == 0 || srclen - used != len - n * sizeof(u64)) {
+		return -1;
+	}
+
+	for (i = 0, prev = 0; i < n && ref == NULL; i++) {
+		prev ^= codec_getword(planes, n, i);
+		memcpy(dst + i * sizeof(u64), &prev, sizeof(u64));
+	}
+
+	for (i = 0, d1 = d2 = 0; i < n && ref != NULL; i++) {
+		memcpy(&p0, ref + i * sizeof(f64), sizeof(f64));
+
+		code = codec_getword(planes, n, i);
+		v = codec_unordered(codec_ordered(codec_deltapred(p0, d1, d2)) + ((code >> 1) ^ -(code & 1)));
+		memcpy(dst + i * sizeof(f64), &v, sizeof(f64));
+
+		d2 = d1;
+		d1 = v - p0;
+	}
+
+	memcpy(dst + n * sizeof(u64), src + used, len - n * sizeof(u64));
+
+	return 0;
+}
+
+/* codec_lossy_step : the quantization step for the given error bound */
+static f64 codec_lossy_step(f64 maxerr)
+{
+	int e;
+
+	/*
+	 * NOTE
+	 * The step is the biggest power of two that's at most twice the bound.
+	 * With a power of two, q * step is exact, so pred + q * step rounds the
+	 * same way whether or not the compiler fuses it into an FMA, and a file
+	 * written on one machine decodes to the same bits on any other. The
+	 * predictor has no multiply in it for the same reason.
+	 */
+
+	frexp(2 * maxerr, &e);
+
+	return ldexp(1.0, e - 1);
+}
+
+/* codec_lossy_encode : quantizes len raw bytes from src, returns the encoded size */
+static size_t codec_lossy_encode(u8 *dst, u8 *src, size_t len, f64 maxerr, u8 *ref, int delta, u8 *planes, u8 *work, f64 *escapes)
+{
+	f64 v, pred, recon, r1, r2, p0, d1, d2, step, d;
+	u64 code, nesc;
+	size_t i, n, used;
+	s64 q;
+
+	n = len / sizeof(u64);
+	step = codec_lossy_step(maxerr);
+
+	for (i = 0, nesc = 0, r1 = r2 = d1 = d2 = 0; i < n; i++) {
+		memcpy(&v, src + i * sizeof(f64), sizeof(f64));
+
+		if (delta) {
+			memcpy(&p0, ref + i * sizeof(f64), sizeof(f64));
+			pred = codec_deltapred(p0, d1, d2);
+		} else {
+			pred = r1 + (r1 - r2);
+		}
+
+		// code 0 is an escape, otherwise it's the zigzagged step count, plus 1
+		code = 0;
+
+		d = (v - pred) / step;
+		if (fabs(d) < LOSSY_MAXQ) { // false for NaNs and infinities too
+			q = llround(d);
+			recon = pred + q * step;
+			if (fabs(recon - v) <= maxerr) {
+				code = ((u64)q << 1 ^ (u64)(q >> 63)) + 1;
+			}
+		}
+
+		if (code == 0) {
+			escapes[nesc++] = v;
+			recon = v;
+		}
+
+		codec_putword(planes, n, i, code);
+
+		// the reference for the next frame is this one as it'll decode
+		if (ref != NULL) {
+			memcpy(ref + i * sizeof(f64), &recon, sizeof(f64));
+		}
+
+		if (delta) {
+			d2 = d1;
+			d1 = recon - p0;
+		}
+
+		r2 = r1;
+		r1 = recon;
+	}
+
+	used = codec_putplanes(dst, planes, n, work);
+
+	memcpy(dst + used, &nesc, sizeof(nesc));
+	used += sizeof(nesc);
+
+	memcpy(dst + used, escapes, nesc * sizeof(f64));
+	used += nesc * sizeof(f64);
+
+	memcpy(dst + used, src + n * sizeof(u64), len - n * sizeof(u64));
+	used += len - n * sizeof(u64);
+
+	if (ref != NULL) {
+		memcpy(ref + n * sizeof(u64), src + n * sizeof(u64), len - n * sizeof(u64));
+	}
+
+	return used;
+}
+
+/* codec_lossy_decode : decodes a chunk of len raw bytes into dst */
+static int codec_lossy_decode(u8 *dst, size_t len, u8 *src, size_t srclen, f64 maxerr, u8 *ref, u8 *planes)
+{
+	f64 pred, recon, r1, r2, p0, d1, d2, step;
+	u64 code, nesc, esc;
+	size_t i, n, used;
+	s64 q;
+
+	n = len / sizeof(u64);
+	step = codec_lossy_step(maxerr);
+
+	used = codec_getplanes(planes, n, src, srclen);
+	if (used == 0 || srclen - used < sizeof(nesc)) {
+		return -1;
+	}
+
+	memcpy(&nesc, src + used, sizeof(nesc));
+	used += sizeof(nesc);
+
+	if (n < nesc || srclen - used != nesc * sizeof(f64) + len - n * sizeof(u64)) {
+		return -1;
+	}
+
+	for (i = 0, esc = 0, r1 = r2 = d1 = d2 = 0; i < n; i++) {
+		if (ref != NULL) {
+			memcpy(&p0, ref + i * sizeof(f64), sizeof(f64));
+			pred = codec_deltapred(p0, d1, d2);
+		} else {
+			pred = r1 + (r1 - r2);
+		}
+
+		code = codec_getword(planes, n, i);
+
+		if (code == 0) {
+			if (esc == nesc) {
+				return -1;
+			}
+			memcpy(&recon, src + used + esc++ * sizeof(f64), sizeof(f64));
+		} else {
+			code--;
+			q = (s64)(code >> 1) ^ -(s64)(code & 1);
+			recon = pred + q * step;
+		}
+
+		memcpy(dst + i * sizeof(f64), &recon, sizeof(f64));
+
+		if (ref != NULL) {
+			d2 = d1;
+			d1 = recon - p0;
+		}
+
+		r2 = r1;
+		r1 = recon;
+	}
+
+	used += nesc * sizeof(f64);
+
+	memcpy(dst + n * sizeof(u64), src + used, len - n * sizeof(u64));
+
+	return 0;
+}
+
+/* codec_chunklen : returns the raw length of chunk i */
+static size_t codec_chunklen(size_t rawsize, u64 i)
+{
+	size_t off;
+
+	off = i * CODEC_CHUNK;
+
+	return rawsize - off < CODEC_CHUNK ? rawsize - off : CODEC_CHUNK;
+}
+
+/* codec_encodethread : encodes every chunk belonging to this thread */
+static void *codec_encodethread(void *arg)
+{
+	struct codecjob_t *job;
+	u8 *planes, *work, *dst, *src, *ref;
+	f64 *escapes;
+	size_t len;
+	u64 i;
+
+	job = arg;
+
+	planes = malloc(CODEC_CHUNK);
+	work = malloc(CODEC_CHUNK);
+	escapes = malloc(CODEC_CHUNK);
+
+	if (planes == NULL || work == NULL || escapes == NULL) {
+		job->rc = -1;
+	}
+
+	for (i = job->thread; job->rc == 0 && i < job->chunks; i += job->threads) {
+		len = codec_chunklen(job->rawsize, i);
+		dst = job->dst + job->offsets[i];
+		src = job->src + i * CODEC_CHUNK;
+		ref = job->ref == NULL ? NULL : job->ref + i * CODEC_CHUNK;
+
+		if (job->codec == CODEC_LOSSY) {
+			job->sizes[i] = codec_lossy_encode(dst, src, len, job->maxerr, ref, job->delta, planes, work, escapes);
+		} else {
+			job->sizes[i] = codec_lossless_encode(dst, src, len, ref, job->delta, planes, work);
+		}
+	}
+
+	free(planes);
+	free(work);
+	free(escapes);
+
+	return NULL;
+}
+
+/* codec_decodethread : decodes every chunk belonging to this thread */
+static void *codec_decodethread(void *arg)
+{
+	struct codecjob_t *job;
+	u8 *planes, *dst, *src, *ref;
+	size_t len;
+	u64 i;
+	int rc;
+
+	job = arg;
+
+	planes = malloc(CODEC_CHUNK);
+	if (planes == NULL) {
+		job->rc = -1;
+	}
+
+	for (i = job->thread; job->rc == 0 && i < job->chunks; i += job->threads) {
+		len = codec_chunklen(job->rawsize, i);
+		dst = job->dst + i * CODEC_CHUNK;
+		src = job->src + job->offsets[i];
+		ref = job->delta ? job->ref + i * CODEC_CHUNK : NULL;
+
+		if (job->codec == CODEC_LOSSY) {
+			rc = codec_lossy_decode(dst, len, src, job->sizes[i], job->maxerr, ref, planes);
+		} else {
+			rc = codec_lossless_decode(dst, len, src, job->sizes[i], ref, planes);
+		}
+
+		if (rc < 0) {
+			job->rc = -1;
+		}
+	}
+
+	free(planes);
+
+	return NULL;
+}
+
+/* codec_run : runs func over the chunks on as many threads as make sense */
+static int codec_run(struct codecjob_t *proto, void *(*func)(void *arg))
+{
+	struct codecjob_t *jobs;
+	struct sys_thread **threads;
+	int i, n, rc;
+
+	n = sys_numcores();
+	if (proto->chunks < n) {
+		n = proto->chunks;
+	}
+
+	if (n <= 1) { // not worth a thread
+		proto->thread = 0;
+		proto->threads = 1;
+		proto->rc = 0;
+		func(proto);
+		return proto->rc;
+	}
+
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	if (jobs == NULL || threads == NULL) {
+		free(jobs);
+		free(threads);
+		return -1;
+	}
+
+	// every thread has its own share of the work, so if one doesn't start,
+	// the ones that did are waited on, and the whole thing fails
+	for (i = 0, rc = 0; i < n; i++) {
+		jobs[i] = *proto;
+		jobs[i].thread = i;
+		jobs[i].threads = n;
+		jobs[i].rc = 0;
+
+		threads[i] = sys_threadcreate();
+		if (threads[i] == NULL) {
+			rc = -1;
+			break;
+		}
+
+		sys_threadsetfunc(threads[i], func);
+		sys_threadsetarg(threads[i], &jobs[i]);
+
+		if (sys_threadstart(threads[i]) != 0) {
+			sys_threadfree(threads[i]);
+			threads[i] = NULL;
+			rc = -1;
+			break;
+		}
+	}
+
+	for (i = 0; i < n && threads[i]; i++) {
+		sys_threadwait(threads[i]);
+		sys_threadfree(threads[i]);
+		if (jobs[i].rc < 0) {
+			rc = -1;
+		}
+	}
+
+	free(jobs);
+	free(threads);
+
+	return rc;
+}
+
+/* codec_bound : returns the most bytes encoding srclen bytes can take */
+size_t codec_bound(int codec, size_t srclen)
+{
+	u64 chunks;
+
+	chunks = (srclen + CODEC_CHUNK - 1) / CODEC_CHUNK;
+
+	// a single chunk is only as big as the data
+	if (chunks <= 1) {
+		return sizeof(struct codechdr_t) + sizeof(u64) + codec_chunkbound(codec, srclen);
+	}
+
+	return sizeof(struct codechdr_t) + chunks * sizeof(u64) + chunks * codec_chunkbound(codec, CODEC_CHUNK);
+}
+
+/* codec_maxerr : works out the absolute error bound the lossy codec is held to */
+f64 codec_maxerr(struct codecparams_t *params, f64 *src, size_t n)
+{
+	f64 lo, hi;
+	size_t i;
+
+	if (params == NULL) {
+		return 0;
+	}
+
+	if (!params->relative) {
+		return params->tolerance;
+	}
+
+	// a relative bound is a fraction of the range of the (finite) values
+	for (i = 0, lo = INFINITY, hi = -INFINITY; i < n; i++) {
+		if (isfinite(src[i])) {
+			lo = src[i] < lo ? src[i] : lo;
+			hi = hi < src[i] ? src[i] : hi;
+		}
+	}
+
+	return lo < hi ? params->tolerance * (hi - lo) : 0;
+}
+
+/* codec_encode : encodes src into dst, returns the encoded size, 0 on failure */
+size_t codec_encode(int codec, struct codecparams_t *params, void *dst, size_t dstlen, void *src, size_t srclen, void *ref, int delta)
+{
+	struct codechdr_t hdr;
+	struct codecjob_t job;
+	f64 maxerr;
+	u8 *p;
+	size_t used;
+	u64 i;
+	int rc;
+
+	if (codec <= CODEC_NONE || CODEC_TOTAL <= codec || dstlen < codec_bound(codec, srclen)) {
+		return 0;
+	}
+
+	if (delta && ref == NULL) {
+		return 0;
+	}
+
+	maxerr = 0;
+
+	// without a usable error bound, there's nothing to be lossy with
+	if (codec == CODEC_LOSSY) {
+		maxerr = codec_maxerr(params, src, srclen / sizeof(f64));
+		if (!(0 < maxerr && isfinite(maxerr))) {
+			codec = CODEC_LOSSLESS;
+			maxerr = 0;
+		}
+	}
+
+	hdr.magic = CODEC_MAGIC;
+	hdr.codec = codec;
+	hdr.rawsize = srclen;
+	hdr.chunks = (srclen + CODEC_CHUNK - 1) / CODEC_CHUNK;
+	hdr.chunksize = CODEC_CHUNK;
+	hdr.maxerr = maxerr;
+	hdr.flags = delta ? CODEC_FLAG_DELTA : 0;
+
+	p = dst;
+
+	memset(&job, 0, sizeof(job));
+
+	job.codec = codec;
+	job.maxerr = maxerr;
+	job.dst = p + sizeof(hdr) + hdr.chunks * sizeof(u64);
+	job.src = src;
+	job.ref = ref;
+	job.delta = delta;
+	job.rawsize = srclen;
+	job.chunks = hdr.chunks;
+	job.sizes = (u64 *)(p + sizeof(hdr));
+	job.offsets = calloc(hdr.chunks + 1, sizeof(u64));
+	if (job.offsets == NULL) {
+		return 0;
+	}
+
+	// every chunk gets coded into its own worst case sized spot...
+	for (i = 0; i < hdr.chunks; i++) {
+		job.offsets[i] = i * codec_chunkbound(codec, CODEC_CHUNK);
+	}
+
+	rc = codec_run(&job, codec_encodethread);
+	if (rc < 0) {
+		free(job.offsets);
+		return 0;
+	}
+
+	// ...then they get packed down against each other
+	for (i = 0, used = 0; i < hdr.chunks; i++) {
+		memmove(job.dst + used, job.dst + job.offsets[i], job.sizes[i]);
+		used += job.sizes[i];
+	}
+
+	free(job.offsets);
+
+	memcpy(p, &hdr, sizeof(hdr));
+
+	return sizeof(hdr) + hdr.chunks * sizeof(u64) + used;
+}
+
+/* codec_decode : decodes src into dst, dstlen has to be the raw size */
+int codec_decode(void *dst, size_t dstlen, void *src, size_t srclen, void *ref)
+{
+	struct codechdr_t hdr;
+	struct codecjob_t job;
+	size_t used;
+	u64 i;
+	int rc;
+
+	if (srclen < sizeof(hdr)) {
+		return -1;
+	}
+
+	memcpy(&hdr, src, sizeof(hdr));
+
+	if (hdr.magic != CODEC_MAGIC || hdr.codec <= CODEC_NONE || CODEC_TOTAL <= hdr.codec) {
+		return -1;
+	}
+
+	if (hdr.rawsize != dstlen || hdr.chunksize != CODEC_CHUNK) {
+		return -1;
+	}
+
+	if ((hdr.flags & CODEC_FLAG_DELTA) && ref == NULL) {
+		return -1;
+	}
+
+	if (hdr.chunks != (dstlen + CODEC_CHUNK - 1) / CODEC_CHUNK) {
+		return -1;
+	}
+
+	if ((srclen - sizeof(hdr)) / sizeof(u64) < hdr.chunks) {
+		return -1;
+	}
+
+	memset(&job, 0, sizeof(job));
+
+	job.codec = hdr.codec;
+	job.maxerr = hdr.maxerr;
+	job.dst = dst;
+	job.src = (u8 *)src + sizeof(hdr) + hdr.chunks * sizeof(u64);
+	job.ref = ref;
+	job.delta = (hdr.flags & CODEC_FLAG_DELTA) != 0;
+	job.rawsize = dstlen;
+	job.chunks = hdr.chunks;
+	job.sizes = calloc(hdr.chunks + 1, sizeof(u64));
+	job.offsets = calloc(hdr.chunks + 1, sizeof(u64));
+
+	if (job.sizes == NULL || job.offsets == NULL) {
+		free(job.sizes);
+		free(job.offsets);
+		return -1;
+	}
+
+	memcpy(job.sizes, (u8 *)src + sizeof(hdr), hdr.chunks * sizeof(u64));
+
+	srclen -= sizeof(hdr) + hdr.chunks * sizeof(u64);
+
+	for (i = 0, used = 0; i < hdr.chunks; i++) {
+		if (srclen - used < job.sizes[i]) {
+			free(job.sizes);
+			free(job.offsets);
+			return -1;
+		}
+
+		job.offsets[i] = used;
+		used += job.sizes[i];
+	}
+
+	rc = codec_run(&job, codec_decodethread);
+
+	free(job.sizes);
+	free(job.offsets);
+
+	return rc;
+}
+
+/* codec_getinfo : reads back which codec encoded data used, its error bound and flags */
+int codec_getinfo(void *src, size_t srclen, int *codec, f64 *maxerr, u64 *flags)
+{
+	struct codechdr_t hdr;
+
+	if (srclen < sizeof(hdr)) {
+		return -1;
+	}
+
+	memcpy(&hdr, src, sizeof(hdr));
+
+	if (hdr.magic != CODEC_MAGIC) {
+		return -1;
+	}
+
+	*codec = hdr.codec;
+	*maxerr = hdr.maxerr;
+	*flags = hdr.flags;
+
+	return 0;
+}
+
+/* codec_fromstr : returns the codec with the given name, -1 if there isn't one */
+int codec_fromstr(char *s)
+{
+	int i;
+
+	for (i = 0; i < CODEC_TOTAL; i++) {
+		if (strcmp(s, codec_tostr(i)) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* codec_tostr : returns the name of the codec */
+char *codec_tostr(int codec)
+{
+	switch (codec) {
+	case CODEC_NONE:     return "none";
+	case CODEC_LOSSLESS: return "lossless";
+	case CODEC_LOSSY:    return "lossy";
+	default:             return "unknown";
+	}
+}
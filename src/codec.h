@@ -0,0 +1,62 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 01:51
+ *
+ * Lump Codecs
+ *
+ * Compression for the big f64 volume lumps. An encoded lump is a small header,
+ * the encoded size of every chunk, then the chunks themselves. Chunks are
+ * coded independently, so they get spread across all of the cores.
+ */
+
+#include "common.h"
+
+enum {
+	CODEC_NONE,
+	CODEC_LOSSLESS,
+	CODEC_LOSSY,
+	CODEC_TOTAL
+};
+
+#define CODEC_FLAG_DELTA 0x01 // coded as a delta from a reference frame
+
+struct codecparams_t {
+	f64 tolerance; // largest error CODEC_LOSSY is allowed to make
+	s32 relative;  // tolerance is a fraction of the lump's value range
+	s32 keyframe;  // every keyframe'th entry is coded on its own, the rest as deltas
+};
+
+/* codec_bound : returns the most bytes encoding srclen bytes can take */
+size_t codec_bound(int codec, size_t srclen);
+
+/* codec_encode : encodes src into dst, returns the encoded size, 0 on failure */
+size_t codec_encode(int codec, struct codecparams_t *params, void *dst, size_t dstlen, void *src, size_t srclen, void *ref, int delta);
+
+/*
+ * NOTE
+ * ref, if it isn't NULL, is srclen bytes that get overwritten with src as it
+ * will decode. With delta set, it has to hold the previous frame going in, and
+ * src gets coded as a difference from it. Decoding a delta needs that same
+ * previous frame (as decoded) passed in as ref; it's left alone.
+ */
+
+/* codec_decode : decodes src into dst, dstlen has to be the raw size */
+int codec_decode(void *dst, size_t dstlen, void *src, size_t srclen, void *ref);
+
+/* codec_maxerr : works out the absolute error bound the lossy codec is held to */
+f64 codec_maxerr(struct codecparams_t *params, f64 *src, size_t n);
+
+/* codec_getinfo : reads back which codec encoded data used, its error bound and flags */
+int codec_getinfo(void *src, size_t srclen, int *codec, f64 *maxerr, u64 *flags);
+
+/* codec_fromstr : returns the codec with the given name, -1 if there isn't one */
+int codec_fromstr(char *s);
+
+/* codec_tostr : returns the name of the codec */
+char *codec_tostr(int codec);
+
+#endif // CODEC_H
+
@@ -233,6 +233,8 @@ size_t strsplit(char **arr, size_t len, char *buf, char sep);
 size_t strlen_char(char *s, char c);
 /* bstrtok : Brian's (Better) strtok */
 char *bstrtok(char **str, char *delim);
+/* strtoks : strtok, but it keeps its place in *save, so threads don't trip over each other */
+char *strtoks(char *s, char *delim, char **save);
 /* strnullcmp : compare strings, sorting null values as "first" */
 int strnullcmp(const void *a, const void *b);
 /* strornull : returns the string representation of NULL if the string is */
@@ -492,6 +494,33 @@ char *bstrtok(char **str, char *delim)
 	return ret;
 }
 
+/* strtoks : strtok, but it keeps its place in *save, so threads don't trip over each other */
+char *strtoks(char *s, char *delim, char **save)
+{
+	char *tok;
+
+	if (s == NULL) {
+		s = *save;
+	}
+
+	s += strspn(s, delim);
+	if (*s == 0) {
+		*save = s;
+		return NULL;
+	}
+
+	tok = s;
+	s += strcspn(s, delim);
+
+	if (*s) {
+		*s++ = 0;
+	}
+
+	*save = s;
+
+	return tok;
+}
+
 /* streq : return true if the strings are equal */
 int streq(char *s, char *t)
 {
@@ -102,5 +102,55 @@
 
 #define MOLT_ALPHA MOLT_BETA / (MOLT_TISSUESPEED * MOLT_T_STEP * MOLT_INTSCALE)
 
+/* LUMP TAGS */
+
+#define MOLTSTR_CONFIG "CONFIG"
+#define MOLTSTR_VLX    "VLX"
+#define MOLTSTR_VRX    "VRX"
+#define MOLTSTR_VLY    "VLY"
+#define MOLTSTR_VRY    "VRY"
+#define MOLTSTR_VLZ    "VLZ"
+#define MOLTSTR_VRZ    "VRZ"
+#define MOLTSTR_WLX    "WLX"
+#define MOLTSTR_WRX    "WRX"
+#define MOLTSTR_WLY    "WLY"
+#define MOLTSTR_WRY    "WRY"
+#define MOLTSTR_WLZ    "WLZ"
+#define MOLTSTR_WRZ    "WRZ"
+#define MOLTSTR_VEL    "VEL"
+#define MOLTSTR_AMP    "AMP"
+#define MOLTSTR_TIME   "TIME"
+#define MOLTSTR_PROF   "PROFILE"
+#define MOLTSTR_CHKPT  "CHECKPNT"
+#define MOLTSTR_OUTPUT "OUTPUTS"
+
+/* CHECKPOINTS */
+
+// how many checkpoints are kept around when the config doesn't say
+#define MOLT_CHKPT_KEEP   2
+
+/* BRICKS */
+
+// edge length of a brick, when --rebrick isn't told one
+#define MOLT_BRICK_SIZE   32
+
+/* OUTPUTS */
+
+// stats and probe rows held in memory before they're written out as a lump
+#define MOLT_OUTPUT_ROWS  256
+
+/* LIVE FRAMES */
+
+// frames in the live ring, when the config doesn't say
+#define MOLT_LIVE_SLOTS   4
+
+// how often --watch looks for a new frame
+#define MOLT_LIVE_POLLMS  50
+
+/* TAIL */
+
+// how often --tail looks for new lumps
+#define MOLT_TAIL_POLLMS  100
+
 #endif // CONFIG_H
 
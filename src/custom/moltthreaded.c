@@ -34,6 +34,7 @@
 #include "thpool.h"
 
 #define DEFAULT_THREADS (5)
+#define JOBS_PER_THREAD (4) // rows are handed out in batches, this many per thread, so they even out
 
 // now we can actually define the functions that are going to be called
 // from the molt module
@@ -53,6 +54,8 @@ struct sweep_args_t {
 
 	s64 rowlen;
 	s32 orderm;
+
+	s64 rows; // how many rows, starting with this one, the job sweeps
 };
 
 struct reorg_args_t {
@@ -63,11 +66,17 @@ struct reorg_args_t {
 	cvec3_t dst_ord;
 	ivec3_t dim;
 	ivec3_t row;
+
+	s64 rows; // how many rows, starting with this one, the job moves
 };
 
 static threadpool g_pool;
 static struct sweep_args_t *g_sweepargs;
 static struct reorg_args_t *g_reorgargs;
+static s64 g_jobs; // how many jobs a sweep or a reorg is split into
+
+// where our jobs and waits go, when the run is being traced
+static void (*g_trace)(char *name, u64 start, u64 end);
 
 /* molt_custom_init : intializes the custom module */
 int molt_custom_open(struct molt_custom_t *custom)
@@ -89,6 +98,9 @@ int molt_custom_open(struct molt_custom_t *custom)
 
 	// testing the threading pool
 	g_pool = thpool_init(cores);
+	g_jobs = cores * JOBS_PER_THREAD;
+
+	g_trace = custom->func_trace;
 
 	// find the biggest dimension, and use that to know how many
 	// sweep args we're going to need
@@ -132,16 +144,47 @@ int molt_custom_close(struct molt_custom_t *custom)
 void molt_custom_sweep_work(void *arg)
 {
 	struct sweep_args_t *sargs;
+	s64 i, rows;
+	u64 start;
 
 	// NOTE (brian)
 	// this is exactly the same as the single threaded module's except for the
 	// fact that it's setup to be called from the threadpool
 
 	sargs = arg;
+	rows = sargs->rows;
+
+	start = g_trace ? sys_nanotime() : 0;
+
+	for (i = 0; i < rows; i++, sargs++) {
+		molt_gfquad_m(sargs->work, sargs->src, sargs->dnu, sargs->wl, sargs->wr, sargs->rowlen, sargs->orderm);
+		molt_makel(sargs->work, sargs->vl, sargs->vr, sargs->minval, sargs->rowlen);
+		memcpy(sargs->dst, sargs->work, sizeof(f64) * sargs->rowlen);
+	}
+
+	if (g_trace) {
+		g_trace("sweep job", start, sys_nanotime());
+	}
+}
+
+/* molt_custom_batch : how many rows go in each job, when there are rownum of them */
+static s64 molt_custom_batch(s64 rownum)
+{
+	return g_jobs < rownum ? (rownum + g_jobs - 1) / g_jobs : 1;
+}
+
+/* molt_custom_wait : waits on the pool, which is a span of its own when tracing */
+static void molt_custom_wait(void)
+{
+	u64 start;
 
-	molt_gfquad_m(sargs->work, sargs->src, sargs->dnu, sargs->wl, sargs->wr, sargs->rowlen, sargs->orderm);
-	molt_makel(sargs->work, sargs->vl, sargs->vr, sargs->minval, sargs->rowlen);
-	memcpy(sargs->dst, sargs->work, sizeof(f64) * sargs->rowlen);
+	start = g_trace ? sys_nanotime() : 0;
+
+	thpool_wait(g_pool);
+
+	if (g_trace) {
+		g_trace("thpool_wait", start, sys_nanotime());
+	}
 }
 
 /* molt_custom_sweep : performs a threaded sweep across the mesh in the dimension specified */
@@ -151,7 +194,7 @@ void molt_custom_sweep(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord,
 	f64 *wl, *wr;
 	f64 *vl, *vr;
 	f64 usednu;
-	s64 rowlen, rownum, i;
+	s64 rowlen, rownum, batch, i;
 
 	/*
 	 * NOTE (brian)
@@ -188,6 +231,8 @@ void molt_custom_sweep(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord,
 
 	memset(work, 0, sizeof(f64) * rowlen * rownum);
 
+	batch = molt_custom_batch(rownum);
+
 	// walk through the volume, grabbing each row-organized value
 	for (i = 0, ptr = src; i < rownum; i++, ptr += rowlen, work += rowlen) {
 		// we setup our arguments for 'molt_sweep_custom_work'
@@ -201,20 +246,23 @@ void molt_custom_sweep(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord,
 		g_sweepargs[i].rowlen = rowlen;
 		g_sweepargs[i].orderm = M;
 		g_sweepargs[i].dnu = usednu;
+	}
 
-		// then we add it to the thread queue
+	// then we add them to the thread queue, a batch of rows at a time
+	for (i = 0; i < rownum; i += batch) {
+		g_sweepargs[i].rows = rownum - i < batch ? rownum - i : batch;
 		thpool_add_work(g_pool, molt_custom_sweep_work, g_sweepargs + i);
 	}
 
-	thpool_wait(g_pool);
+	molt_custom_wait();
 }
 
 /* molt_custom_reorg_work : worker function for threaded transpose */
 void molt_custom_reorg_work(void *arg)
 {
 	struct reorg_args_t *reorgargs;
-	s64 i;
-	u64 src_i, dst_i;
+	s64 i, j, rows;
+	u64 src_i, dst_i, start;
 	ivec3_t tmpv;
 
 	/*
@@ -223,12 +271,21 @@ void molt_custom_reorg_work(void *arg)
 	 */
 
 	reorgargs = arg;
+	rows = reorgargs->rows;
+
+	start = g_trace ? sys_nanotime() : 0;
 
-	for (i = 0; i < reorgargs->dim[0]; i++) {
-		Vec3Set(tmpv, i, reorgargs->row[1], reorgargs->row[2]);
-		src_i = molt_genericidx(tmpv, reorgargs->dim, reorgargs->src_ord);
-		dst_i = molt_genericidx(tmpv, reorgargs->dim, reorgargs->dst_ord);
-		reorgargs->work[dst_i] = reorgargs->src[src_i];
+	for (j = 0; j < rows; j++, reorgargs++) {
+		for (i = 0; i < reorgargs->dim[0]; i++) {
+			Vec3Set(tmpv, i, reorgargs->row[1], reorgargs->row[2]);
+			src_i = molt_genericidx(tmpv, reorgargs->dim, reorgargs->src_ord);
+			dst_i = molt_genericidx(tmpv, reorgargs->dim, reorgargs->dst_ord);
+			reorgargs->work[dst_i] = reorgargs->src[src_i];
+		}
+	}
+
+	if (g_trace) {
+		g_trace("reorg job", start, sys_nanotime());
 	}
 }
 
@@ -250,27 +307,36 @@ void molt_custom_reorg(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_o
 	 * and dst_ord may not be 'actual' x, y, or z.
 	 */
 
-	s64 i, j;
+	struct reorg_args_t *args;
+	s64 i, j, rownum, batch;
 
 	memset(work, 0, sizeof(*work) * dim[0] * dim[1] * dim[2]);
 
+	rownum = dim[1] * dim[2];
+	batch = molt_custom_batch(rownum);
+
+	// every row gets its own arguments, the workers are still reading the others
 	for (i = 0; i < dim[1]; i++) {
 		for (j = 0; j < dim[2]; j++) {
 			// we setup our arguments for 'molt_reorg_custom_work'
-			g_reorgargs[i].src  = src;
-			g_reorgargs[i].dst  = dst;
-			g_reorgargs[i].work = work;
-			Vec3Copy(g_reorgargs[i].src_ord, src_ord);
-			Vec3Copy(g_reorgargs[i].dst_ord, dst_ord);
-			Vec3Copy(g_reorgargs[i].dim, dim);
-			Vec3Set(g_reorgargs[i].row, 0, i, j);
-
-			// then we add it to the thread queue
-			thpool_add_work(g_pool, molt_custom_reorg_work, g_reorgargs + i);
+			args = g_reorgargs + i * dim[2] + j;
+			args->src  = src;
+			args->dst  = dst;
+			args->work = work;
+			Vec3Copy(args->src_ord, src_ord);
+			Vec3Copy(args->dst_ord, dst_ord);
+			Vec3Copy(args->dim, dim);
+			Vec3Set(args->row, 0, i, j);
 		}
 	}
 
-	thpool_wait(g_pool);
+	// then we add them to the thread queue, a batch of rows at a time
+	for (i = 0; i < rownum; i += batch) {
+		g_reorgargs[i].rows = rownum - i < batch ? rownum - i : batch;
+		thpool_add_work(g_pool, molt_custom_reorg_work, g_reorgargs + i);
+	}
+
+	molt_custom_wait();
 
 	memcpy(dst, work, sizeof(f64) * dim[0] * dim[1] * dim[2]);
 }
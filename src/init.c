@@ -0,0 +1,474 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 02:57
+ *
+ * Analytic Initial Conditions
+ *
+ * The volume is split into z slabs, one per thread. Each thread multiplies its
+ * plane's z factor into the y factors, then every row is that times the x
+ * factors, which is a loop the compiler can vectorize on its own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "sys.h"
+#include "init.h"
+
+#define INIT_TWOPI 6.283185307179586
+
+struct initjob_t {
+	f64 *vol;
+	f64 *factor[3];
+	ivec3_t dim;
+	s32 zstart;
+	s32 zstop;
+};
+
+struct resamplejob_t {
+	f64 *src;
+	f64 *vol;
+	ivec3_t dim;
+	ivec3_t stride;  // the source's strides, along x, y and z
+	s64 *index[3];   // per destination point on each axis, the source point at or before it
+	f64 *frac[3];    // and how far it is towards the next one
+	s32 zstart;
+	s32 zstop;
+};
+
+static char *g_kinds[] = {
+	"gaussian", "planewave", "point"
+};
+
+/* init_parseaxis : parses "x", "y" or "z", returns the axis, -1 if it isn't one */
+static int init_parseaxis(char *s)
+{
+	if ('x' <= s[0] && s[0] <= 'z' && s[1] == 0) {
+		return s[0] - 'x';
+	}
+
+	return -1;
+}
+
+/* init_parse : parses an initializer, returns 1 if it is one, 0 if it isn't (it's a command), -1 if it's broken */
+int init_parse(struct initfunc_t *init, char *s)
+{
+	char buf[BUFSMALL];
+	char *tok, *val, *save;
+	int axis, n;
+
+	memset(init, 0, sizeof(*init));
+
+	if (s == NULL) {
+		return 0;
+	}
+
+	strncpy(buf, s, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+
+	tok = strtoks(buf, " \t", &save);
+	if (tok == NULL) {
+		return 0;
+	}
+
+	for (init->kind = 0; init->kind < INIT_TOTAL; init->kind++) {
+		if (strcmp(tok, g_kinds[init->kind]) == 0) {
+			break;
+		}
+	}
+
+	if (init->kind == INIT_TOTAL) {
+		return 0;
+	}
+
+	// the same pulse as experiments/test, exp(-13 * sum (2 s - 1)^2)
+	init->amp = 1;
+	init->width = 1 / sqrt(52);
+	init->wavelength = 1;
+	Vec3Set(init->center, 0.5, 0.5, 0.5);
+
+	while ((tok = strtoks(NULL, " \t", &save)) != NULL) {
+		val = strchr(tok, '=');
+		if (val == NULL) {
+			return -1;
+		}
+
+		*val++ = 0;
+		n = -1;
+
+		if (strcmp(tok, "amp") == 0) {
+			sscanf(val, "%lf%n", &init->amp, &n);
+		} else if (strcmp(tok, "width") == 0 && init->kind == INIT_GAUSSIAN) {
+			sscanf(val, "%lf%n", &init->width, &n);
+		} else if (strcmp(tok, "center") == 0 && init->kind != INIT_PLANEWAVE) {
+			sscanf(val, "%lf,%lf,%lf%n", &init->center[0], &init->center[1], &init->center[2], &n);
+		} else if (strcmp(tok, "wavelength") == 0 && init->kind == INIT_PLANEWAVE) {
+			sscanf(val, "%lf%n", &init->wavelength, &n);
+		} else if (strcmp(tok, "phase") == 0 && init->kind == INIT_PLANEWAVE) {
+			sscanf(val, "%lf%n", &init->phase, &n);
+		} else if (strcmp(tok, "axis") == 0 && init->kind == INIT_PLANEWAVE) {
+			init->axis = init_parseaxis(val);
+			n = init->axis < 0 ? -1 : (int)strlen(val);
+		} else if (strcmp(tok, "travel") == 0 && init->kind != INIT_POINT) {
+			if (val[0] == '+' || val[0] == '-') {
+				axis = init_parseaxis(val + 1);
+				init->travel = (val[0] == '-' ? -1 : 1) * (axis + 1);
+			} else {
+				axis = init_parseaxis(val);
+				init->travel = axis + 1;
+			}
+			n = axis < 0 ? -1 : (int)strlen(val);
+		}
+
+		if (n < 0 || val[n]) {
+			return -1;
+		}
+	}
+
+	if (!(0 < init->width) || !(0 < init->wavelength)) {
+		return -1;
+	}
+
+	return 1;
+}
+
+/* init_factors : works out the one dimensional factors, the first axis gets amp */
+static void init_factors(struct initfunc_t *init, f64 *factor[3], ivec3_t dim, f64 scale, f64 c)
+{
+	f64 s, d, ds, k;
+	s32 i, j, axis, sign;
+
+	/*
+	 * NOTE
+	 * Traveling, the wave is u(x - sign c t e_axis), so du/dt at t = 0 is just
+	 * -sign c du/dx along that axis. Only that axis' factor depends on it, so
+	 * it gets swapped for its own derivative (with respect to space, not to the
+	 * fraction of the domain, hence ds), and the rest stay as they were.
+	 */
+
+	axis = init->travel ? abs(init->travel) - 1 : -1;
+	sign = init->travel < 0 ? -1 : 1;
+
+	for (j = 0; j < 3; j++) {
+		ds = 1.0 / (dim[j] * scale);
+
+		for (i = 0; i < dim[j]; i++) {
+			s = (f64)i / dim[j];
+
+			switch (init->kind) {
+			case INIT_GAUSSIAN:
+				d = s - init->center[j];
+				factor[j][i] = exp(-d * d / (init->width * init->width));
+				if (j == axis) {
+					factor[j][i] *= -sign * c * (-2 * d / (init->width * init->width)) * ds;
+				}
+				break;
+
+			case INIT_PLANEWAVE:
+				k = INIT_TWOPI / init->wavelength;
+				if (j == init->axis) {
+					factor[j][i] = sin(k * s + init->phase);
+					if (j == axis) {
+						factor[j][i] = -sign * c * k * cos(k * s + init->phase) * ds;
+					}
+				} else {
+					factor[j][i] = j == axis ? 0 : 1; // the wave doesn't change along this axis
+				}
+				break;
+
+			case INIT_POINT:
+				// the closest point, which is at least in the volume
+				d = floor(init->center[j] * dim[j] + 0.5);
+				d = d < 0 ? 0 : dim[j] - 1 < d ? dim[j] - 1 : d;
+				factor[j][i] = i == (s32)d ? 1 : 0;
+				break;
+			}
+
+			if (j == 0) {
+				factor[j][i] *= init->amp;
+			}
+		}
+	}
+}
+
+/* init_thread : fills one job's slab of z planes */
+static void *init_thread(void *arg)
+{
+	struct initjob_t *job;
+	f64 *row, *plane;
+	s32 x, y, z;
+
+	job = arg;
+
+	plane = calloc(job->dim[1], sizeof(f64));
+
+	for (z = job->zstart; z < job->zstop; z++) {
+		for (y = 0; y < job->dim[1]; y++) {
+			plane[y] = job->factor[2][z] * job->factor[1][y];
+		}
+
+		for (y = 0; y < job->dim[1]; y++) {
+			row = job->vol + ((u64)z * job->dim[1] + y) * job->dim[0];
+			for (x = 0; x < job->dim[0]; x++) {
+				row[x] = plane[y] * job->factor[0][x];
+			}
+		}
+	}
+
+	free(plane);
+
+	return NULL;
+}
+
+/* init_fill : evaluates the initializer over a dim volume, with points scale apart, and waves moving at speed c */
+int init_fill(struct initfunc_t *init, f64 *vol, ivec3_t dim, f64 scale, f64 c)
+{
+	struct initjob_t *jobs;
+	struct sys_thread **threads;
+	f64 *factor[3];
+	int i, n;
+
+	if (init->kind < 0 || INIT_TOTAL <= init->kind || dim[0] < 1 || dim[1] < 1 || dim[2] < 1) {
+		return -1;
+	}
+
+	for (i = 0; i < 3; i++) {
+		factor[i] = calloc(dim[i], sizeof(f64));
+	}
+
+	init_factors(init, factor, dim, scale, c);
+
+	n = sys_numcores();
+	if (dim[2] < n) {
+		n = dim[2];
+	}
+	if (n < 1) {
+		n = 1;
+	}
+
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	for (i = 0; i < n; i++) {
+		jobs[i].vol = vol;
+		memcpy(jobs[i].factor, factor, sizeof(factor));
+		Vec3Copy(jobs[i].dim, dim);
+
+		// contiguous slabs, so the pages each thread touches first are its own
+		jobs[i].zstart = (s32)((s64)dim[2] * i / n);
+		jobs[i].zstop = (s32)((s64)dim[2] * (i + 1) / n);
+
+		threads[i] = sys_threadcreate();
+		sys_threadsetfunc(threads[i], init_thread);
+		sys_threadsetarg(threads[i], &jobs[i]);
+		sys_threadstart(threads[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		sys_threadwait(threads[i]);
+		sys_threadfree(threads[i]);
+	}
+
+	free(jobs);
+	free(threads);
+
+	for (i = 0; i < 3; i++) {
+		free(factor[i]);
+	}
+
+	return 0;
+}
+
+/* init_resamplethread : fills one job's slab of z planes */
+static void *init_resamplethread(void *arg)
+{
+	struct resamplejob_t *job;
+	f64 *src, *dst, v[4], fx, fy, fz;
+	s64 *ix, *iy, *iz;
+	u64 base, sx, sy, sz, i;
+	s32 x, y, z;
+	int c;
+
+	job = arg;
+
+	src = job->src;
+
+	ix = job->index[0];
+	iy = job->index[1];
+	iz = job->index[2];
+
+	for (z = job->zstart; z < job->zstop; z++) {
+		for (y = 0; y < job->dim[1]; y++) {
+			dst = job->vol + ((u64)z * job->dim[1] + y) * job->dim[0];
+
+			for (x = 0; x < job->dim[0]; x++) {
+				base = ix[x] * job->stride[0] + iy[y] * job->stride[1] + iz[z] * job->stride[2];
+
+				fx = job->frac[0][x];
+				fy = job->frac[1][y];
+				fz = job->frac[2][z];
+
+				if (fx == 0 && fy == 0 && fz == 0) {
+					dst[x] = src[base];
+					continue;
+				}
+
+				// only step towards the next point when it's actually weighed in,
+				// the last point on an axis doesn't have one
+				sx = fx == 0 ? 0 : job->stride[0];
+				sy = fy == 0 ? 0 : job->stride[1];
+				sz = fz == 0 ? 0 : job->stride[2];
+
+				for (c = 0; c < 4; c++) {
+					i = base + (c & 1 ? sy : 0) + (c & 2 ? sz : 0);
+					v[c] = src[i] * (1 - fx) + src[i + sx] * fx;
+				}
+
+				dst[x] = ((v[0] * (1 - fy) + v[1] * fy) * (1 - fz)) + ((v[2] * (1 - fy) + v[3] * fy) * fz);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* init_resample : copies (and resamples) an sdim volume, laid out in order, into a dim vol, in z slabs over every core */
+int init_resample(f64 *src, ivec3_t sdim, char *order, f64 *vol, ivec3_t dim)
+{
+	struct resamplejob_t *jobs;
+	struct sys_thread **threads;
+	ivec3_t stride;
+	s64 *index[3];
+	f64 *frac[3], pos;
+	s64 i, last;
+	int j, n, axis;
+
+	/*
+	 * NOTE
+	 * The source covers the same domain we do, with its first and last points
+	 * on ours, so when the sizes differ, each of our points is trilinearly
+	 * interpolated from the 8 around it. When they don't, every frac is 0,
+	 * and it's a straight (maybe reordered) copy.
+	 */
+
+	for (j = 0, i = 1; j < 3; j++) { // the first axis in order is the fastest
+		axis = order[j] - 'x';
+		stride[axis] = i;
+		i *= sdim[axis];
+	}
+
+	for (j = 0; j < 3; j++) {
+		index[j] = calloc(dim[j], sizeof(s64));
+		frac[j] = calloc(dim[j], sizeof(f64));
+
+		last = sdim[j] - 1;
+
+		for (i = 0; i < dim[j]; i++) {
+			pos = dim[j] == sdim[j] ? i : dim[j] == 1 ? 0 : i * (f64)last / (dim[j] - 1);
+
+			index[j][i] = (s64)floor(pos);
+			if (last <= index[j][i]) {
+				index[j][i] = last;
+			}
+
+			frac[j][i] = pos - index[j][i];
+		}
+	}
+
+	n = sys_numcores();
+	if (dim[2] < n) {
+		n = dim[2];
+	}
+	if (n < 1) {
+		n = 1;
+	}
+
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	for (j = 0; j < n; j++) {
+		jobs[j].src = src;
+		jobs[j].vol = vol;
+		Vec3Copy(jobs[j].dim, dim);
+		Vec3Copy(jobs[j].stride, stride);
+		memcpy(jobs[j].index, index, sizeof(index));
+		memcpy(jobs[j].frac, frac, sizeof(frac));
+
+		jobs[j].zstart = (s32)((s64)dim[2] * j / n);
+		jobs[j].zstop = (s32)((s64)dim[2] * (j + 1) / n);
+
+		threads[j] = sys_threadcreate();
+		sys_threadsetfunc(threads[j], init_resamplethread);
+		sys_threadsetarg(threads[j], &jobs[j]);
+		sys_threadstart(threads[j]);
+	}
+
+	for (j = 0; j < n; j++) {
+		sys_threadwait(threads[j]);
+		sys_threadfree(threads[j]);
+	}
+
+	free(jobs);
+	free(threads);
+
+	for (j = 0; j < 3; j++) {
+		free(index[j]);
+		free(frac[j]);
+	}
+
+	return 0;
+}
+
+/* init_binaryask : writes the binary protocol's header, asking for a dim volume with points scale apart */
+int init_binaryask(FILE *fp, ivec3_t dim, f64 scale)
+{
+	int rc;
+
+	rc = fprintf(fp, "%s %d %d %d %d %.17g\n", INIT_MAGIC, INIT_VERSION, dim[0], dim[1], dim[2], scale);
+	if (rc < 0 || fflush(fp) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* init_binaryread : reads an init program's answer into vol, returns 1 if it did, 0 if it isn't the binary protocol, -1 if it's broken */
+int init_binaryread(FILE *fp, f64 *vol, ivec3_t dim)
+{
+	char buf[BUFSMALL];
+	u64 elements, got;
+	int version;
+
+	if (fgets(buf, sizeof buf, fp) != buf || strncmp(buf, INIT_MAGIC " ", strlen(INIT_MAGIC " ")) != 0) {
+		return 0;
+	}
+
+	if (sscanf(buf + strlen(INIT_MAGIC), "%d", &version) != 1 || version != INIT_VERSION) {
+		fprintf(stderr, "ERR : init program answered with an unknown protocol version\n");
+		return -1;
+	}
+
+	elements = dim[0] * (u64)dim[1] * dim[2];
+
+	got = fread(vol, sizeof(f64), elements, fp);
+	if (got != elements) {
+		fprintf(stderr, "ERR : expected %ld values from init program, got %ld\n", elements, got);
+		return -1;
+	}
+
+	return 1;
+}
+
+/* init_tostr : returns the name of the initializer's kind */
+char *init_tostr(int kind)
+{
+	if (kind < 0 || INIT_TOTAL <= kind) {
+		return "unknown";
+	}
+
+	return g_kinds[kind];
+}
+
@@ -0,0 +1,92 @@
+#ifndef INIT_H
+#define INIT_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 02:57
+ *
+ * Analytic Initial Conditions
+ *
+ * Built in initial conditions, so the usual ones don't need a program (or a
+ * library) of their own. An initializer is "<kind> [key=value ...]", in place
+ * of an initvel or initamp command:
+ *
+ *   gaussian  [amp=a] [width=w] [center=x,y,z] [travel=<+|-><x|y|z>]
+ *   planewave [amp=a] [wavelength=l] [phase=p] [axis=<x|y|z>] [travel=<+|-><x|y|z>]
+ *   point     [amp=a] [center=x,y,z]
+ *
+ * Positions and lengths are fractions of the domain, so center=0.5,0.5,0.5 is
+ * always the middle of it. The gaussian is amp * exp(-r^2 / width^2), the plane
+ * wave is amp * sin(2 pi s / wavelength + phase), with s along its axis, and a
+ * point puts amp on the grid point closest to center. With travel, what comes
+ * out is the time derivative of the wave moving that way at the speed we're
+ * given, which is what an initial velocity wants.
+ *
+ * Every kind is a product of one dimensional factors, so those get worked out
+ * once per axis, and filling the volume is just multiplying them together.
+ *
+ * Volumes that are already sitting in a file get copied onto our grid here,
+ * and when the file's grid is a different size, resampled trilinearly, with
+ * the first and last points on each axis lined up with ours.
+ *
+ * Init programs that speak the binary protocol are asked for their volume
+ * here too. It's a single header line each way:
+ *
+ *   us   : MOLTINIT <version> <x points> <y points> <z points> <space scale>
+ *   them : MOLTINIT <version>
+ *
+ * and then the whole volume comes back as raw f64s, in our byte order, x
+ * fastest. The program works the coordinates out for itself (point i is at
+ * i * scale), so there's nothing else to send, and our end gets closed as
+ * soon as the header's out. It's only used when the config asks for it
+ * (init_protocol: binary), since a program that only knows the text protocol
+ * can't be counted on to quit (or even to not hang) when it's handed a line
+ * it doesn't understand.
+ */
+
+#include <stdio.h>
+
+#include "common.h"
+
+#define INIT_MAGIC   "MOLTINIT"
+#define INIT_VERSION 1
+
+enum {
+	INIT_GAUSSIAN,
+	INIT_PLANEWAVE,
+	INIT_POINT,
+	INIT_TOTAL
+};
+
+struct initfunc_t {
+	s32 kind;       // INIT_*
+	s32 axis;       // INIT_PLANEWAVE's axis, 0, 1 or 2 for x, y or z
+	s32 travel;     // 0, or +/- 1 + the axis the wave moves along
+	s32 pad;
+	f64 amp;
+	f64 width;      // INIT_GAUSSIAN's
+	f64 wavelength; // INIT_PLANEWAVE's
+	f64 phase;
+	dvec3_t center; // INIT_GAUSSIAN and INIT_POINT's
+};
+
+/* init_parse : parses an initializer, returns 1 if it is one, 0 if it isn't (it's a command), -1 if it's broken */
+int init_parse(struct initfunc_t *init, char *s);
+
+/* init_fill : evaluates the initializer over a dim volume, with points scale apart, and waves moving at speed c */
+int init_fill(struct initfunc_t *init, f64 *vol, ivec3_t dim, f64 scale, f64 c);
+
+/* init_resample : copies (and resamples) an sdim volume, laid out in order, into a dim vol, in z slabs over every core */
+int init_resample(f64 *src, ivec3_t sdim, char *order, f64 *vol, ivec3_t dim);
+
+/* init_binaryask : writes the binary protocol's header, asking for a dim volume with points scale apart */
+int init_binaryask(FILE *fp, ivec3_t dim, f64 scale);
+
+/* init_binaryread : reads an init program's answer into vol, returns 1 if it did, 0 if it isn't the binary protocol, -1 if it's broken */
+int init_binaryread(FILE *fp, f64 *vol, ivec3_t dim);
+
+/* init_tostr : returns the name of the initializer's kind */
+char *init_tostr(int kind);
+
+#endif // INIT_H
+
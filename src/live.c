@@ -0,0 +1,231 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 02:37
+ *
+ * Live Frame Ring
+ *
+ * The ring is a livehdr_t, then 'slots' slots, each a liveslot_t followed by
+ * its frame. Publishing is one memcpy into the oldest slot, bracketed by two
+ * bumps of its sequence number, and then a bump of the header's head.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "sys.h"
+#include "brick.h"
+#include "live.h"
+
+#define LIVE_MAGIC *(u32 *)"LIVE"
+
+#define LIVE_ALIGN 64 // keeps the slots off of each other's cache lines
+#define LIVE_ALIGNUP(x) (((x) + LIVE_ALIGN - 1) & ~((u64)LIVE_ALIGN - 1))
+
+struct live_t {
+	struct livehdr_t *hdr;
+	size_t len;
+	int writer;
+	char name[BUFSMALL];
+};
+
+/* live_slot : returns the ith slot */
+static struct liveslot_t *live_slot(struct live_t *live, u64 i)
+{
+	return (struct liveslot_t *)((u8 *)live->hdr + LIVE_ALIGNUP(sizeof(struct livehdr_t)) + i * live->hdr->slotsize);
+}
+
+/* live_check : checks that a ring's header agrees with itself, and fits in len bytes */
+static int live_check(struct livehdr_t *hdr, size_t len)
+{
+	u64 elems;
+	int i;
+
+	// the header's in memory anybody can write to, so none of it's trusted
+	// until it adds up, and the frame's dimensions can't overflow along the way
+
+	if (len < LIVE_ALIGNUP(sizeof(*hdr)) || hdr->slots == 0) {
+		return -1;
+	}
+
+	for (i = 0, elems = 1; i < 3; i++) {
+		if (hdr->dim[i] <= 0 || len / sizeof(f64) / elems < (u64)hdr->dim[i]) {
+			return -1;
+		}
+		elems *= hdr->dim[i];
+	}
+
+	if (hdr->framesize != sizeof(f64) * elems) {
+		return -1;
+	}
+
+	if (hdr->slotsize < sizeof(struct liveslot_t) + hdr->framesize) {
+		return -1;
+	}
+
+	if ((len - LIVE_ALIGNUP(sizeof(*hdr))) / hdr->slotsize < hdr->slots) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* live_create : creates the named ring, with room for slots dim sized frames */
+struct live_t *live_create(char *name, ivec3_t dim, u64 slots)
+{
+	struct live_t *live;
+	struct livehdr_t *hdr;
+	u64 framesize, slotsize;
+	size_t len;
+
+	framesize = sizeof(f64) * dim[0] * (u64)dim[1] * dim[2];
+	slotsize = LIVE_ALIGNUP(sizeof(struct liveslot_t) + framesize);
+
+	len = LIVE_ALIGNUP(sizeof(struct livehdr_t)) + slots * slotsize;
+
+	hdr = sys_shmcreate(name, len);
+	if (hdr == NULL) {
+		return NULL;
+	}
+
+	live = calloc(1, sizeof(*live));
+
+	live->hdr = hdr;
+	live->len = len;
+	live->writer = 1;
+	strncpy(live->name, name, sizeof(live->name) - 1);
+
+	hdr->flags = 0;
+	hdr->slots = slots;
+	hdr->framesize = framesize;
+	hdr->slotsize = slotsize;
+	Vec3Copy(hdr->dim, dim);
+	hdr->head = 0;
+
+	// readers don't look at anything else until the magic shows up
+	__atomic_store_n(&hdr->magic, LIVE_MAGIC, __ATOMIC_RELEASE);
+
+	return live;
+}
+
+/* live_publish : copies a finished timestep into the ring */
+void live_publish(struct live_t *live, f64 *frame, u64 step)
+{
+	struct liveslot_t *slot;
+	u64 head, seq;
+
+	head = live->hdr->head;
+	slot = live_slot(live, head % live->hdr->slots);
+
+	seq = slot->seq;
+
+	// the odd sequence number has to land before any of the frame does
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->step = step;
+	memcpy(slot + 1, frame, live->hdr->framesize);
+
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&live->hdr->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* live_open : maps an existing ring to read from, NULL if it isn't there (yet) */
+struct live_t *live_open(char *name)
+{
+	struct live_t *live;
+	struct livehdr_t *hdr;
+	size_t len;
+
+	hdr = sys_shmopen(name, &len);
+	if (hdr == NULL) {
+		return NULL;
+	}
+
+	if (len < sizeof(*hdr) || __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != LIVE_MAGIC || live_check(hdr, len) < 0) {
+		sys_munmap(hdr, len);
+		return NULL;
+	}
+
+	live = calloc(1, sizeof(*live));
+
+	live->hdr = hdr;
+	live->len = len;
+	strncpy(live->name, name, sizeof(live->name) - 1);
+
+	return live;
+}
+
+/* live_getdim : gets the dimensions of the ring's frames */
+void live_getdim(struct live_t *live, ivec3_t dim)
+{
+	Vec3Copy(dim, live->hdr->dim);
+}
+
+/* live_read : copies the box [start, start + count) of the newest frame, if it's newer than *head */
+int live_read(struct live_t *live, u64 *head, f64 *dst, ivec3_t start, ivec3_t count, u64 *step)
+{
+	struct liveslot_t *slot;
+	ivec3_t zero;
+	u64 h, s1, s2;
+
+	/*
+	 * NOTE
+	 * Returns 1 with a new frame in dst, 0 if there's nothing newer than what
+	 * we saw last, and -1 if there never will be. If the writer laps us while
+	 * we're copying, the sequence numbers won't match, and we go again, with
+	 * whatever's newest by then.
+	 */
+
+	Vec3Set(zero, 0, 0, 0);
+
+	for (;;) {
+		h = __atomic_load_n(&live->hdr->head, __ATOMIC_ACQUIRE);
+		if (h == *head) {
+			if (__atomic_load_n(&live->hdr->flags, __ATOMIC_ACQUIRE) & LIVE_FLAG_CLOSED) {
+				// the last frame could have gone out right before it closed
+				if (__atomic_load_n(&live->hdr->head, __ATOMIC_ACQUIRE) == h) {
+					return -1;
+				}
+				continue;
+			}
+			return 0;
+		}
+
+		slot = live_slot(live, (h - 1) % live->hdr->slots);
+
+		s1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (s1 & 1) {
+			continue;
+		}
+
+		*step = slot->step;
+		brick_copy(dst, count, zero, (f64 *)(slot + 1), live->hdr->dim, start, count);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		s2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+		if (s1 == s2) {
+			*head = h;
+			return 1;
+		}
+	}
+}
+
+/* live_close : unmaps the ring, the writer marks it closed and removes its name first */
+void live_close(struct live_t *live)
+{
+	if (live == NULL) {
+		return;
+	}
+
+	if (live->writer) {
+		__atomic_or_fetch(&live->hdr->flags, LIVE_FLAG_CLOSED, __ATOMIC_RELEASE);
+		sys_shmunlink(live->name);
+	}
+
+	sys_munmap(live->hdr, live->len);
+
+	free(live);
+}
@@ -0,0 +1,59 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 02:37
+ *
+ * Live Frame Ring
+ *
+ * A ring of the last few timesteps, in named shared memory, so tools on the
+ * same machine can watch a run while it's going. There's one writer, the
+ * simulation, and any number of readers, none of which the writer ever waits
+ * on. Each slot is guarded by a sequence number that's odd while the slot is
+ * being written; a reader copies the frame out, and if the sequence number
+ * changed (or was odd) while it did, it just tries again.
+ */
+
+#include "common.h"
+
+#define LIVE_FLAG_CLOSED 0x01 // the run is over, nothing else is coming
+
+struct livehdr_t {
+	u32 magic;     // written last, once everything else is filled out
+	u32 flags;     // LIVE_FLAG_*
+	u64 slots;
+	u64 framesize; // bytes in a frame, an x fastest f64 volume
+	u64 slotsize;  // bytes from the start of one slot to the next
+	ivec3_t dim;
+	s32 pad;
+	u64 head;      // frames published so far, the newest is in slot (head - 1) % slots
+};
+
+struct liveslot_t {
+	u64 seq;  // odd while the frame is being written
+	u64 step;
+};
+
+struct live_t;
+
+/* live_create : creates the named ring, with room for slots dim sized frames */
+struct live_t *live_create(char *name, ivec3_t dim, u64 slots);
+
+/* live_publish : copies a finished timestep into the ring */
+void live_publish(struct live_t *live, f64 *frame, u64 step);
+
+/* live_open : maps an existing ring to read from, NULL if it isn't there (yet) */
+struct live_t *live_open(char *name);
+
+/* live_getdim : gets the dimensions of the ring's frames */
+void live_getdim(struct live_t *live, ivec3_t dim);
+
+/* live_read : copies the box [start, start + count) of the newest frame, if it's newer than *head */
+int live_read(struct live_t *live, u64 *head, f64 *dst, ivec3_t start, ivec3_t count, u64 *step);
+
+/* live_close : unmaps the ring, the writer marks it closed and removes its name first */
+void live_close(struct live_t *live);
+
+#endif // LIVE_H
+
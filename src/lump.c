@@ -4,10 +4,49 @@
  *
  * Lump System MK2
  *
+ * The lump table lives in a chain of extents. The first extent is small and
+ * sits right after the header; when it fills up, a new (bigger) extent is
+ * appended to the end of the file and linked onto the chain, so existing lump
+ * data never has to move. The whole table is cached in memory while the file
+ * is open.
+ *
+ * Lumps with a codec set (lump_setcodec) are encoded on the way in and decoded
+ * on the way out, so callers only ever see the raw bytes. The codec and the
+ * raw size ride along in the lumpinfo_t.
+ *
+ * With a keyframe interval set, only every keyframe'th entry of the tag is
+ * encoded on its own, and the rest are deltas from the entry before them.
+ * Reading a delta decodes forward from the nearest keyframe, or from the last
+ * lump we decoded, when that's the one right before it (reading entries in
+ * order only ever decodes each one once).
+ *
+ * Volumes of a tag with a brick size set (lump_setbrick) are stored bricked
+ * (see brick.h), and sub-box reads of those only read the bricks they touch.
+ * Bricks are always keyframes.
+ *
+ * There's only ever one writer, but any number of other processes can read
+ * the file while it's being written. A lump's data goes down first, then its
+ * info record, and the header's lump count last, so a reader never sees a lump
+ * that isn't all there. lump_refresh picks up whatever's been published since
+ * the table was last loaded. Lumps are never moved, and the only thing that
+ * changes under a reader is lump_truncate, which bumps the header's generation
+ * so readers know to throw their table away.
+ *
+ * With shards set (lump_setshards), lumps of LUMP_SHARDMIN bytes or more are
+ * striped over that many data files next to the lump file, <file>.0, <file>.1
+ * and so on, each stripe written on its own thread. Offsets are shared: stripe
+ * k of a lump at offset 'offset' is at 'offset' in shard k, and only reserves
+ * one stripe's worth of the lump file, so every file ends up sparse where the
+ * others have data. The lump file itself still holds the header and the table,
+ * and all of the small lumps.
+ *
+ * Only one lump file is open at a time, but lump_detach sets it aside, with
+ * its table, mapping and decoded lump, so another can be opened, and
+ * lump_swap trades between them, which is how one file gets copied into
+ * another without reopening either.
+ *
  * TODO (brian)
- * 1. Handle moving everything in the file to make room for the lump table to
- *    grow. I.E. remove the LUMP_METALEN restriction.
- * 2. Check more return values in lump_read & lump_write & generally everywhere
+ * 1. Check more return values in lump_read & lump_write & generally everywhere
  */
 
 #include <string.h>
@@ -15,201 +54,1770 @@
 
 #include "common.h"
 #include "sys.h"
+#include "codec.h"
+#include "brick.h"
 #include "lump.h"
+#include "prof.h"
 
 #define LUMP_MAGIC     *(s32 *)"MOLT"
-#define LUMP_MAXINFO   65535 // this makes the metadata 2MB
-#define LUMP_METALEN   (sizeof(struct lumpheader_t) + sizeof(struct lumpinfo_t) * LUMP_MAXINFO)
+#define LUMP_INITINFO  64    // lumpinfo_t's in the first extent (~3KB)
+#define LUMP_MAXEXTENT 65536 // extents stop doubling at this many lumpinfo_t's
+#define LUMP_ALIGN     8     // lump data is kept aligned for f64 views
+#define LUMP_MAXCODECS 16    // tags that can have a codec set
+#define LUMP_MAXSHARDS 64    // data files lumps can be striped over
+#define LUMP_SHARDMIN  65536 // lumps smaller than this aren't worth striping
+
+#define LUMP_ALIGNUP(x) (((x) + (LUMP_ALIGN - 1)) & ~((u64)LUMP_ALIGN - 1))
 
 static struct sys_file *g_lumpfile;
+static char g_lumpname[BUFLARGE];
 
-/* lump_open : opens the given file as the lump file we're using */
-int lump_open(char *file)
-{
+// the data files big lumps are striped over, when the file is sharded
+static struct sys_file *g_shard[LUMP_MAXSHARDS];
+static int g_shard_len;
+
+// when the lump file is opened with lump_openmap, the whole file is mapped read
+// only, and reads are serviced straight out of the mapping
+static u8 *g_lumpmap;
+static size_t g_lumpmaplen;
+
+// set for files opened with lump_openmap or lump_openfollow, which are read only
+static int g_readonly;
+
+// in memory copy of the header and the lump table
+static struct lumpheader_t g_header;
+static struct lumpinfo_t *g_info;
+static size_t g_info_len, g_info_cap;
+
+// file offset of every lumpinfo_t slot we've got room for, in table order
+static u64 *g_slot;
+static size_t g_slot_len, g_slot_cap;
+
+// the last extent in the chain, where new extents get linked from
+static u64 g_lastextent;
+
+// which tags get encoded or bricked, and with what
+static struct {
+	char tag[8];
+	int codec;
+	struct codecparams_t params;
+	ivec3_t dim;    // volumes this size get bricked...
+	s32 brick;      // ...into brick^3 bricks, 0 for flat
+	u8 *ref;        // last entry written, as it'll decode, for the next delta
+	size_t ref_cap;
+	size_t refsize; // 0 when there isn't one
+	u64 refentry;
+} g_codecs[LUMP_MAXCODECS];
+static size_t g_codecs_len;
+
+// encoded bytes on their way to or from the file
+static u8 *g_enc;
+static size_t g_enc_cap;
+
+// the last lump we had to decode, kept for range and slab reads of it, and
+// as the reference for decoding the delta after it
+static u8 *g_dec;
+static size_t g_dec_cap;
+static u64 g_decoffset;
+
+// where the next lump in a chain of deltas gets decoded, before it's swapped in
+static u8 *g_next;
+static size_t g_next_cap;
+
+// a lump_readv request, and what it found in the table
+struct lumpreadv_t {
+	struct lumpreq_t *req;
+	struct lumpinfo_t info;
+	int found;
+};
+
+// a single brick, for sub-box reads of bricked lumps
+static f64 *g_brick;
+static size_t g_brick_cap;
+
+// an open lump file set aside with lump_detach, everything above that's about
+// the file, and not about how we write (the codecs are the same for any file)
+struct lump_t {
+	struct sys_file *lumpfile;
+	char lumpname[BUFLARGE];
+	struct sys_file *shard[LUMP_MAXSHARDS];
+	int shard_len;
+	u8 *lumpmap;
+	size_t lumpmaplen;
+	int readonly;
 	struct lumpheader_t header;
+	struct lumpinfo_t *info;
+	size_t info_len, info_cap;
+	u64 *slot;
+	size_t slot_len, slot_cap;
+	u64 lastextent;
+	u8 *enc;
+	size_t enc_cap;
+	u8 *dec;
+	size_t dec_cap;
+	u64 decoffset;
+	u8 *next;
+	size_t next_cap;
+	f64 *brick;
+	size_t brick_cap;
+};
 
-	g_lumpfile = sys_open(file);
+/* lump_rawread : reads len bytes at offset from the file (or the mapping) */
+static int lump_rawread(size_t offset, size_t len, void *dst)
+{
+	if (g_lumpmap) {
+		if (g_lumpmaplen < offset || g_lumpmaplen - offset < len) {
+			return -1;
+		}
 
-	if (g_lumpfile == NULL) {
-		return -1;
+		memcpy(dst, g_lumpmap + offset, len);
+
+		return 0;
 	}
 
-	// TODO (brian)
-	// only write a fresh header if the file didn't exist before this
+	return sys_read(g_lumpfile, offset, len, dst) == len ? 0 : -1;
+}
+
+/* lump_rawwrite : writes len bytes at offset into the file */
+static int lump_rawwrite(size_t offset, size_t len, void *src)
+{
+	return sys_write(g_lumpfile, offset, len, src) == len ? 0 : -1;
+}
 
-	header.magic = LUMP_MAGIC;
-	header.flags = 0;
-	sys_timestamp(&header.ts_created, NULL);
-	header.size = sizeof(header);
-	header.lumps = 0;
+/* lump_stripe : gets the size of each of a sharded lump's stripes */
+static u64 lump_stripe(u64 size)
+{
+	return LUMP_ALIGNUP((size + g_header.shards - 1) / g_header.shards);
+}
 
-	sys_write(g_lumpfile, 0, sizeof(header), &header);
+/* lump_shardio : reads or writes len bytes, offset bytes into a sharded lump, a stripe at a time */
+static int lump_shardio(struct lumpinfo_t *info, size_t offset, size_t len, u8 *buf, int write)
+{
+	u64 stripe, k, off, n;
+	int rc;
 
-	return 0; // return 0 on success
+	stripe = lump_stripe(info->size);
+
+	while (len) {
+		k = offset / stripe;
+		off = offset % stripe;
+		n = stripe - off < len ? stripe - off : len;
+
+		if ((u64)g_shard_len <= k) {
+			return -1;
+		}
+
+		if (write) {
+			rc = sys_write(g_shard[k], info->offset + off, n, buf) == n ? 0 : -1;
+		} else {
+			rc = sys_read(g_shard[k], info->offset + off, n, buf) == n ? 0 : -1;
+		}
+
+		if (rc < 0) {
+			return -1;
+		}
+
+		offset += n;
+		len -= n;
+		buf += n;
+	}
+
+	return 0;
 }
 
-/* lump_close : closes the lump file */
-int lump_close()
+/* lump_dataread : reads len bytes, offset bytes into the lump's bytes on disk */
+static int lump_dataread(struct lumpinfo_t *info, size_t offset, size_t len, void *dst)
 {
-	return sys_close(g_lumpfile); // return 0 on success
+	if (info->flags & LUMP_FLAG_SHARDED) {
+		return lump_shardio(info, offset, len, dst, 0);
+	}
+
+	return lump_rawread(info->offset + offset, len, dst);
 }
 
-/* lump_getheader : gets the lump system's header */
-int lump_getheader(struct lumpheader_t *header)
+struct lumpshardjob_t {
+	struct sys_file *fd;
+	u64 offset;
+	size_t len;
+	u8 *src;
+	int rc;
+};
+
+/* lump_shardwrite : writes one stripe of a lump */
+static void *lump_shardwrite(void *arg)
 {
-	size_t bytes;
+	struct lumpshardjob_t *job = arg;
 
-	bytes = sys_read(g_lumpfile, 0, sizeof(struct lumpheader_t), header);
+	job->rc = sys_write(job->fd, job->offset, job->len, job->src) == job->len ? 0 : -1;
 
-	return bytes != sizeof(struct lumpheader_t);
+	return NULL;
 }
 
-/* lump_getlumpinfo : reads the given lumpinfo at index into the pointer */
-int lump_getinfo(struct lumpinfo_t *info, u64 index)
+/* lump_datawrite : writes a new lump's bytes, every stripe on its own thread if it's sharded */
+static int lump_datawrite(struct lumpinfo_t *info, void *src)
 {
-	struct lumpheader_t header;
-	size_t bytes, offset;
+	struct lumpshardjob_t jobs[LUMP_MAXSHARDS];
+	struct sys_thread *threads[LUMP_MAXSHARDS];
+	u64 stripe, k, n;
+	int rc;
 
-	memset(info, 0, sizeof(*info));
+	if (!(info->flags & LUMP_FLAG_SHARDED)) {
+		return lump_rawwrite(info->offset, info->size, src);
+	}
 
-	bytes = sys_read(g_lumpfile, 0, sizeof(header), &header);
+	stripe = lump_stripe(info->size);
 
-	if (header.lumps <= index) {
-		return -1;
+	// every shard's file system gets a stream of its own, and the first
+	// stripe goes out on this thread while the rest go out on theirs
+	for (k = 0, n = 0; k < (u64)g_shard_len && k * stripe < info->size; k++, n++) {
+		jobs[k].fd = g_shard[k];
+		jobs[k].offset = info->offset;
+		jobs[k].len = info->size - k * stripe < stripe ? info->size - k * stripe : stripe;
+		jobs[k].src = (u8 *)src + k * stripe;
+		jobs[k].rc = 0;
+
+		if (k == 0) {
+			continue;
+		}
+
+		threads[k] = sys_threadcreate();
+		sys_threadsetfunc(threads[k], lump_shardwrite);
+		sys_threadsetarg(threads[k], &jobs[k]);
+		sys_threadstart(threads[k]);
 	}
 
-	offset = sizeof(struct lumpheader_t) + sizeof(struct lumpinfo_t) * index;
+	if (n * stripe < info->size) { // not enough shards open for the lump
+		jobs[0].rc = -1;
+	} else {
+		lump_shardwrite(&jobs[0]);
+	}
+
+	for (k = 1; k < n; k++) {
+		sys_threadwait(threads[k]);
+		sys_threadfree(threads[k]);
+	}
 
-	bytes = sys_read(g_lumpfile, offset, sizeof(struct lumpinfo_t), info);
+	for (k = 0, rc = 0; k < n; k++) {
+		if (jobs[k].rc < 0) {
+			rc = -1;
+		}
+	}
 
-	return bytes != sizeof(struct lumpinfo_t);
+	return rc;
 }
 
-/* lump_getnumentries : gets the number of entries for the given tag */
-int lump_getnumentries(char *tag, u64 *entries)
+/* lump_openshards : opens whichever of the header's shards we don't have open yet */
+static int lump_openshards(sys_file *(*openfunc)(char *name))
 {
-	struct lumpinfo_t info;
-	u64 i, j;
+	char name[BUFLARGE + 16];
+
+	while ((u64)g_shard_len < g_header.shards && g_shard_len < LUMP_MAXSHARDS) {
+		snprintf(name, sizeof name, "%s.%d", g_lumpname, g_shard_len);
+
+		g_shard[g_shard_len] = openfunc(name);
+		if (g_shard[g_shard_len] == NULL) {
+			return -1;
+		}
+
+		g_shard_len++;
+	}
+
+	return (u64)g_shard_len < g_header.shards ? -1 : 0;
+}
+
+/* lump_closeshards : closes the shards */
+static void lump_closeshards(void)
+{
+	int i;
+
+	for (i = 0; i < g_shard_len; i++) {
+		sys_close(g_shard[i]);
+		free(g_shard[i]);
+		g_shard[i] = NULL;
+	}
+
+	g_shard_len = 0;
+}
+
+/* lump_scratch : makes sure the scratch buffer can hold at least need bytes */
+static int lump_scratch(u8 **buf, size_t *cap, size_t need)
+{
+	u8 *p;
+
+	if (need <= *cap) {
+		return 0;
+	}
+
+	p = realloc(*buf, need);
+	if (p == NULL) {
+		return -1;
+	}
+
+	*buf = p;
+	*cap = need;
+
+	return 0;
+}
+
+/* lump_decode : decodes an encoded lump into dst, which holds info->rawsize bytes */
+static int lump_decode(struct lumpinfo_t *info, void *dst, void *ref)
+{
+	u8 *src;
 	int rc;
 
-	*entries = 0;
+	// a mapped file gets decoded in place, otherwise it's read in first
+	if (g_lumpmap && !(info->flags & LUMP_FLAG_SHARDED)) {
+		if (g_lumpmaplen < info->offset || g_lumpmaplen - info->offset < info->size) {
+			return -1;
+		}
+		src = g_lumpmap + info->offset;
+	} else {
+		rc = lump_scratch(&g_enc, &g_enc_cap, info->size);
+		if (rc < 0) {
+			return -1;
+		}
 
-	for (i = 0, j = 0; ; i++) {
-		rc = lump_getinfo(&info, i);
+		rc = lump_dataread(info, 0, info->size, g_enc);
 		if (rc < 0) {
+			return -1;
+		}
+
+		src = g_enc;
+	}
+
+	if (info->flags & LUMP_FLAG_BRICKED) {
+		return brick_decode(dst, info->rawsize, src, info->size);
+	}
+
+	return codec_decode(dst, info->rawsize, src, info->size, ref);
+}
+
+/* lump_isplain : returns true if the lump's bytes on disk are the lump */
+static int lump_isplain(struct lumpinfo_t *info)
+{
+	return info->codec == CODEC_NONE && !(info->flags & LUMP_FLAG_BRICKED);
+}
+
+/* lump_find : finds the lumpinfo for the given tag and entry */
+static int lump_find(char *tag, u64 entry, struct lumpinfo_t *info)
+{
+	size_t i;
+
+	for (i = 0; i < g_info_len; i++) {
+		if (strncmp(tag, g_info[i].tag, sizeof(g_info[i].tag)) == 0 && entry == g_info[i].entry) {
+			*info = g_info[i];
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/* lump_cache : gets the decoded contents of an encoded lump into g_dec */
+static int lump_cache(struct lumpinfo_t *info)
+{
+	struct lumpinfo_t cur;
+	u8 *tmp;
+	size_t tmp_cap;
+	u64 e;
+	int rc;
+
+	if (g_decoffset == info->offset) {
+		return 0;
+	}
+
+	rc = lump_scratch(&g_dec, &g_dec_cap, info->rawsize);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// walk back to whatever the chain of deltas can start from, which is
+	// either a keyframe, or the last lump we decoded
+	for (e = info->entry, cur = *info;; e--) {
+		if (e != info->entry) {
+			rc = lump_find(info->tag, e, &cur);
+			if (rc < 0 || cur.rawsize != info->rawsize) {
+				return -1;
+			}
+
+			if (g_decoffset == cur.offset) {
+				break;
+			}
+		}
+
+		if (!(cur.flags & LUMP_FLAG_DELTA)) {
+			g_decoffset = 0;
+
+			rc = lump_isplain(&cur) ? lump_dataread(&cur, 0, cur.size, g_dec) : lump_decode(&cur, g_dec, NULL);
+			if (rc < 0) {
+				return -1;
+			}
+
+			g_decoffset = cur.offset;
 			break;
 		}
 
-		if (strncmp(tag, info.tag, sizeof(info.tag)) == 0) {
-			j++;
+		if (e == 0) {
+			return -1;
 		}
 	}
 
-	*entries = j;
+	if (e == info->entry) {
+		return 0;
+	}
+
+	rc = lump_scratch(&g_next, &g_next_cap, info->rawsize);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// then decode forward, one delta at a time, to the lump we're after
+	for (e++; e <= info->entry; e++) {
+		rc = lump_find(info->tag, e, &cur);
+		if (rc < 0 || cur.rawsize != info->rawsize) {
+			return -1;
+		}
+
+		g_decoffset = 0;
+
+		rc = lump_decode(&cur, g_next, g_dec);
+		if (rc < 0) {
+			return -1;
+		}
+
+		tmp = g_dec, tmp_cap = g_dec_cap;
+		g_dec = g_next, g_dec_cap = g_next_cap;
+		g_next = tmp, g_next_cap = tmp_cap;
+
+		g_decoffset = cur.offset;
+	}
 
 	return 0;
 }
 
-/* lump_readsize : reads the size of the lump with the given tag and entry no */
-int lump_readsize(char *tag, u64 entry, size_t *size)
+/* lump_load : reads len decoded bytes, offset bytes into the lump */
+static int lump_load(struct lumpinfo_t *info, size_t offset, size_t len, void *dst)
+{
+	int rc;
+
+	if (lump_isplain(info)) {
+		return lump_dataread(info, offset, len, dst);
+	}
+
+	// pieces of an encoded lump come out of the whole decoded lump, which we
+	// hang on to, as the next read is most likely for more of the same lump
+	rc = lump_cache(info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	memcpy(dst, g_dec + offset, len);
+
+	return 0;
+}
+
+/* lump_addslots : remembers the file offsets of an extent's lumpinfo_t slots */
+static void lump_addslots(u64 extent, u64 cap)
 {
-	struct lumpinfo_t info;
 	u64 i;
+
+	for (i = 0; i < cap; i++) {
+		c_resize(&g_slot, &g_slot_len, &g_slot_cap, sizeof(*g_slot));
+		g_slot[g_slot_len++] = extent + sizeof(struct lumpextent_t) + sizeof(struct lumpinfo_t) * i;
+	}
+}
+
+/* lump_readheader : reads the header, making sure we didn't catch it half written */
+static int lump_readheader(struct lumpheader_t *header)
+{
+	struct lumpheader_t again;
+	size_t len;
+	u32 magic;
 	int rc;
 
-	for (i = 0; ; i++) {
-		rc = lump_getinfo(&info, i);
+	// a new header goes out in one write, so a file too short for one is
+	// either one we got to first, or one that was never a lump file
+	len = g_lumpmap ? g_lumpmaplen : sys_getsize(g_lumpfile);
+	if (len < sizeof(*header)) {
+		magic = LUMP_MAGIC;
+		if (len && lump_rawread(0, len < sizeof(magic) ? len : sizeof(magic), &magic) == 0 && magic != LUMP_MAGIC) {
+			return LUMP_EFORMAT;
+		}
+		return LUMP_ENOFILE;
+	}
+
+	// the writer's header updates aren't atomic to someone reading them, but
+	// they're rare, so reading it until it reads the same twice is plenty
+	rc = lump_rawread(0, sizeof(*header), header);
+	if (rc < 0) {
+		return -1;
+	}
+
+	for (;;) {
+		rc = lump_rawread(0, sizeof(again), &again);
 		if (rc < 0) {
 			return -1;
 		}
 
-		if (strncmp(tag, info.tag, sizeof(info.tag)) == 0 && entry == info.entry) {
+		if (memcmp(header, &again, sizeof(again)) == 0) {
 			break;
 		}
+
+		*header = again;
 	}
 
-	*size = info.size;
+	if (header->magic != LUMP_MAGIC) {
+		return LUMP_EFORMAT;
+	}
 
-	return 0;
+	return header->version == LUMP_VERSION ? 0 : LUMP_EVERSION;
 }
 
-/* lump_read : reads a lump into the buffer */
-int lump_read(char *tag, u64 entry, void *dst)
+/* lump_loadextents : follows the extent chain past the last extent we know of */
+static int lump_loadextents(void)
 {
-	struct lumpinfo_t info;
-	u64 i;
+	struct lumpextent_t extent;
+	u64 off;
 	int rc;
 
-	for (i = 0; ; i++) {
-		rc = lump_getinfo(&info, i);
+	if (g_slot_len == 0) {
+		off = g_header.table;
+	} else {
+		rc = lump_rawread(g_lastextent, sizeof(extent), &extent);
 		if (rc < 0) {
 			return -1;
 		}
+		off = extent.next;
+	}
 
-		if (strncmp(tag, info.tag, sizeof(info.tag)) == 0 && entry == info.entry) {
-			break;
+	for (; off; off = extent.next) {
+		rc = lump_rawread(off, sizeof(extent), &extent);
+		if (rc < 0) {
+			return -1;
+		}
+
+		lump_addslots(off, extent.cap);
+		g_lastextent = off;
+
+		// an extent can get linked in before the header's size catches up
+		// (we crashed while growing), so never hand out space under one
+		if (g_header.size < off + sizeof(extent) + sizeof(struct lumpinfo_t) * extent.cap) {
+			g_header.size = off + sizeof(extent) + sizeof(struct lumpinfo_t) * extent.cap;
 		}
 	}
 
-	return info.size == sys_read(g_lumpfile, info.offset, info.size, dst) ? 0 : -1;
+	return 0;
 }
 
-/* lump_write : writes the given lump into the lump system */
-int lump_write(char *tag, size_t size, void *src, u64 *entry)
+/* lump_loadinfo : reads the lumpinfo_t's we don't have yet, up to the header's count */
+static int lump_loadinfo(void)
 {
-	struct lumpheader_t header;
-	struct lumpinfo_t info;
-	size_t offset_data, offset_info;
-	size_t bytes;
-	u64 i, datasize;
+	int rc;
 
-	assert(strlen(tag) <= sizeof(info.tag));
+	// the info records are only ever published after the extents they're in
+	if (g_slot_len < g_header.lumps) {
+		rc = lump_loadextents();
+		if (rc < 0 || g_slot_len < g_header.lumps) {
+			return -1;
+		}
+	}
 
-	// we first have to read the header, to determine where we should write
-	// our info record, then write that info record, followed up with
-	// writing our data
+	while (g_info_len < g_header.lumps) {
+		c_resize(&g_info, &g_info_len, &g_info_cap, sizeof(*g_info));
+		rc = lump_rawread(g_slot[g_info_len], sizeof(*g_info), g_info + g_info_len);
+		if (rc < 0) {
+			return -1;
+		}
+		g_info_len++;
+	}
 
-	bytes = sys_read(g_lumpfile, 0, sizeof(header), &header);
-	if (bytes < 0) {
-		return -1;
+	return 0;
+}
+
+/* lump_loadtable : walks the extent chain, caching the header and lump table */
+static int lump_loadtable(void)
+{
+	int rc;
+
+	g_info_len = 0;
+	g_slot_len = 0;
+	g_decoffset = 0;
+
+	rc = lump_readheader(&g_header);
+	if (rc < 0) {
+		return rc;
 	}
 
-	if (header.lumps == LUMP_MAXINFO) {
+	rc = lump_loadextents();
+	if (rc < 0) {
 		return -1;
 	}
 
-	// walk the info table summing how many items we have
-	// NOTE potential optimization is to use the file size
-	for (i = 0, datasize = 0; i < header.lumps; i++) {
-		offset_data = sizeof(struct lumpheader_t) + sizeof(struct lumpinfo_t) * i;
-		sys_read(g_lumpfile, offset_data, sizeof(struct lumpinfo_t), &info);
-		datasize += info.size;
+	return lump_loadinfo();
+}
+
+/* lump_grow : appends a new, bigger extent to the chain */
+static int lump_grow(void)
+{
+	struct lumpextent_t extent, last;
+	u64 off;
+	int rc;
+
+	rc = lump_rawread(g_lastextent, sizeof(last), &last);
+	if (rc < 0) {
+		return -1;
 	}
 
-	offset_info = sizeof(struct lumpheader_t) + sizeof(struct lumpinfo_t) * header.lumps;
-	offset_data = LUMP_METALEN + datasize;
+	off = LUMP_ALIGNUP(g_header.size);
 
-	// fill out our info record
-	memset(&info, 0, sizeof(info));
+	memset(&extent, 0, sizeof(extent));
+	extent.cap = last.cap * 2 < LUMP_MAXEXTENT ? last.cap * 2 : LUMP_MAXEXTENT;
 
-	strncpy(info.tag, tag, strlen(tag));
-	info.offset = offset_data;
-	info.size = size;
-	lump_getnumentries(tag, &info.entry);
+	// the new extent has to be on disk before anything can point at it
+	rc = lump_rawwrite(off, sizeof(extent), &extent);
+	if (rc < 0) {
+		return -1;
+	}
 
-	sys_write(g_lumpfile, offset_info, sizeof(struct lumpinfo_t), &info);
+	last.next = off;
+	rc = lump_rawwrite(g_lastextent, sizeof(last), &last);
+	if (rc < 0) {
+		return -1;
+	}
 
-	sys_write(g_lumpfile, info.offset, size, src);
+	lump_addslots(off, extent.cap);
+	g_lastextent = off;
 
-	// don't forget to update our header
-	header.size = offset_data + size;
-	header.lumps++;
-	sys_write(g_lumpfile, 0, sizeof(struct lumpheader_t), &header);
+	g_header.size = off + sizeof(extent) + sizeof(struct lumpinfo_t) * extent.cap;
 
-	if (entry) {
-		*entry = info.entry;
+	return lump_rawwrite(0, sizeof(g_header), &g_header);
+}
+
+/* lump_dropref : forgets the last entry written for every tag, so the next is a keyframe */
+static void lump_dropref(void)
+{
+	size_t i;
+
+	for (i = 0; i < g_codecs_len; i++) {
+		g_codecs[i].refsize = 0;
 	}
+}
 
-	return 0;
+/* lump_freetable : releases the in memory table */
+static void lump_freetable(void)
+{
+	free(g_info);
+	g_info = NULL;
+	g_info_len = g_info_cap = 0;
+
+	free(g_slot);
+	g_slot = NULL;
+	g_slot_len = g_slot_cap = 0;
+
+	g_lastextent = 0;
+	memset(&g_header, 0, sizeof(g_header));
+
+	g_readonly = 0;
+
+	free(g_enc);
+	g_enc = NULL;
+	g_enc_cap = 0;
+
+	free(g_dec);
+	g_dec = NULL;
+	g_dec_cap = 0;
+	g_decoffset = 0;
+
+	free(g_next);
+	g_next = NULL;
+	g_next_cap = 0;
+
+	free(g_brick);
+	g_brick = NULL;
+	g_brick_cap = 0;
+
+	lump_dropref();
 }
 
+/* lump_open : opens the given file as the lump file we're using */
+int lump_open(char *file)
+{
+	struct lumpextent_t extent;
+	int rc;
+
+	g_lumpfile = sys_open(file);
+
+	if (g_lumpfile == NULL) {
+		return -1;
+	}
+
+	strncpy(g_lumpname, file, sizeof(g_lumpname) - 1);
+
+	// NOTE this always starts a new file, whatever was there is truncated,
+	// lump_reopen is the one that keeps an existing file's lumps
+
+	memset(&g_header, 0, sizeof(g_header));
+	memset(&extent, 0, sizeof(extent));
+
+	g_header.magic = LUMP_MAGIC;
+	g_header.version = LUMP_VERSION;
+	g_header.flags = 0;
+	sys_timestamp(&g_header.ts_created, NULL);
+	g_header.lumps = 0;
+	g_header.table = sizeof(g_header);
+	g_header.gen = 0;
+
+	extent.next = 0;
+	extent.cap = LUMP_INITINFO;
+
+	g_header.size = g_header.table + sizeof(extent) + sizeof(struct lumpinfo_t) * extent.cap;
+
+	rc = lump_rawwrite(g_header.table, sizeof(extent), &extent);
+	if (rc < 0) {
+		lump_close();
+		return -1;
+	}
+
+	rc = lump_rawwrite(0, sizeof(g_header), &g_header);
+	if (rc < 0) {
+		lump_close();
+		return -1;
+	}
+
+	lump_addslots(g_header.table, extent.cap);
+	g_lastextent = g_header.table;
+
+	return 0; // return 0 on success
+}
+
+/* lump_setshards : stripes the big lumps of a new lump file over n data files */
+int lump_setshards(int n)
+{
+	int rc;
+
+	if (g_readonly || g_info_len != 0 || n < 0 || LUMP_MAXSHARDS < n) {
+		return -1;
+	}
+
+	if (n <= 1) { // one shard is just the lump file
+		return 0;
+	}
+
+	g_header.shards = n;
+
+	rc = lump_openshards(sys_open);
+	if (rc < 0) {
+		return -1;
+	}
+
+	return lump_rawwrite(0, sizeof(g_header), &g_header);
+}
+
+/* lump_reopen : opens an existing lump file, to append more lumps to it */
+int lump_reopen(char *file)
+{
+	int rc;
+
+	g_lumpfile = sys_reopen(file);
+
+	if (g_lumpfile == NULL) {
+		return LUMP_ENOFILE;
+	}
+
+	strncpy(g_lumpname, file, sizeof(g_lumpname) - 1);
+
+	rc = lump_loadtable();
+	if (rc == 0) {
+		rc = lump_openshards(sys_reopen);
+	}
+
+	if (rc < 0) {
+		lump_close();
+		return rc;
+	}
+
+	return 0;
+}
+
+/* lump_openmap : opens an existing lump file, read only, and maps it */
+int lump_openmap(char *file)
+{
+	struct lumpheader_t header;
+	int rc;
+
+	g_lumpfile = sys_openread(file);
+
+	if (g_lumpfile == NULL) {
+		return LUMP_ENOFILE;
+	}
+
+	g_lumpmaplen = sys_getsize(g_lumpfile);
+	if (g_lumpmaplen < sizeof(header)) {
+		lump_close();
+		return LUMP_EFORMAT;
+	}
+
+	g_lumpmap = sys_mmap(g_lumpfile, g_lumpmaplen);
+	if (g_lumpmap == NULL) {
+		lump_close();
+		return -1;
+	}
+
+	g_readonly = 1;
+
+	strncpy(g_lumpname, file, sizeof(g_lumpname) - 1);
+
+	rc = lump_loadtable();
+	if (rc == 0) {
+		rc = lump_openshards(sys_openread);
+	}
+
+	if (rc < 0) {
+		lump_close();
+		return rc;
+	}
+
+	return 0;
+}
+
+/* lump_openfollow : opens an existing lump file, read only, to follow while it's written */
+int lump_openfollow(char *file)
+{
+	struct lumpheader_t header;
+	int rc;
+
+	g_lumpfile = sys_openread(file);
+
+	if (g_lumpfile == NULL) {
+		return LUMP_ENOFILE;
+	}
+
+	g_readonly = 1;
+
+	strncpy(g_lumpname, file, sizeof(g_lumpname) - 1);
+
+	// a table that doesn't add up is only worth another look if the writer
+	// truncated it while we were reading, otherwise the file's just broken
+	for (;;) {
+		rc = lump_loadtable();
+		if (rc == 0) {
+			rc = lump_openshards(sys_openread);
+			break;
+		}
+
+		if (rc != -1 || lump_readheader(&header) < 0) {
+			break;
+		}
+
+		if (header.gen == g_header.gen && header.ts_created == g_header.ts_created) {
+			break;
+		}
+	}
+
+	if (rc < 0) {
+		lump_close();
+		return rc;
+	}
+
+	return 0;
+}
+
+/* lump_refresh : picks up the lumps published since the table was last loaded */
+int lump_refresh(void)
+{
+	struct lumpheader_t header;
+	size_t len;
+	int rc;
+
+	/*
+	 * NOTE
+	 * The info records under the header's count never change, so normally
+	 * this only reads the new ones. When the writer truncated the table, or
+	 * it's a different file altogether (a new run on the same name), the
+	 * whole table gets reloaded. Either way, the header is read again after,
+	 * and if the generation moved while we were reading, we go again.
+	 *
+	 * Remapping a mapped file invalidates any lump_view pointers.
+	 */
+
+	if (!g_readonly) { // the writer's table is always up to date
+		return 0;
+	}
+
+	for (;;) {
+		if (g_lumpmap) {
+			len = sys_getsize(g_lumpfile);
+			if (len != g_lumpmaplen) {
+				sys_munmap(g_lumpmap, g_lumpmaplen);
+				g_lumpmaplen = len;
+				g_lumpmap = sys_mmap(g_lumpfile, g_lumpmaplen);
+				if (g_lumpmap == NULL) {
+					g_lumpmaplen = 0;
+					return -1;
+				}
+			}
+		}
+
+		rc = lump_readheader(&header);
+		if (rc < 0) {
+			return -1;
+		}
+
+		if (header.gen != g_header.gen || header.ts_created != g_header.ts_created || header.lumps < g_info_len) {
+			rc = lump_loadtable();
+			if (rc < 0) {
+				return -1;
+			}
+		} else {
+			g_header = header;
+
+			rc = lump_loadinfo();
+			if (rc < 0) {
+				return -1;
+			}
+		}
+
+		rc = lump_readheader(&header);
+		if (rc < 0) {
+			return -1;
+		}
+
+		if (header.gen == g_header.gen && header.ts_created == g_header.ts_created) {
+			return lump_openshards(sys_openread);
+		}
+	}
+}
+
+/* lump_ismapped : returns true if the lump file was opened with lump_openmap */
+int lump_ismapped(void)
+{
+	return g_lumpmap != NULL;
+}
+
+/* lump_close : closes the lump file */
+int lump_close()
+{
+	int rc;
+
+	if (g_lumpmap) {
+		sys_munmap(g_lumpmap, g_lumpmaplen);
+		g_lumpmap = NULL;
+		g_lumpmaplen = 0;
+	}
+
+	rc = sys_close(g_lumpfile); // return 0 on success
+
+	free(g_lumpfile);
+	g_lumpfile = NULL;
+
+	lump_closeshards();
+	memset(g_lumpname, 0, sizeof(g_lumpname));
+
+	lump_freetable();
+
+	return rc;
+}
+
+/* lump_swapbytes : swaps n bytes between a and b */
+static void lump_swapbytes(void *a, void *b, size_t n)
+{
+	u8 *x, *y, t;
+	size_t i;
+
+	for (x = a, y = b, i = 0; i < n; i++) {
+		t = x[i];
+		x[i] = y[i];
+		y[i] = t;
+	}
+}
+
+/* lump_swap : swaps the open lump file (or none) with one that was set aside */
+void lump_swap(struct lump_t *lump)
+{
+#define LUMP_SWAP(g, f) lump_swapbytes(&(g), &lump->f, sizeof(g))
+	LUMP_SWAP(g_lumpfile, lumpfile);
+	LUMP_SWAP(g_lumpname, lumpname);
+	LUMP_SWAP(g_shard, shard);
+	LUMP_SWAP(g_shard_len, shard_len);
+	LUMP_SWAP(g_lumpmap, lumpmap);
+	LUMP_SWAP(g_lumpmaplen, lumpmaplen);
+	LUMP_SWAP(g_readonly, readonly);
+	LUMP_SWAP(g_header, header);
+	LUMP_SWAP(g_info, info);
+	LUMP_SWAP(g_info_len, info_len);
+	LUMP_SWAP(g_info_cap, info_cap);
+	LUMP_SWAP(g_slot, slot);
+	LUMP_SWAP(g_slot_len, slot_len);
+	LUMP_SWAP(g_slot_cap, slot_cap);
+	LUMP_SWAP(g_lastextent, lastextent);
+	LUMP_SWAP(g_enc, enc);
+	LUMP_SWAP(g_enc_cap, enc_cap);
+	LUMP_SWAP(g_dec, dec);
+	LUMP_SWAP(g_dec_cap, dec_cap);
+	LUMP_SWAP(g_decoffset, decoffset);
+	LUMP_SWAP(g_next, next);
+	LUMP_SWAP(g_next_cap, next_cap);
+	LUMP_SWAP(g_brick, brick);
+	LUMP_SWAP(g_brick_cap, brick_cap);
+#undef LUMP_SWAP
+}
+
+/* lump_detach : sets the open lump file aside, leaving none open, so another one can be */
+struct lump_t *lump_detach(void)
+{
+	struct lump_t *lump;
+
+	lump = calloc(1, sizeof(*lump)); // all zeroes is what a closed lump file looks like
+
+	lump_swap(lump);
+
+	return lump;
+}
+
+/* lump_release : closes a lump file that was set aside */
+int lump_release(struct lump_t *lump)
+{
+	int rc;
+
+	if (lump == NULL) {
+		return 0;
+	}
+
+	// lump_close only works on the open one, so it has to trade places with it
+	lump_swap(lump);
+	rc = lump_close();
+	lump_swap(lump);
+
+	free(lump);
+
+	return rc;
+}
+
+/* lump_strerror : describes what went wrong opening a lump file, given what the open returned */
+char *lump_strerror(int rc)
+{
+	switch (rc) {
+	case LUMP_ENOFILE:
+		return "it doesn't exist, or its header isn't written yet";
+	case LUMP_EFORMAT:
+		return "it isn't a lump file";
+	case LUMP_EVERSION:
+		return "it's an old lump format, from another version of molt";
+	default:
+		return "its lump table is broken";
+	}
+}
+
+/* lump_getheader : gets the lump system's header */
+int lump_getheader(struct lumpheader_t *header)
+{
+	return lump_rawread(0, sizeof(struct lumpheader_t), header);
+}
+
+/* lump_getlumpinfo : reads the given lumpinfo at index into the pointer */
+int lump_getinfo(struct lumpinfo_t *info, u64 index)
+{
+	memset(info, 0, sizeof(*info));
+
+	if (g_info_len <= index) {
+		return -1;
+	}
+
+	*info = g_info[index];
+
+	return 0;
+}
+
+/* lump_getnumentries : gets the number of entries for the given tag */
+int lump_getnumentries(char *tag, u64 *entries)
+{
+	size_t i;
+	u64 j;
+
+	for (i = 0, j = 0; i < g_info_len; i++) {
+		if (strncmp(tag, g_info[i].tag, sizeof(g_info[i].tag)) == 0) {
+			j++;
+		}
+	}
+
+	*entries = j;
+
+	return 0;
+}
+
+/* lump_tagslot : finds (or makes) the g_codecs slot for the tag, -1 if they're all taken */
+static int lump_tagslot(char *tag)
+{
+	size_t i;
+
+	assert(strlen(tag) <= sizeof(g_codecs[0].tag));
+
+	for (i = 0; i < g_codecs_len; i++) {
+		if (strncmp(tag, g_codecs[i].tag, sizeof(g_codecs[i].tag)) == 0) {
+			return i;
+		}
+	}
+
+	if (LUMP_MAXCODECS <= i) {
+		return -1;
+	}
+
+	memset(&g_codecs[i], 0, sizeof(g_codecs[i]));
+	strncpy(g_codecs[i].tag, tag, sizeof(g_codecs[i].tag));
+	g_codecs_len++;
+
+	return i;
+}
+
+/* lump_setcodec : encodes every lump written with the given tag with codec */
+int lump_setcodec(char *tag, int codec, struct codecparams_t *params)
+{
+	int i;
+
+	if (codec < 0 || CODEC_TOTAL <= codec) {
+		return -1;
+	}
+
+	i = lump_tagslot(tag);
+	if (i < 0) {
+		return -1;
+	}
+
+	g_codecs[i].codec = codec;
+	g_codecs[i].refsize = 0;
+
+	memset(&g_codecs[i].params, 0, sizeof(g_codecs[i].params));
+	if (params) {
+		g_codecs[i].params = *params;
+	}
+
+	return 0;
+}
+
+/* lump_setbrick : stores every dim sized volume written with the given tag as brick^3 bricks */
+int lump_setbrick(char *tag, ivec3_t dim, s32 brick)
+{
+	int i;
+
+	if (brick < 0) {
+		return -1;
+	}
+
+	i = lump_tagslot(tag);
+	if (i < 0) {
+		return -1;
+	}
+
+	Vec3Copy(g_codecs[i].dim, dim);
+	g_codecs[i].brick = brick;
+	g_codecs[i].refsize = 0;
+
+	return 0;
+}
+
+/* lump_readsize : reads the (decoded) size of the lump with the given tag and entry no */
+int lump_readsize(char *tag, u64 entry, size_t *size)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	*size = info.rawsize;
+
+	return 0;
+}
+
+/* lump_readinfo : reads the whole (decoded) lump info describes into dst */
+static int lump_readinfo(struct lumpinfo_t *info, void *dst)
+{
+	int rc;
+
+	// a delta needs the lumps before it, so it's decoded through the cache
+	if (info->flags & LUMP_FLAG_DELTA) {
+		rc = lump_cache(info);
+		if (rc < 0) {
+			return -1;
+		}
+
+		memcpy(dst, g_dec, info->rawsize);
+		return 0;
+	}
+
+	if (!lump_isplain(info)) {
+		return lump_decode(info, dst, NULL);
+	}
+
+	return lump_dataread(info, 0, info->size, dst);
+}
+
+/* lump_read : reads a lump into the buffer */
+int lump_read(char *tag, u64 entry, void *dst)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	return lump_readinfo(&info, dst);
+}
+
+/* lump_readvcmp : orders batched reads by where they are in the file */
+static int lump_readvcmp(const void *a, const void *b)
+{
+	const struct lumpinfo_t *x = &((const struct lumpreadv_t *)a)->info;
+	const struct lumpinfo_t *y = &((const struct lumpreadv_t *)b)->info;
+
+	return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/* lump_readv : reads a batch of lumps, looking them all up in one pass over the table */
+int lump_readv(struct lumpreq_t *req, size_t n)
+{
+	static u8 pad[LUMP_ALIGN];
+	struct sys_iovec iov[SYS_IOVMAX];
+	struct lumpreadv_t *job;
+	size_t i, j, k, found, end;
+	int niov, rc;
+
+	/*
+	 * NOTE
+	 * Lumps written one after the other, like everything setup writes, sit
+	 * one after the other in the file, save for a few bytes of alignment. So
+	 * once they're all found, runs of raw lumps come in with one vectored
+	 * read each, the padding between them going into a throwaway buffer.
+	 * Encoded lumps, and lumps in mapped files, are read one at a time.
+	 */
+
+	job = calloc(n, sizeof(*job));
+	if (job == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+		job[i].req = &req[i];
+	}
+
+	for (i = 0, found = 0; i < g_info_len && found < n; i++) {
+		for (j = 0; j < n; j++) {
+			if (!job[j].found && req[j].entry == g_info[i].entry &&
+					strncmp(req[j].tag, g_info[i].tag, sizeof(g_info[i].tag)) == 0) {
+				job[j].info = g_info[i];
+				job[j].found = 1;
+				found++;
+			}
+		}
+	}
+
+	for (i = 0, rc = 0; i < n && rc == 0; i++) {
+		if (!job[i].found || req[i].size < job[i].info.rawsize) {
+			rc = -1;
+		}
+	}
+
+	qsort(job, n, sizeof(*job), lump_readvcmp);
+
+	for (i = 0; i < n && rc == 0; i = j) {
+		if (g_lumpmap || !lump_isplain(&job[i].info) || job[i].info.flags & LUMP_FLAG_SHARDED) {
+			rc = lump_readinfo(&job[i].info, job[i].req->dst);
+			j = i + 1;
+			continue;
+		}
+
+		iov[0].base = job[i].req->dst;
+		iov[0].len = job[i].info.size;
+		niov = 1;
+
+		end = job[i].info.offset + job[i].info.size;
+
+		// keep adding on raw lumps, as long as they start right where we are
+		for (j = i + 1; j < n && niov + 2 <= SYS_IOVMAX; j++) {
+			if (!lump_isplain(&job[j].info) || job[j].info.flags & LUMP_FLAG_SHARDED || job[j].info.offset < end || end + sizeof(pad) <= job[j].info.offset) {
+				break;
+			}
+
+			if (end < job[j].info.offset) {
+				iov[niov].base = pad;
+				iov[niov].len = job[j].info.offset - end;
+				niov++;
+			}
+
+			iov[niov].base = job[j].req->dst;
+			iov[niov].len = job[j].info.size;
+			niov++;
+
+			end = job[j].info.offset + job[j].info.size;
+		}
+
+		for (k = 0, end = 0; k < (size_t)niov; k++) {
+			end += iov[k].len;
+		}
+
+		rc = sys_readv(g_lumpfile, job[i].info.offset, iov, niov) == end ? 0 : -1;
+	}
+
+	free(job);
+
+	return rc;
+}
+
+/* lump_read_range : reads len bytes, starting offset bytes into the lump */
+int lump_read_range(char *tag, u64 entry, size_t offset, size_t len, void *dst)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	if (info.rawsize < offset || info.rawsize - offset < len) {
+		return -1;
+	}
+
+	return lump_load(&info, offset, len, dst);
+}
+
+/* lump_slabbricks : reads a sub-box out of a bricked lump, touching only the bricks it overlaps */
+static int lump_slabbricks(struct lumpinfo_t *info, ivec3_t dim, ivec3_t start, ivec3_t count, f64 *dst)
+{
+	struct brickhdr_t hdr;
+	struct brickent_t ent;
+	ivec3_t grid, lo, hi, b, bstart, bcount, s, c, dstoff, srcoff;
+	size_t data;
+	u64 i;
+	int j, rc;
+
+	rc = lump_dataread(info, 0, sizeof(hdr), &hdr);
+	if (rc < 0) {
+		return -1;
+	}
+
+	for (j = 0; j < 3; j++) {
+		if (hdr.dim[j] != (u64)dim[j]) {
+			return -1;
+		}
+	}
+
+	if (hdr.brick == 0 || hdr.bricks != brick_grid(dim, hdr.brick, grid)) {
+		return -1;
+	}
+
+	rc = lump_scratch((u8 **)&g_brick, &g_brick_cap, sizeof(f64) * hdr.brick * (u64)hdr.brick * hdr.brick);
+	if (rc < 0) {
+		return -1;
+	}
+
+	data = sizeof(hdr) + hdr.bricks * sizeof(ent);
+
+	// a short (or corrupt) lump can't even hold its own index
+	if (info->size < data) {
+		return -1;
+	}
+
+	for (j = 0; j < 3; j++) {
+		lo[j] = start[j] / hdr.brick;
+		hi[j] = (start[j] + count[j] - 1) / hdr.brick;
+	}
+
+	for (b[2] = lo[2]; b[2] <= hi[2]; b[2]++) {
+		for (b[1] = lo[1]; b[1] <= hi[1]; b[1]++) {
+			for (b[0] = lo[0]; b[0] <= hi[0]; b[0]++) {
+				i = (b[2] * (u64)grid[1] + b[1]) * grid[0] + b[0];
+
+				rc = lump_dataread(info, sizeof(hdr) + i * sizeof(ent), sizeof(ent), &ent);
+				if (rc < 0 || info->size - data < ent.offset || info->size - data - ent.offset < ent.size) {
+					return -1;
+				}
+
+				rc = lump_scratch(&g_enc, &g_enc_cap, ent.size);
+				if (rc < 0) {
+					return -1;
+				}
+
+				rc = lump_dataread(info, data + ent.offset, ent.size, g_enc);
+				if (rc < 0) {
+					return -1;
+				}
+
+				brick_extent(&hdr, i, bstart, bcount);
+
+				rc = brick_decodeone(g_brick, sizeof(f64) * bcount[0] * (u64)bcount[1] * bcount[2], &ent, g_enc);
+				if (rc < 0) {
+					return -1;
+				}
+
+				// only the part of the brick inside the box gets copied out
+				for (j = 0; j < 3; j++) {
+					s[j] = start[j] < bstart[j] ? bstart[j] : start[j];
+					c[j] = (start[j] + count[j] < bstart[j] + bcount[j] ? start[j] + count[j] : bstart[j] + bcount[j]) - s[j];
+					dstoff[j] = s[j] - start[j];
+					srcoff[j] = s[j] - bstart[j];
+				}
+
+				brick_copy(dst, count, dstoff, g_brick, bcount, srcoff, c);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* lump_read_slab : reads the sub-box [start, start + count) of an f64 volume */
+int lump_read_slab(char *tag, u64 entry, ivec3_t dim, ivec3_t start, ivec3_t count, f64 *dst)
+{
+	struct lumpinfo_t info;
+	size_t run, elem;
+	s64 y, z;
+	int i, rc;
+
+	/*
+	 * NOTE
+	 * The volume is stored x fastest, then y, then z, and dst gets the box
+	 * packed the same way. We figure out the longest run of the box that is
+	 * contiguous on disk, and issue exactly one read per run:
+	 *
+	 *   full x rows and full y columns -> 1 read for the whole box
+	 *   full x rows                    -> 1 read per z plane
+	 *   otherwise                      -> 1 read per (y, z) line
+	 *
+	 * Bricked volumes read (and decode) each brick the box overlaps once.
+	 */
+
+	for (i = 0; i < 3; i++) {
+		if (start[i] < 0 || count[i] <= 0 || dim[i] < start[i] + count[i]) {
+			return -1;
+		}
+	}
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	if (info.rawsize != sizeof(f64) * dim[0] * (u64)dim[1] * dim[2]) {
+		return -1;
+	}
+
+	if (info.flags & LUMP_FLAG_BRICKED) {
+		return lump_slabbricks(&info, dim, start, count, dst);
+	}
+
+	if (count[0] == dim[0] && count[1] == dim[1]) {
+		elem = (start[2] * (u64)dim[1]) * dim[0];
+		run = count[0] * (u64)count[1] * count[2];
+		return lump_load(&info, sizeof(f64) * elem, sizeof(f64) * run, dst);
+	}
+
+	if (count[0] == dim[0]) {
+		run = count[0] * (u64)count[1];
+
+		for (z = 0; z < count[2]; z++, dst += run) {
+			elem = ((start[2] + z) * (u64)dim[1] + start[1]) * dim[0];
+			rc = lump_load(&info, sizeof(f64) * elem, sizeof(f64) * run, dst);
+			if (rc < 0) {
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	run = count[0];
+
+	for (z = 0; z < count[2]; z++) {
+		for (y = 0; y < count[1]; y++, dst += run) {
+			elem = ((start[2] + z) * (u64)dim[1] + start[1] + y) * dim[0] + start[0];
+			rc = lump_load(&info, sizeof(f64) * elem, sizeof(f64) * run, dst);
+			if (rc < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* lump_view : points ptr at the lump's data inside the mapping, no copying */
+int lump_view(char *tag, u64 entry, const void **ptr, size_t *size)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	// views only exist when the file was opened with lump_openmap
+	if (g_lumpmap == NULL) {
+		return -1;
+	}
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// there's nothing to point at for encoded or striped lumps, they have to be read
+	if (!lump_isplain(&info) || info.flags & LUMP_FLAG_SHARDED) {
+		return -1;
+	}
+
+	if (g_lumpmaplen < info.offset || g_lumpmaplen - info.offset < info.size) {
+		return -1;
+	}
+
+	*ptr = g_lumpmap + info.offset;
+
+	if (size) {
+		*size = info.size;
+	}
+
+	return 0;
+}
+
+/* lump_advise : passes a paging hint (SYS_ADVISE_*) for a mapped lump */
+int lump_advise(char *tag, u64 entry, int advice)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	if (g_lumpmap == NULL) {
+		return -1;
+	}
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0 || info.flags & LUMP_FLAG_SHARDED) {
+		return -1;
+	}
+
+	if (g_lumpmaplen < info.offset || g_lumpmaplen - info.offset < info.size) {
+		return -1;
+	}
+
+	// hints are for the bytes on disk, encoded or not
+	return sys_madvise(g_lumpmap + info.offset, info.size, advice);
+}
+
+/* lump_put : lump_write, without the timer */
+static int lump_put(char *tag, size_t size, void *src, u64 *entry)
+{
+	struct lumpinfo_t info;
+	size_t i, len;
+	u8 *ref;
+	u64 flags;
+	int codec, rc, delta, c;
+
+	assert(strlen(tag) <= sizeof(info.tag));
+
+	if (g_readonly) {
+		return -1;
+	}
+
+	if (g_slot_len <= g_info_len) {
+		rc = lump_grow();
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	// fill out our info record
+	memset(&info, 0, sizeof(info));
+
+	strncpy(info.tag, tag, sizeof(info.tag));
+	info.offset = LUMP_ALIGNUP(g_header.size);
+	info.size = size;
+	info.codec = CODEC_NONE;
+	info.rawsize = size;
+	lump_getnumentries(tag, &info.entry);
+
+	for (i = 0, c = -1; i < g_codecs_len; i++) {
+		if (strncmp(tag, g_codecs[i].tag, sizeof(g_codecs[i].tag)) == 0) {
+			info.codec = g_codecs[i].codec;
+			c = i;
+		}
+	}
+
+	// volumes the size the tag's bricks were set up for get bricked, and
+	// every brick is encoded on its own, so there's no delta to take
+	if (0 <= c && 0 < g_codecs[c].brick && size == sizeof(f64) * g_codecs[c].dim[0] * (u64)g_codecs[c].dim[1] * g_codecs[c].dim[2]) {
+		rc = lump_scratch(&g_enc, &g_enc_cap, brick_bound(info.codec, g_codecs[c].dim, g_codecs[c].brick));
+		if (rc < 0) {
+			return -1;
+		}
+
+		len = brick_encode(info.codec, &g_codecs[c].params, g_enc, g_enc_cap, src, g_codecs[c].dim, g_codecs[c].brick, &codec, &info.maxerr);
+		if (len == 0) {
+			return -1;
+		}
+
+		info.size = len;
+		info.codec = codec;
+		info.flags = LUMP_FLAG_BRICKED;
+		src = g_enc;
+
+		g_codecs[c].refsize = 0;
+	} else if (info.codec != CODEC_NONE) {
+		rc = lump_scratch(&g_enc, &g_enc_cap, codec_bound(info.codec, size));
+		if (rc < 0) {
+			return -1;
+		}
+
+		// with keyframes on, we keep the entry as it'll decode for the next
+		// one to be a delta from, and this one is a delta from the last, as
+		// long as that was the entry right before it
+		ref = NULL;
+		delta = 0;
+
+		if (1 < g_codecs[c].params.keyframe) {
+			delta = info.entry % g_codecs[c].params.keyframe != 0;
+			delta = delta && g_codecs[c].refsize == size && g_codecs[c].refentry + 1 == info.entry;
+
+			g_codecs[c].refsize = 0;
+
+			rc = lump_scratch(&g_codecs[c].ref, &g_codecs[c].ref_cap, size);
+			if (rc < 0) {
+				return -1;
+			}
+
+			ref = g_codecs[c].ref;
+		}
+
+		// anything the codec can't make smaller is better off stored raw
+		// the codec gets the final say in how it encoded things, as the lossy
+		// one has to fall back to lossless when there's no usable error bound
+		len = codec_encode(info.codec, &g_codecs[c].params, g_enc, g_enc_cap, src, size, ref, delta);
+		if (0 < len && len < size && codec_getinfo(g_enc, len, &codec, &info.maxerr, &flags) == 0) {
+			info.size = len;
+			info.codec = codec;
+			info.flags = flags & CODEC_FLAG_DELTA ? LUMP_FLAG_DELTA : 0;
+		} else {
+			info.codec = CODEC_NONE;
+			if (ref) {
+				memcpy(ref, src, size);
+			}
+		}
+
+		if (ref) {
+			g_codecs[c].refsize = size;
+			g_codecs[c].refentry = info.entry;
+		}
+
+		if (info.codec != CODEC_NONE) {
+			src = g_enc;
+		}
+	}
+
+	if (1 < g_header.shards && LUMP_SHARDMIN <= info.size) {
+		info.flags |= LUMP_FLAG_SHARDED;
+	}
+
+	// the data goes down first, then the info record that points at it, and
+	// the header last, so the file never references data that isn't there
+	rc = lump_datawrite(&info, src);
+	if (rc < 0) {
+		return -1;
+	}
+
+	rc = lump_rawwrite(g_slot[g_info_len], sizeof(info), &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	g_header.size = info.offset + (info.flags & LUMP_FLAG_SHARDED ? lump_stripe(info.size) : info.size);
+	g_header.lumps++;
+
+	rc = lump_rawwrite(0, sizeof(g_header), &g_header);
+	if (rc < 0) {
+		return -1;
+	}
+
+	c_resize(&g_info, &g_info_len, &g_info_cap, sizeof(*g_info));
+	g_info[g_info_len++] = info;
+
+	if (entry) {
+		*entry = info.entry;
+	}
+
+	return 0;
+}
+
+/* lump_write : writes the given lump into the lump system */
+int lump_write(char *tag, size_t size, void *src, u64 *entry)
+{
+	int rc;
+
+	prof_begin(PROF_LUMP);
+	rc = lump_put(tag, size, src, entry);
+	prof_end(PROF_LUMP);
+
+	return rc;
+}
+
+/* lump_write_range : overwrites len bytes in place, starting offset bytes into the lump */
+int lump_write_range(char *tag, u64 entry, size_t offset, size_t len, void *src)
+{
+	struct lumpinfo_t info;
+	int rc;
+
+	if (g_readonly) {
+		return -1;
+	}
+
+	rc = lump_find(tag, entry, &info);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// lumps can't change size, only their contents, and only when they're raw
+	if (!lump_isplain(&info) || info.size < offset || info.size - offset < len) {
+		return -1;
+	}
+
+	if (info.flags & LUMP_FLAG_SHARDED) {
+		return lump_shardio(&info, offset, len, src, 1);
+	}
+
+	return lump_rawwrite(info.offset + offset, len, src);
+}
+
+/* lump_truncate : drops every lump after the first 'lumps' lumps in the table */
+int lump_truncate(u64 lumps)
+{
+	int rc;
+
+	/*
+	 * NOTE
+	 * Only the lump count goes backwards. The file size stays where it is,
+	 * because table extents can live past the last lump's data, and new
+	 * lumps would otherwise be written on top of them. The dropped lumps'
+	 * space is just lost.
+	 */
+
+	if (g_readonly) {
+		return -1;
+	}
+
+	if (g_header.lumps < lumps) {
+		return -1;
+	}
+
+	g_header.lumps = lumps;
+	g_header.gen++;
+
+	rc = lump_rawwrite(0, sizeof(g_header), &g_header);
+	if (rc < 0) {
+		return -1;
+	}
+
+	g_info_len = lumps;
+
+	// whatever we decoded or wrote last might not be there anymore
+	g_decoffset = 0;
+	lump_dropref();
+
+	return 0;
+}
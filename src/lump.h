@@ -8,27 +8,91 @@
  * The Lump System MK2
  */
 
+#define LUMP_VERSION 1 // bumped whenever the header, extent or lumpinfo_t layouts change
+
+// what opening a lump file returns, when it's more than just -1
+#define LUMP_ENOFILE  (-2) // there's no such file, or its header isn't written yet
+#define LUMP_EFORMAT  (-3) // it isn't a lump file at all
+#define LUMP_EVERSION (-4) // it's a lump file, in a layout this build can't read
+
 struct lumpheader_t {
 	u32 magic;
-	u32 flags;
+	u32 version; // LUMP_VERSION, files from before there was one have 0 here
 	u64 ts_created;
 	u64 size;
-	u64 lumps; // how many lumpinfo_t's appear in the file, right after this
+	u64 lumps;  // how many lumpinfo_t's are in the table
+	u64 table;  // offset of the first lumpextent_t in the table's chain
+	u64 gen;    // bumped whenever lumps are dropped, so readers reload their table
+	u64 shards; // data files big lumps are striped over, 0 if they aren't
+	u32 flags;
+	u32 pad;
 };
 
+struct lumpextent_t {
+	u64 next; // offset of the next extent, 0 if this is the last one
+	u64 cap;  // how many lumpinfo_t's follow, right after this
+};
+
+#define LUMP_FLAG_DELTA   0x01 // encoded as a delta from the previous entry of the tag
+#define LUMP_FLAG_BRICKED 0x02 // a volume stored as bricks (see brick.h)
+#define LUMP_FLAG_SHARDED 0x04 // striped over the shards, instead of in the lump file
+
 struct lumpinfo_t {
 	char tag[8];
 	u64  offset;
-	u64  size;
+	u64  size;    // bytes on disk
 	u64  entry;
+	u32  codec;   // CODEC_* the data was encoded with
+	u32  flags;   // LUMP_FLAG_*
+	u64  rawsize; // bytes once decoded
+	f64  maxerr;  // largest error a lossy codec let through, 0 if exact
+};
+
+struct lump_t;
+
+struct lumpreq_t {
+	char *tag;
+	u64 entry;
+	void *dst;
+	size_t size; // bytes dst has room for
 };
 
 /* lump_open : opens the given file as the lump file we're using */
 int lump_open(char *file);
 
+/* lump_setshards : stripes the big lumps of a new lump file over n data files */
+int lump_setshards(int n);
+
+/* lump_reopen : opens an existing lump file, to append more lumps to it */
+int lump_reopen(char *file);
+
+/* lump_openmap : opens an existing lump file, read only, and maps it */
+int lump_openmap(char *file);
+
+/* lump_openfollow : opens an existing lump file, read only, to follow while it's written */
+int lump_openfollow(char *file);
+
+/* lump_refresh : picks up the lumps published since the table was last loaded */
+int lump_refresh(void);
+
+/* lump_ismapped : returns true if the lump file was opened with lump_openmap */
+int lump_ismapped(void);
+
 /* lump_close : closes the lump file */
 int lump_close();
 
+/* lump_detach : sets the open lump file aside, leaving none open, so another one can be */
+struct lump_t *lump_detach(void);
+
+/* lump_swap : swaps the open lump file (or none) with one that was set aside */
+void lump_swap(struct lump_t *lump);
+
+/* lump_release : closes a lump file that was set aside */
+int lump_release(struct lump_t *lump);
+
+/* lump_strerror : describes what went wrong opening a lump file, given what the open returned */
+char *lump_strerror(int rc);
+
 /* lump_getheader : gets the lump system's header */
 int lump_getheader(struct lumpheader_t *header);
 
@@ -38,14 +102,41 @@ int lump_getinfo(struct lumpinfo_t *info, u64 index);
 /* lump_getnumentries : gets the number of entries for the given tag */
 int lump_getnumentries(char *tag, u64 *entries);
 
-/* lump_readsize : reads the size of the lump with the given tag and entry no */
+/* lump_setcodec : encodes every lump written with the given tag with codec */
+int lump_setcodec(char *tag, int codec, struct codecparams_t *params);
+
+/* lump_setbrick : stores every dim sized volume written with the given tag as brick^3 bricks */
+int lump_setbrick(char *tag, ivec3_t dim, s32 brick);
+
+/* lump_readsize : reads the (decoded) size of the lump with the given tag and entry no */
 int lump_readsize(char *tag, u64 entry, size_t *size);
 
 /* lump_read : reads a lump into the buffer */
 int lump_read(char *tag, u64 entry, void *dst);
 
+/* lump_readv : reads a batch of lumps, looking them all up in one pass over the table */
+int lump_readv(struct lumpreq_t *req, size_t n);
+
+/* lump_read_range : reads len bytes, starting offset bytes into the lump */
+int lump_read_range(char *tag, u64 entry, size_t offset, size_t len, void *dst);
+
+/* lump_read_slab : reads the sub-box [start, start + count) of an f64 volume */
+int lump_read_slab(char *tag, u64 entry, ivec3_t dim, ivec3_t start, ivec3_t count, f64 *dst);
+
+/* lump_view : points ptr at the lump's data inside the mapping, no copying (not for encoded lumps) */
+int lump_view(char *tag, u64 entry, const void **ptr, size_t *size);
+
+/* lump_advise : passes a paging hint (SYS_ADVISE_*) for a mapped lump */
+int lump_advise(char *tag, u64 entry, int advice);
+
 /* lump_write : writes the given lump into the lump system */
 int lump_write(char *tag, size_t size, void *src, u64 *entry);
 
+/* lump_write_range : overwrites len bytes in place, starting offset bytes into the lump */
+int lump_write_range(char *tag, u64 entry, size_t offset, size_t len, void *src);
+
+/* lump_truncate : drops every lump after the first 'lumps' lumps in the table */
+int lump_truncate(u64 lumps);
+
 #endif // LUMP_H
 
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
@@ -28,16 +29,49 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <fcntl.h>
+#include <signal.h>
 
 #define COMMON_IMPLEMENTATION
 #include "common.h"
 
+#include "prof.h"
+#include "trace.h"
+
+// molt.h's phases get timed into the PROFILE lump (see prof.h)
+#define MOLT_PROF_BEGIN(phase) prof_begin(PROF_##phase)
+#define MOLT_PROF_END(phase) prof_end(PROF_##phase)
+
 #define MOLT_IMPLEMENTATION
 #include "molt.h"
 
 #include "config.h"
+#include "chkpt.h"
+#include "codec.h"
+#include "init.h"
+#include "live.h"
 #include "lump.h"
+#include "output.h"
+#include "restart.h"
 #include "sys.h"
+#include "wcache.h"
+
+/*
+ * NOTE
+ * An initial condition that's already sitting in a file, either as a raw grid
+ * of f64s, or as a volume in another lump file. Raw files are mapped, and read
+ * right out of the mapping. Lump files can be encoded, bricked or sharded, so
+ * those get read in whole, before our own lump file is opened.
+ */
+struct initfile_t {
+	char *path;
+	char tag[8];   // lump files: the volume to take, and which entry, -1 for the last
+	s64 entry;
+	ivec3_t dim;   // the source grid's size, along x, y and z
+	char order[4]; // raw files: the axes as they're laid out, fastest first
+	f64 *data;     // the source volume, once it's open
+	sys_file *fd;  // raw files stay mapped until setup's done with them
+	size_t maplen;
+};
 
 struct user_cfg_t {
 	s64 isset;
@@ -61,7 +95,27 @@ struct user_cfg_t {
 	f64 alpha;
 	char *initamp;
 	char *initvel;
+	char *initamp_lib;
+	char *initvel_lib;
+	s64 init_binary; // init programs speak the binary protocol, not the text one
+	struct initfile_t initamp_file;
+	struct initfile_t initvel_file;
+	char *weightcache;
 	char *libname;
+	s64 chkpt_steps;
+	f64 chkpt_secs;
+	s64 chkpt_keep;
+	s64 compress;
+	f64 compress_abserr;
+	f64 compress_relerr;
+	s64 compress_keyframe;
+	s64 brick_size;
+	s64 output_every;
+	char *live;
+	s64 live_slots;
+	s64 shards;
+	struct outstream_t *streams;
+	size_t streams_len, streams_cap;
 	u32 flags;
 };
 
@@ -73,11 +127,73 @@ struct configthreadargs_t {
 	f64 *vol;
 };
 
+/*
+ * NOTE
+ * An init library exports molt_initamp_fill and/or molt_initvel_fill. It gets
+ * handed n points, as x, y, z triples in xyz (already scaled into space), and
+ * the extent of the whole domain, and writes n values into out. We call it a
+ * plane at a time, from as many threads as we've got cores, so it has to be
+ * fine with that.
+ */
+typedef void (*initfill_func)(const f64 *xyz, f64 *out, u64 n, const f64 *extent);
+
+struct initlibjob_t {
+	initfill_func fill;
+	f64 *vol;
+	ivec3_t dim;
+	dvec3_t fdim;
+	f64 scale;
+	int thread;
+	int threads;
+};
+
+struct weightjob_t {
+	f64 nu;
+	f64 *wl;
+	f64 *wr;
+	f64 *phi;
+	f64 *work;
+	s32 nulen;
+	s32 orderm;
+	s32 start;
+	s32 stop;
+};
+
+/*
+ * NOTE
+ * Everything setup works out that the simulation needs right away. It all
+ * still goes into the lump file, but the buffers get handed straight to the
+ * simulation too, so a fresh run doesn't read back what it just wrote.
+ * Restarts don't run setup, leave vel NULL, and sim_load reads everything
+ * from the file like it always has.
+ */
+struct simload_t {
+	struct molt_cfg_t config;
+	pdvec6_t vw;
+	pdvec6_t ww;
+	f64 *vel;
+	f64 *amp;
+};
+
+struct setupjob_t {
+	struct user_cfg_t *usercfg;
+	struct simload_t *load;
+	struct sys_thread *thread;
+	int command; // COMMAND_MODE_* for an initial condition, COMMAND_MODE_NONE for an axis' weights
+	int axis;
+	int rc;
+};
+
 struct simtimeinfo_t {
 	struct timeval start;
 	struct timeval end;
 };
 
+struct outrows_t {
+	u8 *buf;  // a stats or probe stream's rows that haven't been written yet
+	u64 rows;
+};
+
 /* hunklog_1 : creates a readable log of the 1d data at p with dimensions dim */
 s32 hunklog_1(char *file, int line, char *msg, s32 dim, f64 *p);
 /* hunklog_2 : creates a readable log of the 2d data at p with dimensions dim */
@@ -86,6 +202,8 @@ s32 hunklog_2(char *file, int line, char *msg, s32 dim[2], f64 *p);
 s32 hunklog_3(char *file, int line, char *msg, s32 dim[3], f64 *p);
 /* hunklog_3ord : hunk log in 3d; however, orders vars by ascii vals in ord */
 s32 hunklog_3ord(char *file, int line, char *msg, ivec3_t dim, f64 *p, char ord[3]);
+/* hunklog_3slab : logs a packed sub-box of a volume, with absolute coordinates */
+s32 hunklog_3slab(char *file, int line, char *msg, ivec3_t start, ivec3_t count, f64 *p);
 
 #define LOG1D(p, d, m) hunklog_1(__FILE__, __LINE__, (m), (d), (p))
 #define LOG2D(p, d, m) hunklog_2(__FILE__, __LINE__, (m), (d), (p))
@@ -94,6 +212,9 @@ s32 hunklog_3ord(char *file, int line, char *msg, ivec3_t dim, f64 *p, char ord[
 #define LOG3DORD(p, d, m, o) \
 		hunklog_3ord(__FILE__, __LINE__, (m), (d), (p), (o))
 
+#define LOG3DSLAB(p, s, c, m) \
+		hunklog_3slab(__FILE__, __LINE__, (m), (s), (c), (p))
+
 #define LOG_NEWLINESEP 1
 #define LOG_FLOATFMT "% 4.5e"
 // #define LOG_FLOATFMT "%.15lf"
@@ -102,33 +223,104 @@ s32 hunklog_3ord(char *file, int line, char *msg, ivec3_t dim, f64 *p, char ord[
 int parse_config(struct user_cfg_t *usercfg, char *file);
 
 /* do_simulation : actually does the simulating */
-int do_simulation();
+int do_simulation(struct user_cfg_t *usercfg, u32 flags, struct simload_t *load);
 
 /* do_custom_simulation : actually does the simulating, with custom functions */
-int do_custom_simulation(void *lib);
+int do_custom_simulation(struct user_cfg_t *usercfg, void *lib, u32 flags, struct simload_t *load);
+
+/* sim_load : takes what setup left in load, or reads the config, weights and initial conditions */
+int sim_load(struct simload_t *load, struct molt_cfg_t *config, pdvec6_t vw, pdvec6_t ww, f64 **vel, f64 **amp);
+
+/* sim_freeload : frees whatever's still in load */
+void sim_freeload(struct simload_t *load);
+
+/* setup : sets up the simulation, leaving what the simulation needs in load */
+int setup(struct user_cfg_t *usercfg, struct simload_t *load);
 
-/* setup : sets up the simulation */
-int setup(struct user_cfg_t *usercfg);
+/* setup_thread : runs one of setup's jobs */
+void *setup_thread(void *arg);
 
-/* setup_config : setup the config lump */
-int setup_config(struct user_cfg_t *ucfg);
+/* setup_makeconfig : builds the simulation config from the user's config */
+void setup_makeconfig(struct user_cfg_t *ucfg, struct molt_cfg_t *config);
 
-/* setup_vweight : sets up the v weights */
-int setup_vweight();
+/* restart_validate : checks that the lump file can be picked up where it left off */
+int restart_validate(struct user_cfg_t *usercfg);
 
-/* setup_wweight : sets up the w weights */
-int setup_wweight();
+/* setup_lumpcodecs : sets up how volumes of the given size, and the output streams, get encoded and laid out */
+int setup_lumpcodecs(struct user_cfg_t *usercfg, ivec3_t dim, s32 brick, struct outstream_t *streams, s64 nstreams);
 
-/* setup_initcommand : runs the command specified in the config, if found */
-int setup_initcommand(struct user_cfg_t *usercfg, int command);
+/* setup_outputs : checks the config's output streams, and writes them (and their first entries) out */
+int setup_outputs(struct user_cfg_t *usercfg, struct simload_t *load);
 
+/* sim_loadoutputs : loads the lump file's output streams, returns how many there are */
+s64 sim_loadoutputs(struct outstream_t **streams);
+
+/* sim_writeoutputs : writes an entry for every stream that wants one at this step */
+int sim_writeoutputs(struct outstream_t *streams, s64 nstreams, ivec3_t dim, f64 *vol, u64 step, f64 *buf);
+
+/* sim_statsdue : returns true if a stats stream wants a row at this step */
+int sim_statsdue(struct outstream_t *streams, s64 nstreams, u64 step);
+
+/* sim_addrows : adds a row to every stats and probe stream that wants one, writing them out when it's time */
+int sim_addrows(struct outstream_t *streams, struct outrows_t *rows, s64 nstreams, struct outstat_t *stat, f64 *vol, ivec3_t dim, u64 step);
+
+/* sim_flushrows : writes every stream's pending rows out as a lump */
+int sim_flushrows(struct outstream_t *streams, struct outrows_t *rows, s64 nstreams);
+
+/* sim_freerows : frees the row buffers */
+void sim_freerows(struct outrows_t *rows, s64 nstreams);
+
+/* rebrick : copies every lump in src into a new lump file dst, re-laid out per the config */
+int rebrick(struct user_cfg_t *usercfg, char *src, char *dst);
+
+/* setup_weights : works out the v and w weights for one axis, going through the weight cache in cachedir if there is one */
+int setup_weights(struct molt_cfg_t *config, char *cachedir, int axis, f64 *vl, f64 *vr, f64 *wl, f64 *wr);
+
+/* setup_makeweights : molt_get_exp_weights, with the rows split over every core */
+void setup_makeweights(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm);
+/* setup_makeweights_thread : makes one job's rows of weights */
+void *setup_makeweights_thread(void *arg);
+
+/* setup_initcommand : fills vol with the initial condition from the config, if there is one */
+int setup_initcommand(struct user_cfg_t *usercfg, struct molt_cfg_t *config, int command, f64 *vol);
+
+/* setup_initbinary : runs an init program with the binary protocol, returns 0 if it doesn't speak it */
+int setup_initbinary(char *command, f64 *vol, ivec3_t dim, f64 scale);
+
+/* setup_initlib : fills vol with an init library's fill function, in z slabs over every core */
+int setup_initlib(char *libname, int command, f64 *vol, ivec3_t dim, f64 scale);
+/* setup_initlib_thread : fills one job's slab of z planes */
+void *setup_initlib_thread(void *arg);
+
+/* setup_parseinitfile : parses an initvel_file or initamp_file option, "<path> [key=value ...]" */
+int setup_parseinitfile(struct initfile_t *file, char *s, char *tag);
+/* setup_openinitfile : opens the file's volume, mapping raw files, reading lump file volumes in */
+int setup_openinitfile(struct initfile_t *file, ivec3_t grid);
+/* setup_closeinitfile : unmaps or frees the file's volume */
+void setup_closeinitfile(struct initfile_t *file);
 /* setup_customprog_write : function for threading setup */
 void *setup_customprog_write(void *arg);
 /* setup_customprog_read : function for setup reading (parent <- child) */
 void *setup_customprog_read(void *arg);
 
 /* dump_lumps : prints a dump of all the lumps in the lump system */
-int dump_lumps();
+int dump_lumps(s32 axis, s32 index);
+
+/* dump_slice : prints a single plane of a volume lump */
+int dump_slice(char *tag, u64 entry, ivec3_t dim, s32 axis, s32 index, char *msg);
+
+/* watch_live : follows a running simulation's live frame ring, printing frames as they come in */
+int watch_live(char *name, s32 axis, s32 index);
+
+/* tail_lumps : follows a lump file while it's being written, printing AMP entries as they land */
+int tail_lumps(char *file, s32 axis, s32 index);
+
+/* sim_openlive : creates the live frame ring, if the config asks for one */
+struct live_t *sim_openlive(struct user_cfg_t *usercfg, ivec3_t dim);
+/* dump_getlump : returns a view of the lump, or reads it into buf */
+f64 *dump_getlump(char *tag, u64 entry, f64 *buf);
+/* dump_rows : prints a lump of stats or probe rows */
+int dump_rows(char *tag, u64 entry, struct outstream_t *stream, char *msg);
 
 void print_help(char *prog);
 
@@ -139,29 +331,18 @@ enum {
 	COMMAND_MODE_TOTAL
 };
 
-#define MOLTSTR_CONFIG "CONFIG"
-#define MOLTSTR_VLX    "VLX"
-#define MOLTSTR_VRX    "VRX"
-#define MOLTSTR_VLY    "VLY"
-#define MOLTSTR_VRY    "VRY"
-#define MOLTSTR_VLZ    "VLZ"
-#define MOLTSTR_VRZ    "VRZ"
-#define MOLTSTR_WLX    "WLX"
-#define MOLTSTR_WRX    "WRX"
-#define MOLTSTR_WLY    "WLY"
-#define MOLTSTR_WRY    "WRY"
-#define MOLTSTR_WLZ    "WLZ"
-#define MOLTSTR_WRZ    "WRZ"
-#define MOLTSTR_VEL    "VEL"
-#define MOLTSTR_AMP    "AMP"
-#define MOLTSTR_TIME   "TIME"
-
-#define USAGE "USAGE : %s [--config <config>] [--custom <customlib>] [--nosim] [-v] [-h] outfile\n"
-
-#define FLAG_VERBOSE 0x01
-#define FLAG_SIM     0x02
-#define FLAG_CUSTOM  0x04
-#define FLAG_USERCFG 0x08
+#define USAGE "USAGE : %s [--config <config>] [--custom <customlib>] [--nosim] [--restart] [--dump] [--slice <x|y|z>=<n>] [--rebrick <infile>] [--watch] [--tail] [--trace <file>] [--counters] [-v] [-h] outfile\n"
+
+#define FLAG_VERBOSE  0x01
+#define FLAG_SIM      0x02
+#define FLAG_CUSTOM   0x04
+#define FLAG_USERCFG  0x08
+#define FLAG_DUMP     0x10
+#define FLAG_RESTART  0x20
+#define FLAG_REBRICK  0x40
+#define FLAG_WATCH    0x80
+#define FLAG_TAIL     0x100
+#define FLAG_COUNTERS 0x200
 
 #define DEFAULT_FLAGS (FLAG_SIM)
 
@@ -171,10 +352,29 @@ int main(int argc, char **argv)
 	u32 flags;
 	void *lib;
 	struct user_cfg_t usercfg;
-	char *usercfgfile;
+	struct molt_cfg_t config;
+	struct simload_t load;
+	ivec3_t dim;
+	struct outstream_t *streams;
+	s64 nstreams;
+	char *usercfgfile, *rebrickfile, *tracefile;
+	s32 slice_axis, slice_index;
 	int rc;
 
 	memset(&usercfg, 0, sizeof usercfg);
+	memset(&load, 0, sizeof load);
+
+#ifdef SIGPIPE
+	// an init program that quits early shouldn't take us with it, writes to it just fail
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	usercfg.output_every = 1;
+
+	slice_axis = -1;
+	slice_index = 0;
+
+	tracefile = NULL;
 
 	flags = DEFAULT_FLAGS;
 	targc = argc;
@@ -190,6 +390,32 @@ int main(int argc, char **argv)
 			flags |= FLAG_CUSTOM;
 			usercfg.libname = strdup(*(++targv));
 			targc--;
+		} else if (strcmp(s, "-restart") == 0) {
+			flags |= FLAG_RESTART;
+		} else if (strcmp(s, "-dump") == 0) {
+			flags |= FLAG_DUMP;
+		} else if (strcmp(s, "-watch") == 0) {
+			flags |= FLAG_WATCH;
+		} else if (strcmp(s, "-tail") == 0) {
+			flags |= FLAG_TAIL;
+		} else if (strcmp(s, "-rebrick") == 0) {
+			flags |= FLAG_REBRICK;
+			rebrickfile = *(++targv);
+			targc--;
+		} else if (strcmp(s, "-counters") == 0) {
+			flags |= FLAG_COUNTERS;
+		} else if (strcmp(s, "-trace") == 0) {
+			tracefile = *(++targv);
+			targc--;
+		} else if (strcmp(s, "-slice") == 0) {
+			s = *(++targv);
+			targc--;
+			if (!s || s[0] < 'x' || 'z' < s[0] || s[1] != '=') {
+				fprintf(stderr, "--slice expects <x|y|z>=<index>\n");
+				return 1;
+			}
+			slice_axis = s[0] - 'x';
+			slice_index = atoi(s + 2);
 		} else if (strcmp(s, "-config") == 0) {
 			flags |= FLAG_USERCFG;
 			usercfgfile = *(++targv);
@@ -216,11 +442,58 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
+	if (flags & FLAG_DUMP) { // map an existing lump file and print it
+		rc = lump_openmap(targv[0]);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't map lump file '%s', %s\n", targv[0], lump_strerror(rc));
+			return 1;
+		}
+
+		rc = dump_lumps(slice_axis, slice_index);
+
+		lump_close();
+
+		return rc < 0;
+	}
+
+	if (flags & FLAG_WATCH) { // follow a running simulation, outfile is the live ring's name
+		rc = watch_live(targv[0], slice_axis, slice_index);
+
+		return rc < 0;
+	}
+
+	if (flags & FLAG_TAIL) { // follow a lump file while a run writes it
+		rc = tail_lumps(targv[0], slice_axis, slice_index);
+
+		return rc < 0;
+	}
+
 	if (flags & FLAG_USERCFG) { // read and parse our user config
 		usercfg.flags = flags;
 		parse_config(&usercfg, usercfgfile);
 	}
 
+	if (flags & FLAG_REBRICK) { // copy an existing lump file, with its volumes re-laid out
+		rc = rebrick(&usercfg, rebrickfile, targv[0]);
+
+		return rc < 0;
+	}
+
+	if (tracefile) { // everything from here on, setup included, shows up in the trace
+		rc = trace_open(tracefile, TRACE_EVENTS);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't start tracing into '%s'\n", tracefile);
+			exit(1);
+		}
+	}
+
+	if (flags & FLAG_COUNTERS) { // they count this thread, which is the one that steps
+		rc = prof_counteropen();
+		if (rc < 0) {
+			fprintf(stderr, "WRN : no hardware counters here (perf_event_paranoid? a container?), only timing phases\n");
+		}
+	}
+
 	if (flags & FLAG_CUSTOM || usercfg.libname) { // open and load our custom library
 		flags |= FLAG_CUSTOM;
 
@@ -233,23 +506,75 @@ int main(int argc, char **argv)
 		}
 	}
 
-	rc = lump_open(targv[0]);
+	if (flags & FLAG_RESTART) { // pick up an existing run where it stopped
+		rc = lump_reopen(targv[0]);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't reopen lump file '%s' to restart, %s\n", targv[0], lump_strerror(rc));
+			exit(1);
+		}
+
+		rc = restart_validate(&usercfg);
+		if (rc < 0) {
+			exit(1); // the file doesn't match what we were asked to run
+		}
+	} else {
+		// volumes in other lump files have to come in before ours is opened
+		setup_makeconfig(&usercfg, &config);
+		molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
 
-	rc = setup(&usercfg);
-	if (rc < 0) {
-		exit(1); // we failed setup somehow
+		if (setup_openinitfile(&usercfg.initvel_file, dim) < 0 || setup_openinitfile(&usercfg.initamp_file, dim) < 0) {
+			exit(1);
+		}
+
+		rc = lump_open(targv[0]);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't open lump file '%s'\n", targv[0]);
+			exit(1);
+		}
+
+		rc = lump_setshards(usercfg.shards);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't make %ld shards for lump file '%s'\n", usercfg.shards, targv[0]);
+			exit(1);
+		}
+
+		rc = setup(&usercfg, &load);
+
+		setup_closeinitfile(&usercfg.initvel_file);
+		setup_closeinitfile(&usercfg.initamp_file);
+
+		if (rc < 0) {
+			exit(1); // we failed setup somehow
+		}
 	}
 
+	lump_read(MOLTSTR_CONFIG, 0, &config);
+	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
+
+	nstreams = sim_loadoutputs(&streams);
+
+	setup_lumpcodecs(&usercfg, dim, usercfg.brick_size, streams, nstreams);
+
+	free(streams);
+
 	if (flags & FLAG_SIM) {
 		if (flags & FLAG_CUSTOM) {
-			do_custom_simulation(lib);
+			do_custom_simulation(&usercfg, lib, flags, &load);
 		} else {
-			do_simulation();
+			do_simulation(&usercfg, flags, &load);
 		}
 	}
 
+	sim_freeload(&load); // only when we didn't simulate, otherwise it was handed off
+
+	if (tracefile) { // before the custom library's names for its spans are unloaded
+		trace_close();
+	}
+
+	prof_counterclose();
+
 	if (flags & FLAG_VERBOSE) {
-		dump_lumps();
+		dump_lumps(slice_axis, slice_index);
 	}
 
 	if (flags & FLAG_CUSTOM) {
@@ -261,89 +586,185 @@ int main(int argc, char **argv)
 	free(usercfg.libname);
 	free(usercfg.initamp);
 	free(usercfg.initvel);
+	free(usercfg.initamp_lib);
+	free(usercfg.initvel_lib);
+	free(usercfg.initamp_file.path);
+	free(usercfg.initvel_file.path);
+	free(usercfg.weightcache);
+	free(usercfg.streams);
+	free(usercfg.live);
+
+	return 0;
+}
+
+/* sim_openlive : creates the live frame ring, if the config asks for one */
+struct live_t *sim_openlive(struct user_cfg_t *usercfg, ivec3_t dim)
+{
+	struct live_t *live;
+
+	if (usercfg->live == NULL) {
+		return NULL;
+	}
+
+	live = live_create(usercfg->live, dim, 0 < usercfg->live_slots ? usercfg->live_slots : MOLT_LIVE_SLOTS);
+	if (live == NULL) {
+		fprintf(stderr, "WRN : couldn't create the live frame ring '%s', running without it\n", usercfg->live);
+	}
+
+	return live;
+}
+
+/* sim_statsdue : returns true if a stats stream wants a row at this step */
+int sim_statsdue(struct outstream_t *streams, s64 nstreams, u64 step)
+{
+	s64 i;
+
+	for (i = 0; i < nstreams; i++) {
+		if (streams[i].kind == OUTPUT_STATS && output_due(&streams[i], step)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* sim_addrows : adds a row to every stats and probe stream that wants one, writing them out when it's time */
+int sim_addrows(struct outstream_t *streams, struct outrows_t *rows, s64 nstreams, struct outstat_t *stat, f64 *vol, ivec3_t dim, u64 step)
+{
+	struct outprobe_t probe;
+	size_t rowsize;
+	s64 i;
+	int full;
+
+	/*
+	 * NOTE
+	 * Rows pile up in memory, and get written out as one lump when a stream
+	 * has MOLT_OUTPUT_ROWS of them. They're also written whenever AMP is, and
+	 * before every checkpoint, so restarting from either of those never finds
+	 * rows missing from before it, or rows from after it.
+	 */
+
+	for (i = 0, full = 0; i < nstreams; i++) {
+		rowsize = output_rowsize(&streams[i]);
+		if (rowsize == 0 || !output_due(&streams[i], step)) {
+			continue;
+		}
+
+		if (rows[i].buf == NULL) {
+			rows[i].buf = malloc(MOLT_OUTPUT_ROWS * rowsize);
+			if (rows[i].buf == NULL) {
+				return -1;
+			}
+		}
+
+		if (streams[i].kind == OUTPUT_STATS) {
+			stat->step = step;
+			memcpy(rows[i].buf + rows[i].rows * rowsize, stat, rowsize);
+		} else {
+			probe.step = step;
+			probe.value = vol[(streams[i].start[2] * (u64)dim[1] + streams[i].start[1]) * dim[0] + streams[i].start[0]];
+			memcpy(rows[i].buf + rows[i].rows * rowsize, &probe, rowsize);
+		}
+
+		if (++rows[i].rows == MOLT_OUTPUT_ROWS) {
+			full = 1;
+		}
+	}
+
+	if (full || output_due(&streams[0], step)) {
+		return sim_flushrows(streams, rows, nstreams);
+	}
+
+	return 0;
+}
+
+/* sim_flushrows : writes every stream's pending rows out as a lump */
+int sim_flushrows(struct outstream_t *streams, struct outrows_t *rows, s64 nstreams)
+{
+	char tag[sizeof(streams->tag) + 1];
+	s64 i;
+	int rc;
+
+	for (i = 0; i < nstreams; i++) {
+		if (rows[i].rows == 0) {
+			continue;
+		}
+
+		memset(tag, 0, sizeof(tag));
+		memcpy(tag, streams[i].tag, sizeof(streams[i].tag));
+
+		rc = lump_write(tag, rows[i].rows * output_rowsize(&streams[i]), rows[i].buf, NULL);
+		if (rc < 0) {
+			return -1;
+		}
+
+		rows[i].rows = 0;
+	}
 
 	return 0;
 }
 
+/* sim_freerows : frees the row buffers */
+void sim_freerows(struct outrows_t *rows, s64 nstreams)
+{
+	s64 i;
+
+	for (i = 0; i < nstreams; i++) {
+		free(rows[i].buf);
+	}
+
+	free(rows);
+}
+
 #define PRINTANDFAIL(x)  ({ERR(x); return -1;})
 
 /* do_simulation : actually does the simulating */
-int do_simulation()
+int do_simulation(struct user_cfg_t *usercfg, u32 simflags, struct simload_t *load)
 {
 	struct molt_cfg_t config;
 	pdvec6_t vw, ww;
 	pdvec3_t vol;
 	f64 *prev, *curr, *next;
-	f64 ftmp;
+	f64 *state[CHKPT_VOLUMES];
+	f64 ftmp, dt, *outbuf;
+	dvec3_t h;
+	struct outstream_t *streams;
+	struct outrows_t *rows;
+	struct outstat_t stat;
+	struct live_t *live;
+	s64 nstreams;
 	u32 flags;
-	u64 elems, i, j, volumebytes;
+	s64 i, taken;
+	u64 elems, j, step, sincechkpt;
+	struct timeval lastchkpt;
 	ivec3_t pinc;
-	ivec3_t points;
 	int rc;
 
 	struct simtimeinfo_t *timings;
+	struct profstep_t *profile;
 
-	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
-	if (rc < 0) { PRINTANDFAIL("couldn't read config from lump system"); }
+	rc = sim_load(load, &config, vw, ww, &prev, &curr);
+	if (rc < 0) { PRINTANDFAIL("couldn't load the simulation from lump system"); }
 
 	molt_cfg_parampull_xyz(&config, pinc, MOLT_PARAM_PINC);
-	molt_cfg_parampull_xyz(&config, points, MOLT_PARAM_POINTS);
 
 	elems = pinc[0] * (u64)pinc[1] * pinc[2];
 
-	// get working memory for all of our data points we need
+	nstreams = sim_loadoutputs(&streams);
+	if (nstreams < 0) { PRINTANDFAIL("couldn't read the output streams from lump system"); }
+
+	rows = calloc(nstreams, sizeof(*rows));
 
-	vw[0] = calloc(pinc[0], sizeof(f64));
-	vw[1] = calloc(pinc[0], sizeof(f64));
-	vw[2] = calloc(pinc[1], sizeof(f64));
-	vw[3] = calloc(pinc[1], sizeof(f64));
-	vw[4] = calloc(pinc[2], sizeof(f64));
-	vw[5] = calloc(pinc[2], sizeof(f64));
+	live = sim_openlive(usercfg, pinc);
 
-	ww[0] = calloc(points[0] * (config.spaceacc + 1), sizeof(f64));
-	ww[1] = calloc(points[0] * (config.spaceacc + 1), sizeof(f64));
-	ww[2] = calloc(points[1] * (config.spaceacc + 1), sizeof(f64));
-	ww[3] = calloc(points[1] * (config.spaceacc + 1), sizeof(f64));
-	ww[4] = calloc(points[2] * (config.spaceacc + 1), sizeof(f64));
-	ww[5] = calloc(points[2] * (config.spaceacc + 1), sizeof(f64));
+	dt = config.time_scale * config.t_params[MOLT_PARAM_STEP];
+	h[0] = config.space_scale * config.x_params[MOLT_PARAM_STEP];
+	h[1] = config.space_scale * config.y_params[MOLT_PARAM_STEP];
+	h[2] = config.space_scale * config.z_params[MOLT_PARAM_STEP];
 
-	prev = calloc(elems, sizeof(f64));
-	curr = calloc(elems, sizeof(f64));
 	next = calloc(elems, sizeof(f64));
 
-	volumebytes = sizeof(f64) * elems;
-
-	// now that we have memory, we can fully load all of our data
-	rc = lump_read(MOLTSTR_VLX, 0, vw[0]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLX from lump system"); }
-	rc = lump_read(MOLTSTR_VRX, 0, vw[1]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRX from lump system"); }
-	rc = lump_read(MOLTSTR_VLY, 0, vw[2]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLY from lump system"); }
-	rc = lump_read(MOLTSTR_VRY, 0, vw[3]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRY from lump system"); }
-	rc = lump_read(MOLTSTR_VLZ, 0, vw[4]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLZ from lump system"); }
-	rc = lump_read(MOLTSTR_VRZ, 0, vw[5]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRZ from lump system"); }
-
-	rc = lump_read(MOLTSTR_WLX, 0, ww[0]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLX from lump system"); }
-	rc = lump_read(MOLTSTR_WRX, 0, ww[1]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRX from lump system"); }
-	rc = lump_read(MOLTSTR_WLY, 0, ww[2]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLY from lump system"); }
-	rc = lump_read(MOLTSTR_WRY, 0, ww[3]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRY from lump system"); }
-	rc = lump_read(MOLTSTR_WLZ, 0, ww[4]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLZ from lump system"); }
-	rc = lump_read(MOLTSTR_WRZ, 0, ww[5]);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRZ from lump system"); }
-
-	rc = lump_read(MOLTSTR_VEL, 0, prev);
-	if (rc < 0) { PRINTANDFAIL("couldn't read initial velocity from lump system"); }
-	rc = lump_read(MOLTSTR_AMP, 0, curr);
-	if (rc < 0) { PRINTANDFAIL("couldn't read initial amplitude from lump system"); }
+	outbuf = calloc(elems, sizeof(f64)); // no stream's entries are bigger than a volume
 
 	vol[0] = next;
 	vol[1] = curr;
@@ -351,43 +772,103 @@ int do_simulation()
 
 	molt_cfg_set_workstore(&config);
 
-	// init for the initial velocity condition
-	ftmp = config.time_scale * config.t_params[MOLT_PARAM_STEP];
-	for (i = 0; i < elems; i++) {
-		next[i] = curr[i] + ftmp * prev[i];
-	}
-
-	timings = calloc(config.t_params[MOLT_PARAM_STOP], sizeof(*timings));
+	chkpt_state(state, &config, prev, curr);
 
 	i = config.t_params[MOLT_PARAM_START];
 	flags = MOLT_FLAG_FIRSTSTEP;
 
+	if (simflags & FLAG_RESTART) {
+		taken = chkpt_restore(&config, state, elems, &i, &flags);
+		if (taken == 0) { // no checkpoints, fall back to the AMP lumps
+			if (streams[0].every != 1) { PRINTANDFAIL("no checkpoint to restart from, and AMP isn't written every step"); }
+			taken = restart_fromamp(&config, prev, curr, &i);
+			if (taken > 0) {
+				flags = 0;
+			}
+		}
+		if (taken < 0) { PRINTANDFAIL("couldn't restore the last timesteps from the lump system"); }
+	}
+
+	if (flags & MOLT_FLAG_FIRSTSTEP) {
+		// init for the initial velocity condition
+		ftmp = config.time_scale * config.t_params[MOLT_PARAM_STEP];
+		for (j = 0; j < elems; j++) {
+			next[j] = curr[j] + ftmp * prev[j];
+		}
+	}
+
+	// a fresh run always takes its first step, even when STOP isn't past START
+	timings = calloc(config.t_params[MOLT_PARAM_STOP] + 1, sizeof(*timings));
+	profile = calloc(config.t_params[MOLT_PARAM_STOP] + 1, sizeof(*profile));
+
 	j = 0;
 
-	do {
+	sincechkpt = 0;
+	gettimeofday(&lastchkpt, NULL);
+
+	prof_take(NULL, 0); // setup's lump writes aren't any step's
+
+	// like it always has, a fresh run takes at least one step, but a restart
+	// of a run that already got to STOP doesn't take any more
+	while (i < config.t_params[MOLT_PARAM_STOP] || (flags & MOLT_FLAG_FIRSTSTEP)) {
+		prof_begin(PROF_STEP);
+
 		gettimeofday(&timings[j].start, NULL);
 
 		molt_step(&config, vol, vw, ww, flags);
 
 		gettimeofday(&timings[j++].end, NULL);
 
-		rc = lump_write(MOLTSTR_AMP, sizeof(f64) * elems, next, NULL);
+		step = (i - config.t_params[MOLT_PARAM_START]) / config.t_params[MOLT_PARAM_STEP] + 1;
+
+		rc = sim_writeoutputs(streams, nstreams, pinc, next, step, outbuf);
+		if (rc < 0) { PRINTANDFAIL("couldn't write the outputs to the lump system"); }
+
+		if (live) {
+			live_publish(live, next, step);
+		}
+
+		prof_begin(PROF_ELEM);
+		output_advance(sim_statsdue(streams, nstreams, step) ? &stat : NULL, prev, curr, next, pinc, h, dt, MOLT_TISSUESPEED);
+		prof_end(PROF_ELEM);
 
-		memcpy(prev, curr, volumebytes);
-		memcpy(curr, next, volumebytes);
-		memset(next, 0, volumebytes);
+		rc = sim_addrows(streams, rows, nstreams, &stat, curr, pinc, step);
+		if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
 
 		flags = 0;
 		i += config.t_params[MOLT_PARAM_STEP];
-	} while (i < config.t_params[MOLT_PARAM_STOP]);
+
+		if (chkpt_due(usercfg->chkpt_steps, usercfg->chkpt_secs, ++sincechkpt, &lastchkpt)) {
+			rc = sim_flushrows(streams, rows, nstreams);
+			if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
+
+			rc = chkpt_write(usercfg->chkpt_keep, &config, state, elems, i, flags);
+			if (rc < 0) { PRINTANDFAIL("couldn't write a checkpoint to the lump system"); }
+			sincechkpt = 0;
+		}
+
+		prof_end(PROF_STEP);
+		prof_take(&profile[j - 1], step);
+	}
+
+	rc = sim_flushrows(streams, rows, nstreams);
+	if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
 
 	rc = lump_write(MOLTSTR_TIME, sizeof(*timings) * j, timings, NULL);
+	rc = lump_write(MOLTSTR_PROF, sizeof(*profile) * j, profile, NULL);
+
+	free(timings);
+	free(profile);
 
 	molt_cfg_free_workstore(&config);
 
 	free(prev);
 	free(curr);
 	free(next);
+	free(outbuf);
+	free(streams);
+	sim_freerows(rows, nstreams);
+	live_close(live);
 
 	for (i = 0; i < 5; i++) {
 		free(vw[i]);
@@ -398,79 +879,65 @@ int do_simulation()
 }
 
 /* do_custom_simulation : setsup and invokes the custom MOLT routines */
-int do_custom_simulation(void *lib)
+int do_custom_simulation(struct user_cfg_t *usercfg, void *lib, u32 simflags, struct simload_t *load)
 {
 	struct molt_cfg_t config;
 	struct molt_custom_t custom;
+	pdvec6_t vw, ww;
+	f64 *state[CHKPT_VOLUMES];
+	f64 dt, *outbuf;
+	dvec3_t h;
+	struct outstream_t *streams;
+	struct outrows_t *rows;
+	struct outstat_t stat;
+	struct live_t *live;
+	s64 nstreams;
 	u32 flags;
-	u64 elems, i, j, volumebytes;
+	s64 i, taken;
+	u64 elems, j, step, sincechkpt;
+	struct timeval lastchkpt;
 	ivec3_t pinc;
-	ivec3_t points;
 	int rc;
 
 	struct simtimeinfo_t *timings;
+	struct profstep_t *profile;
 
-	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
-	if (rc < 0) { PRINTANDFAIL("couldn't read config from lump system"); }
+	rc = sim_load(load, &config, vw, ww, &custom.prev, &custom.curr);
+	if (rc < 0) { PRINTANDFAIL("couldn't load the simulation from lump system"); }
 
-	molt_cfg_parampull_xyz(&config, pinc,   MOLT_PARAM_PINC);
-	molt_cfg_parampull_xyz(&config, points, MOLT_PARAM_POINTS);
+	molt_cfg_parampull_xyz(&config, pinc, MOLT_PARAM_PINC);
 
 	elems = pinc[0] * (u64)pinc[1] * pinc[2];
 
-	// get working memory for all of our data points we need
-
-	custom.vlx = calloc(pinc[0], sizeof(f64));
-	custom.vrx = calloc(pinc[0], sizeof(f64));
-	custom.vly = calloc(pinc[1], sizeof(f64));
-	custom.vry = calloc(pinc[1], sizeof(f64));
-	custom.vlz = calloc(pinc[2], sizeof(f64));
-	custom.vrz = calloc(pinc[2], sizeof(f64));
-
-	custom.wlx = calloc(points[0] * (config.spaceacc + 1), sizeof(f64));
-	custom.wrx = calloc(points[0] * (config.spaceacc + 1), sizeof(f64));
-	custom.wly = calloc(points[1] * (config.spaceacc + 1), sizeof(f64));
-	custom.wry = calloc(points[1] * (config.spaceacc + 1), sizeof(f64));
-	custom.wlz = calloc(points[2] * (config.spaceacc + 1), sizeof(f64));
-	custom.wrz = calloc(points[2] * (config.spaceacc + 1), sizeof(f64));
-
-	custom.prev  = calloc(elems, sizeof(f64));
-	custom.curr  = calloc(elems, sizeof(f64));
-	custom.next  = calloc(elems, sizeof(f64));
-
-	volumebytes = sizeof(f64) * elems;
-
-	// now that we have memory, we can fully load all of our data
-	rc = lump_read(MOLTSTR_VLX, 0, custom.vlx);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLX from lump system"); }
-	rc = lump_read(MOLTSTR_VRX, 0, custom.vrx);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRX from lump system"); }
-	rc = lump_read(MOLTSTR_VLY, 0, custom.vly);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLY from lump system"); }
-	rc = lump_read(MOLTSTR_VRY, 0, custom.vry);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRY from lump system"); }
-	rc = lump_read(MOLTSTR_VLZ, 0, custom.vlz);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VLZ from lump system"); }
-	rc = lump_read(MOLTSTR_VRZ, 0, custom.vlz);
-	if (rc < 0) { PRINTANDFAIL("couldn't read VRZ from lump system"); }
-
-	rc = lump_read(MOLTSTR_WLX, 0, custom.wlx);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLX from lump system"); }
-	rc = lump_read(MOLTSTR_WRX, 0, custom.wrx);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRX from lump system"); }
-	rc = lump_read(MOLTSTR_WLY, 0, custom.wly);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLY from lump system"); }
-	rc = lump_read(MOLTSTR_WRY, 0, custom.wry);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRY from lump system"); }
-	rc = lump_read(MOLTSTR_WLZ, 0, custom.wlz);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WLZ from lump system"); }
-	rc = lump_read(MOLTSTR_WRZ, 0, custom.wrz);
-	if (rc < 0) { PRINTANDFAIL("couldn't read WRZ from lump system"); }
-
-	rc = lump_read(MOLTSTR_VEL, 0, custom.prev);
-	if (rc < 0) { PRINTANDFAIL("couldn't read initial velocity from lump system"); }
-	rc = lump_read(MOLTSTR_AMP, 0, custom.curr);
-	if (rc < 0) { PRINTANDFAIL("couldn't read initial amplitude from lump system"); }
+	nstreams = sim_loadoutputs(&streams);
+	if (nstreams < 0) { PRINTANDFAIL("couldn't read the output streams from lump system"); }
+
+	rows = calloc(nstreams, sizeof(*rows));
+
+	live = sim_openlive(usercfg, pinc);
+
+	dt = config.time_scale * config.t_params[MOLT_PARAM_STEP];
+	h[0] = config.space_scale * config.x_params[MOLT_PARAM_STEP];
+	h[1] = config.space_scale * config.y_params[MOLT_PARAM_STEP];
+	h[2] = config.space_scale * config.z_params[MOLT_PARAM_STEP];
+
+	custom.vlx = vw[0];
+	custom.vrx = vw[1];
+	custom.vly = vw[2];
+	custom.vry = vw[3];
+	custom.vlz = vw[4];
+	custom.vrz = vw[5];
+
+	custom.wlx = ww[0];
+	custom.wrx = ww[1];
+	custom.wly = ww[2];
+	custom.wry = ww[3];
+	custom.wlz = ww[4];
+	custom.wrz = ww[5];
+
+	custom.next = calloc(elems, sizeof(f64));
+
+	outbuf = calloc(elems, sizeof(f64)); // no stream's entries are bigger than a volume
 
 	custom.cfg = &config;
 
@@ -482,34 +949,90 @@ int do_custom_simulation(void *lib)
 	custom.func_sweep = sys_libsym(lib, "molt_custom_sweep");
 	custom.func_reorg = sys_libsym(lib, "molt_custom_reorg");
 
+	custom.func_trace = trace_on() ? trace_span : NULL;
+
 	rc = custom.func_open(&custom);
 	if (rc < 0) { PRINTANDFAIL("couldn't init custom library"); }
 
-	timings = calloc(config.t_params[MOLT_PARAM_STOP], sizeof(*timings));
+	chkpt_state(state, &config, custom.prev, custom.curr);
 
 	i = config.t_params[MOLT_PARAM_START];
 	flags = MOLT_FLAG_FIRSTSTEP;
 
+	if (simflags & FLAG_RESTART) {
+		taken = chkpt_restore(&config, state, elems, &i, &flags);
+		if (taken == 0) { // no checkpoints, fall back to the AMP lumps
+			if (streams[0].every != 1) { PRINTANDFAIL("no checkpoint to restart from, and AMP isn't written every step"); }
+			taken = restart_fromamp(&config, custom.prev, custom.curr, &i);
+			if (taken > 0) {
+				flags = 0;
+			}
+		}
+		if (taken < 0) { PRINTANDFAIL("couldn't restore the last timesteps from the lump system"); }
+	}
+
+	// a fresh run always takes its first step, even when STOP isn't past START
+	timings = calloc(config.t_params[MOLT_PARAM_STOP] + 1, sizeof(*timings));
+	profile = calloc(config.t_params[MOLT_PARAM_STOP] + 1, sizeof(*profile));
+
 	j = 0;
 
-	do {
+	sincechkpt = 0;
+	gettimeofday(&lastchkpt, NULL);
+
+	prof_take(NULL, 0); // setup's lump writes aren't any step's
+
+	// like it always has, a fresh run takes at least one step, but a restart
+	// of a run that already got to STOP doesn't take any more
+	while (i < config.t_params[MOLT_PARAM_STOP] || (flags & MOLT_FLAG_FIRSTSTEP)) {
+		prof_begin(PROF_STEP);
+
 		gettimeofday(&timings[j].start, NULL);
 
 		molt_step_custom(&custom, flags);
 
 		gettimeofday(&timings[j++].end, NULL);
 
-		rc = lump_write(MOLTSTR_AMP, sizeof(f64) * elems, custom.next, NULL);
+		step = (i - config.t_params[MOLT_PARAM_START]) / config.t_params[MOLT_PARAM_STEP] + 1;
+
+		rc = sim_writeoutputs(streams, nstreams, pinc, custom.next, step, outbuf);
+		if (rc < 0) { PRINTANDFAIL("couldn't write the outputs to the lump system"); }
+
+		if (live) {
+			live_publish(live, custom.next, step);
+		}
+
+		prof_begin(PROF_ELEM);
+		output_advance(sim_statsdue(streams, nstreams, step) ? &stat : NULL, custom.prev, custom.curr, custom.next, pinc, h, dt, MOLT_TISSUESPEED);
+		prof_end(PROF_ELEM);
 
-		memcpy(custom.prev, custom.curr, volumebytes);
-		memcpy(custom.curr, custom.next, volumebytes);
-		memset(custom.next, 0, volumebytes);
+		rc = sim_addrows(streams, rows, nstreams, &stat, custom.curr, pinc, step);
+		if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
 
 		flags = 0;
 		i += config.t_params[MOLT_PARAM_STEP];
-	} while (i < config.t_params[MOLT_PARAM_STOP]);
+
+		if (chkpt_due(usercfg->chkpt_steps, usercfg->chkpt_secs, ++sincechkpt, &lastchkpt)) {
+			rc = sim_flushrows(streams, rows, nstreams);
+			if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
+
+			rc = chkpt_write(usercfg->chkpt_keep, &config, state, elems, i, flags);
+			if (rc < 0) { PRINTANDFAIL("couldn't write a checkpoint to the lump system"); }
+			sincechkpt = 0;
+		}
+
+		prof_end(PROF_STEP);
+		prof_take(&profile[j - 1], step);
+	}
+
+	rc = sim_flushrows(streams, rows, nstreams);
+	if (rc < 0) { PRINTANDFAIL("couldn't write the stats to the lump system"); }
 
 	rc = lump_write(MOLTSTR_TIME, sizeof(*timings) * j, timings, NULL);
+	rc = lump_write(MOLTSTR_PROF, sizeof(*profile) * j, profile, NULL);
+
+	free(timings);
+	free(profile);
 
 	rc = custom.func_close(&custom);
 	if (rc < 0) { PRINTANDFAIL("couldn't close custom library"); }
@@ -519,6 +1042,10 @@ int do_custom_simulation(void *lib)
 	free(custom.prev);
 	free(custom.curr);
 	free(custom.next);
+	free(outbuf);
+	free(streams);
+	sim_freerows(rows, nstreams);
+	live_close(live);
 
 	free(custom.vlx);
 	free(custom.vrx);
@@ -538,46 +1065,559 @@ int do_custom_simulation(void *lib)
 
 }
 
-/* setup : sets up the simulation */
-int setup(struct user_cfg_t *usercfg)
+/* sim_load : takes what setup left in load, or reads the config, weights and initial conditions */
+int sim_load(struct simload_t *load, struct molt_cfg_t *config, pdvec6_t vw, pdvec6_t ww, f64 **vel, f64 **amp)
 {
-	int rc;
-
-	rc = setup_config(usercfg);
-	if (rc < 0) {
-		fprintf(stderr, "ERR : config setup failed!\n");
-		return -1;
+	static char *vtags[] = {
+		MOLTSTR_VLX, MOLTSTR_VRX, MOLTSTR_VLY, MOLTSTR_VRY, MOLTSTR_VLZ, MOLTSTR_VRZ
+	};
+	static char *wtags[] = {
+		MOLTSTR_WLX, MOLTSTR_WRX, MOLTSTR_WLY, MOLTSTR_WRY, MOLTSTR_WLZ, MOLTSTR_WRZ
+	};
+	struct lumpreq_t req[14];
+	ivec3_t pinc, points;
+	u64 elems, vlen, wlen;
+	int i, rc;
+
+	if (load && load->vel) { // setup's buffers are ours now
+		*config = load->config;
+		memcpy(vw, load->vw, sizeof(load->vw));
+		memcpy(ww, load->ww, sizeof(load->ww));
+		*vel = load->vel;
+		*amp = load->amp;
+
+		memset(load, 0, sizeof(*load));
+
+		return 0;
 	}
 
-	rc = setup_vweight();
-	if (rc < 0) {
-		fprintf(stderr, "ERR : v weight setup failed!\n");
-		return -1;
-	}
+	rc = lump_read(MOLTSTR_CONFIG, 0, config);
+	if (rc < 0) { PRINTANDFAIL("couldn't read config from lump system"); }
 
-	rc = setup_wweight();
-	if (rc < 0) {
-		fprintf(stderr, "ERR : w weight setup failed!\n");
-		return -1;
-	}
+	molt_cfg_parampull_xyz(config, pinc, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(config, points, MOLT_PARAM_POINTS);
 
-	rc = setup_initcommand(usercfg, COMMAND_MODE_VELOCITY);
-	if (rc < 0) {
-		fprintf(stderr, "ERR : initial velocity setup failed!\n");
-		return -1;
-	}
+	elems = pinc[0] * (u64)pinc[1] * pinc[2];
 
-	rc = setup_initcommand(usercfg, COMMAND_MODE_AMPLITUDE);
-	if (rc < 0) {
-		fprintf(stderr, "ERR : initial amplitude setup failed!\n");
+	// the weights come in left and right pairs, for x, y and z, and everything
+	// else is only sized once the config's in, so it's all read as one batch
+	for (i = 0; i < 6; i++) {
+		vlen = pinc[i / 2];
+		wlen = points[i / 2] * (u64)(config->spaceacc + 1);
+
+		vw[i] = calloc(vlen, sizeof(f64));
+		ww[i] = calloc(wlen, sizeof(f64));
+
+		req[i] = (struct lumpreq_t){ vtags[i], 0, vw[i], vlen * sizeof(f64) };
+		req[6 + i] = (struct lumpreq_t){ wtags[i], 0, ww[i], wlen * sizeof(f64) };
+	}
+
+	*vel = calloc(elems, sizeof(f64));
+	*amp = calloc(elems, sizeof(f64));
+
+	req[12] = (struct lumpreq_t){ MOLTSTR_VEL, 0, *vel, elems * sizeof(f64) };
+	req[13] = (struct lumpreq_t){ MOLTSTR_AMP, 0, *amp, elems * sizeof(f64) };
+
+	rc = lump_readv(req, sizeof(req) / sizeof(req[0]));
+	if (rc < 0) { PRINTANDFAIL("couldn't read the weights and initial conditions from lump system"); }
+
+	return 0;
+}
+
+/* sim_freeload : frees whatever's still in load */
+void sim_freeload(struct simload_t *load)
+{
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		free(load->vw[i]);
+		free(load->ww[i]);
+	}
+
+	free(load->vel);
+	free(load->amp);
+
+	memset(load, 0, sizeof(*load));
+}
+
+/* setup_lumpcodecs : sets up how volumes of the given size, and the output streams, get encoded and laid out */
+int setup_lumpcodecs(struct user_cfg_t *usercfg, ivec3_t dim, s32 brick, struct outstream_t *streams, s64 nstreams)
+{
+	struct codecparams_t params;
+	char tag[sizeof(streams->tag) + 1];
+	s64 i;
+	int rc;
+
+	// only the timesteps are worth encoding, everything else is tiny
+	params.relative = 0 < usercfg->compress_relerr;
+	params.tolerance = params.relative ? usercfg->compress_relerr : usercfg->compress_abserr;
+	params.keyframe = usercfg->compress_keyframe;
+
+	if (usercfg->compress == CODEC_LOSSY && params.tolerance <= 0) {
+		fprintf(stderr, "WRN : lossy compression without an error bound, AMP lumps will be lossless\n");
+	}
+
+	if (0 < brick && 1 < params.keyframe) {
+		fprintf(stderr, "WRN : bricked AMP lumps are all keyframes, compress_keyframe is ignored\n");
+	}
+
+	rc = lump_setcodec(MOLTSTR_AMP, usercfg->compress, &params);
+	if (rc < 0) {
+		return -1;
+	}
+
+	// the rest of the volume streams are encoded the same way, but never bricked
+	for (i = 0; i < nstreams; i++) {
+		if (output_rowsize(&streams[i])) {
+			continue;
+		}
+
+		memset(tag, 0, sizeof(tag));
+		memcpy(tag, streams[i].tag, sizeof(streams[i].tag));
+
+		rc = lump_setcodec(tag, usercfg->compress, &params);
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	return lump_setbrick(MOLTSTR_AMP, dim, 0 < brick ? brick : 0);
+}
+
+/* setup_outputs : checks the config's output streams, and writes them (and their first entries) out */
+int setup_outputs(struct user_cfg_t *usercfg, struct simload_t *load)
+{
+	struct outstream_t *streams;
+	ivec3_t dim;
+	f64 *buf;
+	u64 elems;
+	s64 i, j, n;
+	int rc;
+
+	char *reserved[] = {
+		MOLTSTR_CONFIG, MOLTSTR_VLX, MOLTSTR_VRX, MOLTSTR_VLY, MOLTSTR_VRY, MOLTSTR_VLZ, MOLTSTR_VRZ,
+		MOLTSTR_WLX, MOLTSTR_WRX, MOLTSTR_WLY, MOLTSTR_WRY, MOLTSTR_WLZ, MOLTSTR_WRZ,
+		MOLTSTR_VEL, MOLTSTR_AMP, MOLTSTR_TIME, MOLTSTR_PROF, MOLTSTR_CHKPT, MOLTSTR_OUTPUT
+	};
+
+	/*
+	 * NOTE
+	 * The OUTPUTS lump is the list of streams the run writes, and AMP is
+	 * always the first of them, a full volume every 'output_every' steps.
+	 * Without any streams, and with AMP written every step, we skip writing
+	 * it, and the file looks just like it always has. The initial amplitude
+	 * was already written as AMP[0], so the rest of the streams get their
+	 * first entries cut out of it here.
+	 */
+
+	if (usercfg->streams_len == 0 && usercfg->output_every == 1) {
+		return 0;
+	}
+
+	if (usercfg->output_every < 0) {
+		fprintf(stderr, "ERR : output_every can't be negative\n");
+		return -1;
+	}
+
+	molt_cfg_parampull_xyz(&load->config, dim, MOLT_PARAM_PINC);
+
+	streams = calloc(usercfg->streams_len + 1, sizeof(*streams));
+
+	memcpy(streams[0].tag, MOLTSTR_AMP, strlen(MOLTSTR_AMP));
+	streams[0].kind = OUTPUT_FULL;
+	streams[0].every = usercfg->output_every;
+	output_check(&streams[0], dim);
+
+	for (i = 0, n = 1; i < usercfg->streams_len; i++) {
+		for (j = 0; j < ARRSIZE(reserved); j++) {
+			if (strncmp(usercfg->streams[i].tag, reserved[j], sizeof(streams->tag)) == 0) {
+				break;
+			}
+		}
+
+		if (j < ARRSIZE(reserved)) {
+			fprintf(stderr, "WRN : output stream %.8s uses a reserved tag, skipping it\n", usercfg->streams[i].tag);
+			continue;
+		}
+
+		for (j = 0; j < n; j++) {
+			if (strncmp(usercfg->streams[i].tag, streams[j].tag, sizeof(streams->tag)) == 0) {
+				break;
+			}
+		}
+
+		if (j < n) {
+			fprintf(stderr, "WRN : output stream %.8s is defined twice, skipping it\n", usercfg->streams[i].tag);
+			continue;
+		}
+
+		streams[n] = usercfg->streams[i];
+
+		if (output_check(&streams[n], dim) < 0) {
+			fprintf(stderr, "WRN : output stream %.8s doesn't fit the volume, skipping it\n", usercfg->streams[i].tag);
+			continue;
+		}
+
+		n++;
+	}
+
+	rc = lump_write(MOLTSTR_OUTPUT, n * sizeof(*streams), streams, NULL);
+	if (rc < 0) {
+		free(streams);
 		return -1;
 	}
 
+	elems = dim[0] * (u64)dim[1] * dim[2];
+
+	buf = calloc(elems, sizeof(f64));
+
+	rc = sim_writeoutputs(streams + 1, n - 1, dim, load->amp, 0, buf);
+
+	free(buf);
+	free(streams);
+
+	return rc;
+}
+
+/* sim_loadoutputs : loads the lump file's output streams, returns how many there are */
+s64 sim_loadoutputs(struct outstream_t **streams)
+{
+	size_t size;
+	int rc;
+
+	// files without an OUTPUTS lump only ever wrote AMP, every step
+	rc = lump_readsize(MOLTSTR_OUTPUT, 0, &size);
+	if (rc < 0) {
+		*streams = calloc(1, sizeof(**streams));
+
+		memcpy((*streams)->tag, MOLTSTR_AMP, strlen(MOLTSTR_AMP));
+		(*streams)->kind = OUTPUT_FULL;
+		(*streams)->every = 1;
+
+		return 1;
+	}
+
+	*streams = malloc(size);
+
+	rc = lump_read(MOLTSTR_OUTPUT, 0, *streams);
+	if (rc < 0 || size < sizeof(**streams)) {
+		free(*streams);
+		*streams = NULL;
+		return -1;
+	}
+
+	return size / sizeof(**streams);
+}
+
+/* sim_writeoutputs : writes an entry for every stream that wants one at this step */
+int sim_writeoutputs(struct outstream_t *streams, s64 nstreams, ivec3_t dim, f64 *vol, u64 step, f64 *buf)
+{
+	char tag[sizeof(streams->tag) + 1];
+	ivec3_t out;
+	u64 elems;
+	s64 i;
+	int rc;
+
+	for (i = 0; i < nstreams; i++) {
+		if (output_rowsize(&streams[i]) || !output_due(&streams[i], step)) {
+			continue;
+		}
+
+		memset(tag, 0, sizeof(tag));
+		memcpy(tag, streams[i].tag, sizeof(streams[i].tag));
+
+		elems = output_dim(&streams[i], dim, out);
+
+		if (streams[i].kind == OUTPUT_FULL) {
+			rc = lump_write(tag, sizeof(f64) * elems, vol, NULL);
+		} else {
+			output_extract(&streams[i], buf, vol, dim);
+			rc = lump_write(tag, sizeof(f64) * elems, buf, NULL);
+		}
+
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
 	return 0;
 }
 
-/* setup_config : setup the config lump */
-int setup_config(struct user_cfg_t *ucfg)
+/* rebrick : copies every lump in src into a new lump file dst, re-laid out per the config */
+int rebrick(struct user_cfg_t *usercfg, char *src, char *dst)
+{
+	struct lumpheader_t hdr;
+	struct lumpinfo_t info;
+	struct molt_cfg_t config;
+	struct outstream_t *streams;
+	struct lump_t *from;
+	s64 nstreams;
+	ivec3_t dim;
+	char tag[sizeof(info.tag) + 1];
+	u8 *buf;
+	size_t buf_cap;
+	u64 i;
+	int rc;
+
+	/*
+	 * NOTE
+	 * The source stays mapped, set aside with lump_detach, while the new file
+	 * is open, and we swap between the two a lump at a time. Neither gets
+	 * reopened, so the source's decoded lump carries over to the delta after
+	 * it, and the new file's last entry of each tag is there for the next one
+	 * to be a delta from. Every lump is read back decoded, and written into
+	 * the new file in the same order, so entries (and the lump counts in
+	 * checkpoints) all stay the same. The AMP volumes get whatever layout and
+	 * compression the config asks for, bricked at MOLT_BRICK_SIZE if it
+	 * doesn't say, or flat with 'brick_size: flat'.
+	 */
+
+	rc = lump_openmap(src);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't map lump file '%s', %s\n", src, lump_strerror(rc));
+		return -1;
+	}
+
+	lump_getheader(&hdr);
+
+	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : '%s' has no config lump\n", src);
+		lump_close();
+		return -1;
+	}
+
+	nstreams = sim_loadoutputs(&streams);
+	if (nstreams < 0) {
+		fprintf(stderr, "ERR : couldn't load the output streams of '%s'\n", src);
+		lump_close();
+		return -1;
+	}
+
+	from = lump_detach();
+
+	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
+
+	rc = lump_open(dst);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't open lump file '%s'\n", dst);
+		free(streams);
+		lump_release(from);
+		return -1;
+	}
+
+	rc = lump_setshards(usercfg->shards);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't make %ld shards for lump file '%s'\n", usercfg->shards, dst);
+		free(streams);
+		lump_close();
+		lump_release(from);
+		return -1;
+	}
+
+	setup_lumpcodecs(usercfg, dim, usercfg->brick_size == 0 ? MOLT_BRICK_SIZE : usercfg->brick_size, streams, nstreams);
+
+	free(streams);
+
+	buf = NULL;
+	buf_cap = 0;
+
+	for (i = 0, rc = 0; rc == 0 && i < hdr.lumps; i++) {
+		lump_swap(from); // the source is open
+
+		lump_getinfo(&info, i);
+
+		memset(tag, 0, sizeof(tag));
+		memcpy(tag, info.tag, sizeof(info.tag));
+
+		if (buf_cap < info.rawsize + 1) {
+			buf_cap = info.rawsize + 1;
+			free(buf);
+			buf = malloc(buf_cap);
+		}
+
+		rc = lump_read(tag, info.entry, buf);
+
+		lump_swap(from); // and the new file is again
+
+		if (rc == 0) {
+			rc = lump_write(tag, info.rawsize, buf, NULL);
+		}
+	}
+
+	free(buf);
+
+	lump_close();
+	lump_release(from);
+
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't copy lump %ld of '%s'\n", i - 1, src);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* setup : sets up the simulation, leaving what the simulation needs in load */
+int setup(struct user_cfg_t *usercfg, struct simload_t *load)
+{
+	static char *vtags[] = {
+		MOLTSTR_VLX, MOLTSTR_VRX, MOLTSTR_VLY, MOLTSTR_VRY, MOLTSTR_VLZ, MOLTSTR_VRZ
+	};
+	static char *wtags[] = {
+		MOLTSTR_WLX, MOLTSTR_WRX, MOLTSTR_WLY, MOLTSTR_WRY, MOLTSTR_WLZ, MOLTSTR_WRZ
+	};
+	struct setupjob_t jobs[5];
+	struct molt_cfg_t *config;
+	ivec3_t pinc, points;
+	u64 elems, vlen[6], wlen[6];
+	int i, j, rc;
+
+	/*
+	 * NOTE
+	 * The weights for each axis and both initial conditions don't depend on
+	 * each other, so they're all worked out at once, on a thread each (the
+	 * initial conditions are usually a program we're just waiting on). The
+	 * lumps still go out in the order they always have, so we wait on the
+	 * jobs in that order, and write each one out as soon as it's done.
+	 */
+
+	memset(load, 0, sizeof(*load));
+
+	config = &load->config;
+
+	setup_makeconfig(usercfg, config);
+
+	rc = lump_write(MOLTSTR_CONFIG, sizeof(*config), config, NULL);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : config setup failed!\n");
+		return -1;
+	}
+
+	molt_cfg_parampull_xyz(config, pinc, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(config, points, MOLT_PARAM_POINTS);
+
+	elems = pinc[0] * (u64)pinc[1] * pinc[2];
+
+	for (i = 0; i < 6; i++) {
+		vlen[i] = pinc[i / 2];
+		wlen[i] = points[i / 2] * (u64)(config->spaceacc + 1);
+
+		load->vw[i] = calloc(vlen[i], sizeof(f64));
+		load->ww[i] = calloc(wlen[i], sizeof(f64));
+	}
+
+	load->vel = calloc(elems, sizeof(f64));
+	load->amp = calloc(elems, sizeof(f64));
+
+	for (i = 0; i < ARRSIZE(jobs); i++) {
+		jobs[i].usercfg = usercfg;
+		jobs[i].load = load;
+		jobs[i].command = i < 3 ? COMMAND_MODE_NONE : i == 3 ? COMMAND_MODE_VELOCITY : COMMAND_MODE_AMPLITUDE;
+		jobs[i].axis = i;
+		jobs[i].rc = 0;
+
+		jobs[i].thread = sys_threadcreate();
+		sys_threadsetfunc(jobs[i].thread, setup_thread);
+		sys_threadsetarg(jobs[i].thread, &jobs[i]);
+		sys_threadstart(jobs[i].thread);
+	}
+
+	for (i = 0, rc = 0; i < ARRSIZE(jobs); i++) {
+		sys_threadwait(jobs[i].thread);
+		sys_threadfree(jobs[i].thread);
+
+		if (jobs[i].rc < 0) {
+			if (jobs[i].command == COMMAND_MODE_NONE) {
+				fprintf(stderr, "ERR : %c weight setup failed!\n", 'x' + jobs[i].axis);
+			} else if (jobs[i].command == COMMAND_MODE_VELOCITY) {
+				fprintf(stderr, "ERR : initial velocity setup failed!\n");
+			} else {
+				fprintf(stderr, "ERR : initial amplitude setup failed!\n");
+			}
+			rc = -1;
+		}
+
+		if (rc < 0) {
+			continue; // the rest still have to finish before we can free anything
+		}
+
+		if (i == 2) { // all of the weights are in
+			for (j = 0; rc == 0 && j < 6; j++) {
+				rc = lump_write(vtags[j], sizeof(f64) * vlen[j], load->vw[j], NULL);
+			}
+			for (j = 0; rc == 0 && j < 6; j++) {
+				rc = lump_write(wtags[j], sizeof(f64) * wlen[j], load->ww[j], NULL);
+			}
+		} else if (i == 3) {
+			rc = lump_write(MOLTSTR_VEL, sizeof(f64) * elems, load->vel, NULL);
+		} else if (i == 4) {
+			rc = lump_write(MOLTSTR_AMP, sizeof(f64) * elems, load->amp, NULL);
+		}
+	}
+
+	if (rc == 0) {
+		rc = setup_outputs(usercfg, load);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : output stream setup failed!\n");
+		}
+	}
+
+	if (rc < 0) {
+		sim_freeload(load);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* setup_thread : runs one of setup's jobs */
+void *setup_thread(void *arg)
+{
+	struct setupjob_t *job;
+	struct simload_t *load;
+	u64 start;
+	int i;
+
+	static char *names[] = {
+		"x weights", "y weights", "z weights", "initvel", "initamp"
+	};
+
+	job = arg;
+	load = job->load;
+
+	start = sys_nanotime();
+
+	if (job->command == COMMAND_MODE_NONE) {
+		i = job->axis * 2;
+		job->rc = setup_weights(&load->config, job->usercfg->weightcache, job->axis, load->vw[i], load->vw[i + 1], load->ww[i], load->ww[i + 1]);
+	} else {
+		job->rc = setup_initcommand(job->usercfg, &load->config, job->command,
+				job->command == COMMAND_MODE_VELOCITY ? load->vel : load->amp);
+	}
+
+	trace_span(names[job->axis], start, sys_nanotime());
+
+	return NULL;
+}
+
+/* restart_validate : checks that the lump file can be picked up where it left off */
+int restart_validate(struct user_cfg_t *usercfg)
+{
+	struct molt_cfg_t expect;
+
+	// the config we would have written has to match the one we did write,
+	// otherwise we'd be continuing a different simulation
+	if (usercfg->isset) {
+		setup_makeconfig(usercfg, &expect);
+		return restart_check(&expect);
+	}
+
+	return restart_check(NULL);
+}
+
+/* setup_makeconfig : builds the simulation config from the user's config */
+void setup_makeconfig(struct user_cfg_t *ucfg, struct molt_cfg_t *cfg)
 {
 	struct molt_cfg_t config;
 	s32 tpoints, xpoints, ypoints, zpoints;
@@ -621,179 +1661,198 @@ int setup_config(struct user_cfg_t *ucfg)
 
 	molt_cfg_set_nu(&config);
 
-	return lump_write(MOLTSTR_CONFIG, sizeof(config), &config, NULL);
+	*cfg = config;
 }
 
-/* setup_vweight : sets up the v weights */
-int setup_vweight()
+/* setup_weights : works out the v and w weights for one axis, going through the weight cache in cachedir if there is one */
+int setup_weights(struct molt_cfg_t *config, char *cachedir, int axis, f64 *vl, f64 *vr, f64 *wl, f64 *wr)
 {
-	struct molt_cfg_t config;
-	f64 *vlx, *vrx;
-	f64 *vly, *vry;
-	f64 *vlz, *vrz;
-	ivec3_t start, stop;
-	ivec3_t dim;
+	ivec3_t start, stop, dim, points;
+	f64 *tmp;
 	s64 i;
-	int rc;
 
-	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
-	if (rc < 0) {
-		return -1;
+	molt_cfg_parampull_xyz(config, start, MOLT_PARAM_START);
+	molt_cfg_parampull_xyz(config, stop, MOLT_PARAM_STOP);
+	molt_cfg_parampull_xyz(config, dim, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(config, points, MOLT_PARAM_POINTS);
+
+	// the z pair has always gone out the other way around, VLZ counting back
+	// from stop, and it stays that way so results don't change
+	if (axis == 2) {
+		tmp = vl;
+		vl = vr;
+		vr = tmp;
 	}
 
-	molt_cfg_parampull_xyz(&config, start, MOLT_PARAM_START);
-	molt_cfg_parampull_xyz(&config, stop, MOLT_PARAM_STOP);
-	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
-
-	vlx = calloc(dim[0], sizeof(f64));
-	vrx = calloc(dim[0], sizeof(f64));
-	vly = calloc(dim[1], sizeof(f64));
-	vry = calloc(dim[1], sizeof(f64));
-	vlz = calloc(dim[2], sizeof(f64));
-	vrz = calloc(dim[2], sizeof(f64));
-
-	for (i = 0; i < dim[0]; i++) { // vlx
-		vlx[i] = exp((-config.alpha) * config.space_scale * (i - start[0]));
+	for (i = 0; i < dim[axis]; i++) {
+		vl[i] = exp((-config->alpha) * config->space_scale * (i - start[axis]));
+		vr[i] = exp((-config->alpha) * config->space_scale * (stop[axis] - i));
 	}
 
-	for (i = 0; i < dim[0]; i++) { // vrx
-		vrx[i] = exp((-config.alpha) * config.space_scale * (stop[0] - i));
+	// the cache is only ever a shortcut, if it can't be used, we make them
+	if (wcache_load(cachedir, config->nu[axis], points[axis], config->spaceacc, wl, wr) < 0) {
+		setup_makeweights(config->nu[axis], wl, wr, points[axis], config->spaceacc);
+		if (cachedir && wcache_store(cachedir, config->nu[axis], points[axis], config->spaceacc, wl, wr) < 0) {
+			fprintf(stderr, "WRN : couldn't save the weights to the weight cache '%s'\n", cachedir);
+		}
 	}
 
-	for (i = 0; i < dim[1]; i++) { // vly
-		vly[i] = exp((-config.alpha) * config.space_scale * (i - start[1]));
-	}
+	return 0;
+}
 
-	for (i = 0; i < dim[1]; i++) { // vry
-		vry[i] = exp((-config.alpha) * config.space_scale * (stop[1] - i));
-	}
+/* setup_makeweights : molt_get_exp_weights, with the rows split over every core */
+void setup_makeweights(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm)
+{
+	struct weightjob_t *jobs;
+	struct sys_thread **threads;
+	f64 *phi, *work;
+	s64 worklen;
+	int i, n;
 
-	for (i = 0; i < dim[2]; i++) { // vlz
-		vrz[i] = exp((-config.alpha) * config.space_scale * (i - start[2]));
-	}
+	/*
+	 * NOTE
+	 * Every row is independent, and comes out the same no matter who makes it,
+	 * so this is bit for bit what molt_get_exp_weights gives. All of the
+	 * memory is got here, once, and handed out, so the rows themselves never
+	 * allocate anything.
+	 */
 
-	for (i = 0; i < dim[2]; i++) { // vrz
-		vlz[i] = exp((-config.alpha) * config.space_scale * (stop[2] - i));
+	n = sys_numcores();
+	if (nulen < n) {
+		n = nulen;
+	}
+	if (n < 1) {
+		n = 1;
 	}
 
-	lump_write(MOLTSTR_VLX, sizeof(f64) * dim[0], vlx, NULL);
-	lump_write(MOLTSTR_VRX, sizeof(f64) * dim[0], vrx, NULL);
-	lump_write(MOLTSTR_VLY, sizeof(f64) * dim[1], vly, NULL);
-	lump_write(MOLTSTR_VRY, sizeof(f64) * dim[1], vry, NULL);
-	lump_write(MOLTSTR_VLZ, sizeof(f64) * dim[2], vlz, NULL);
-	lump_write(MOLTSTR_VRZ, sizeof(f64) * dim[2], vrz, NULL);
+	worklen = molt_get_exp_worklen(orderm);
+
+	phi = calloc(orderm + 1, sizeof(f64));
+	work = calloc(n * worklen, sizeof(f64));
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	// the coefficients only depend on nu, every row shares them
+	molt_exp_coeff(phi, orderm + 1, nu);
+
+	for (i = 0; i < n; i++) {
+		jobs[i].nu = nu;
+		jobs[i].wl = wl;
+		jobs[i].wr = wr;
+		jobs[i].phi = phi;
+		jobs[i].work = work + i * worklen;
+		jobs[i].nulen = nulen;
+		jobs[i].orderm = orderm;
+		jobs[i].start = (s32)((s64)nulen * i / n);
+		jobs[i].stop = (s32)((s64)nulen * (i + 1) / n);
+
+		threads[i] = sys_threadcreate();
+		sys_threadsetfunc(threads[i], setup_makeweights_thread);
+		sys_threadsetarg(threads[i], &jobs[i]);
+		sys_threadstart(threads[i]);
+	}
 
-	free(vlx);
-	free(vrx);
-	free(vly);
-	free(vry);
-	free(vlz);
-	free(vrz);
+	for (i = 0; i < n; i++) {
+		sys_threadwait(threads[i]);
+		sys_threadfree(threads[i]);
+	}
 
-	return 0;
+	free(jobs);
+	free(threads);
+	free(work);
+	free(phi);
 }
 
-/* setup_wweight : sets up the w weights */
-int setup_wweight()
+/* setup_makeweights_thread : makes one job's rows of weights */
+void *setup_makeweights_thread(void *arg)
 {
-	s64 wlx_items, wrx_items;
-	s64 wly_items, wry_items;
-	s64 wlz_items, wrz_items;
-	f64 *wlx, *wrx;
-	f64 *wly, *wry;
-	f64 *wlz, *wrz;
-	struct molt_cfg_t config;
-	int rc;
+	struct weightjob_t *job;
 
-	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
-	if (rc < 0) {
-		return -1;
-	}
+	job = arg;
 
-	wlx_items = config.x_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-	wrx_items = config.x_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-	wly_items = config.y_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-	wry_items = config.y_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-	wlz_items = config.z_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-	wrz_items = config.z_params[MOLT_PARAM_POINTS] * (config.spaceacc + 1);
-
-	// allocate memory for the results
-	wlx = calloc(wlx_items, sizeof(f64));
-	wrx = calloc(wrx_items, sizeof(f64));
-	wly = calloc(wly_items, sizeof(f64));
-	wry = calloc(wry_items, sizeof(f64));
-	wlz = calloc(wlz_items, sizeof(f64));
-	wrz = calloc(wrz_items, sizeof(f64));
-
-	molt_get_exp_weights(config.nu[0], wlx, wrx, config.x_params[MOLT_PARAM_POINTS], config.spaceacc);
-	molt_get_exp_weights(config.nu[1], wly, wry, config.y_params[MOLT_PARAM_POINTS], config.spaceacc);
-	molt_get_exp_weights(config.nu[2], wlz, wrz, config.z_params[MOLT_PARAM_POINTS], config.spaceacc);
-
-	// TODO (brian)
-	// think of an elegant way to error and return here if needed
-	lump_write(MOLTSTR_WLX, sizeof(f64) * wlx_items, wlx, NULL);
-	lump_write(MOLTSTR_WRX, sizeof(f64) * wrx_items, wrx, NULL);
-	lump_write(MOLTSTR_WLY, sizeof(f64) * wly_items, wly, NULL);
-	lump_write(MOLTSTR_WRY, sizeof(f64) * wry_items, wry, NULL);
-	lump_write(MOLTSTR_WLZ, sizeof(f64) * wlz_items, wlz, NULL);
-	lump_write(MOLTSTR_WRZ, sizeof(f64) * wrz_items, wrz, NULL);
-
-	free(wlx);
-	free(wrx);
-	free(wly);
-	free(wry);
-	free(wlz);
-	free(wrz);
+	molt_get_exp_rows(job->nu, job->wl, job->wr, job->nulen, job->orderm, job->start, job->stop, job->phi, job->work);
 
-	return 0;
+	return NULL;
 }
 
-/* setup_initcommand : runs the command specified in the config, if found */
-int setup_initcommand(struct user_cfg_t *usercfg, int command)
+/* setup_initcommand : fills vol with the initial condition from the config, if there is one */
+int setup_initcommand(struct user_cfg_t *usercfg, struct molt_cfg_t *config, int command, f64 *vol)
 {
-	// NOTE
-	// this function allocates storage and commite it into the lump system
-	struct molt_cfg_t config;
-	u64 elements;
-	f64 *hunk;
+	struct initfunc_t init;
+	struct initfile_t *file;
 	ivec3_t dim;
 	dvec3_t fdim;
-	char *lumpstr;
 	char *commandstr;
+	char *libstr;
 	FILE *pipe_read, *pipe_write;
 	struct configthreadargs_t args_read, args_write;
 	struct sys_thread *thread_reader, *thread_writer;
 	int rc;
 
-	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
-	if (rc < 0) {
-		return -1;
-	}
-
 	switch (command) {
 	case COMMAND_MODE_VELOCITY:
 		commandstr = usercfg->initvel;
-		lumpstr = MOLTSTR_VEL;
+		libstr = usercfg->initvel_lib;
+		file = &usercfg->initvel_file;
 		break;
 	case COMMAND_MODE_AMPLITUDE:
 		commandstr = usercfg->initamp;
-		lumpstr = MOLTSTR_AMP;
+		libstr = usercfg->initamp_lib;
+		file = &usercfg->initamp_file;
 		break;
 	default:
 		fprintf(stderr, "ERR in %s: command %d not recognized!\n",
 				__FUNCTION__, command);
-		break;
+		return -1;
 	}
 
-	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(config, dim, MOLT_PARAM_PINC);
 
 	Vec3Scale(fdim, dim, usercfg->scale_space);
 
-	elements = dim[0] * (u64)dim[1] * dim[2];
+	// a file that's already open beats everything else
+	if (file->data) {
+		return init_resample(file->data, file->dim, file->order, vol, dim);
+	}
 
-	hunk = calloc(elements, sizeof(f64));
+	rc = 0;
 
-	if (usercfg && usercfg->isset) {
+	// the built in initializers don't need a program at all
+	if (usercfg && usercfg->isset && libstr == NULL) {
+		rc = init_parse(&init, commandstr);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't parse initializer '%s'\n", commandstr);
+			return -1;
+		}
+
+		if (rc == 1) {
+			rc = init_fill(&init, vol, dim, usercfg->scale_space, MOLT_TISSUESPEED);
+			if (rc < 0) {
+				return -1;
+			}
+
+			rc = 1;
+		}
+	}
+
+	// a library beats a program, there's nothing to pipe anywhere
+	if (usercfg && usercfg->isset && libstr) {
+		rc = setup_initlib(libstr, command, vol, dim, usercfg->scale_space);
+		if (rc < 0) {
+			return -1;
+		}
+	} else if (usercfg && usercfg->isset && commandstr && rc == 0 && usercfg->init_binary) {
+		rc = setup_initbinary(commandstr, vol, dim, usercfg->scale_space);
+		if (rc == 0) {
+			fprintf(stderr, "ERR : init program '%s' didn't answer with a %s header, is it a text protocol one?\n", commandstr, INIT_MAGIC);
+		}
+		if (rc <= 0) {
+			return -1;
+		}
+	}
+
+	// programs that only know the text protocol get a line per point
+	if (usercfg && usercfg->isset && libstr == NULL && commandstr && rc == 0) {
 		rc = sys_bipopen(&pipe_read, &pipe_write, commandstr);
 		if (rc < 0) {
 			return -1;
@@ -803,8 +1862,8 @@ int setup_initcommand(struct user_cfg_t *usercfg, int command)
 		args_write.fp      = pipe_write;
 		args_read.usercfg  = usercfg;
 		args_write.usercfg = usercfg;
-		args_read.vol      = hunk;
-		args_write.vol     = hunk;
+		args_read.vol      = vol;
+		args_write.vol     = vol;
 		Vec3Copy(args_read.dim, dim);
 		Vec3Copy(args_write.dim, dim);
 		Vec3Copy(args_read.fdim, fdim);
@@ -829,13 +1888,316 @@ int setup_initcommand(struct user_cfg_t *usercfg, int command)
 		rc = sys_threadfree(thread_reader);
 	}
 
-	rc = lump_write(lumpstr, sizeof(f64) * elements, hunk, NULL);
+	return 0;
+}
 
-	free(hunk);
+/* setup_initbinary : runs an init program with the binary protocol, returns 0 if it doesn't speak it */
+int setup_initbinary(char *command, f64 *vol, ivec3_t dim, f64 scale)
+{
+	FILE *pipe_read, *pipe_write;
+	int rc;
+
+	// only used when the config asks for it (init_protocol: binary), see init_binaryask
+	rc = sys_bipopen(&pipe_read, &pipe_write, command);
+	if (rc < 0) {
+		return -1;
+	}
+
+	rc = init_binaryask(pipe_write, dim, scale);
+	fclose(pipe_write);
+
+	if (rc == 0) {
+		rc = init_binaryread(pipe_read, vol, dim);
+	}
+
+	fclose(pipe_read);
+
+	if (rc < 0) {
+		fprintf(stderr, "ERR : init program '%s' didn't follow the binary protocol\n", command);
+	}
 
 	return rc;
 }
 
+/* setup_initlib : fills vol with an init library's fill function, in z slabs over every core */
+int setup_initlib(char *libname, int command, f64 *vol, ivec3_t dim, f64 scale)
+{
+	struct initlibjob_t *jobs;
+	struct sys_thread **threads;
+	initfill_func fill;
+	char *symbol;
+	void *lib;
+	int i, n;
+
+	symbol = command == COMMAND_MODE_VELOCITY ? "molt_initvel_fill" : "molt_initamp_fill";
+
+	lib = sys_libopen(libname);
+	if (lib == NULL) {
+		fprintf(stderr, "ERR : couldn't open init library '%s'\n", libname);
+		return -1;
+	}
+
+	fill = (initfill_func)sys_libsym(lib, symbol);
+	if (fill == NULL) {
+		fprintf(stderr, "ERR : init library '%s' doesn't have %s\n", libname, symbol);
+		sys_libclose(lib);
+		return -1;
+	}
+
+	n = sys_numcores();
+	if (dim[2] < n) {
+		n = dim[2];
+	}
+	if (n < 1) {
+		n = 1;
+	}
+
+	jobs = calloc(n, sizeof(*jobs));
+	threads = calloc(n, sizeof(*threads));
+
+	for (i = 0; i < n; i++) {
+		jobs[i].fill = fill;
+		jobs[i].vol = vol;
+		jobs[i].scale = scale;
+		jobs[i].thread = i;
+		jobs[i].threads = n;
+		Vec3Copy(jobs[i].dim, dim);
+		Vec3Scale(jobs[i].fdim, dim, scale);
+
+		threads[i] = sys_threadcreate();
+		sys_threadsetfunc(threads[i], setup_initlib_thread);
+		sys_threadsetarg(threads[i], &jobs[i]);
+		sys_threadstart(threads[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		sys_threadwait(threads[i]);
+		sys_threadfree(threads[i]);
+	}
+
+	free(jobs);
+	free(threads);
+
+	sys_libclose(lib);
+
+	return 0;
+}
+
+/* setup_initlib_thread : fills one job's slab of z planes */
+void *setup_initlib_thread(void *arg)
+{
+	struct initlibjob_t *job;
+	f64 *xyz, *p;
+	u64 plane;
+	s32 x, y, z, zstart, zstop;
+
+	job = arg;
+
+	// each thread gets a contiguous run of planes, so the pages it touches are its own
+	zstart = (s32)((s64)job->dim[2] * job->thread / job->threads);
+	zstop = (s32)((s64)job->dim[2] * (job->thread + 1) / job->threads);
+
+	plane = job->dim[0] * (u64)job->dim[1];
+
+	xyz = calloc(plane * 3, sizeof(f64));
+
+	for (z = zstart; z < zstop; z++) {
+		for (y = 0, p = xyz; y < job->dim[1]; y++) {
+			for (x = 0; x < job->dim[0]; x++, p += 3) {
+				p[0] = x * job->scale;
+				p[1] = y * job->scale;
+				p[2] = z * job->scale;
+			}
+		}
+
+		job->fill(xyz, job->vol + z * plane, plane, job->fdim);
+	}
+
+	free(xyz);
+
+	return NULL;
+}
+
+/* setup_parseinitfile : parses an initvel_file or initamp_file option, "<path> [key=value ...]" */
+int setup_parseinitfile(struct initfile_t *file, char *s, char *tag)
+{
+	char buf[BUFLARGE];
+	char *tok, *val, *save;
+	int n;
+
+	free(file->path);
+	memset(file, 0, sizeof(*file));
+
+	strncpy(buf, s, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+
+	tok = strtoks(buf, " \t", &save);
+	if (tok == NULL) {
+		return 0; // an empty option is no file at all
+	}
+
+	strncpy(file->tag, tag, sizeof(file->tag));
+	strcpy(file->order, "xyz");
+
+	file->path = strdup(tok);
+
+	while ((tok = strtoks(NULL, " \t", &save)) != NULL) {
+		val = strchr(tok, '=');
+		if (val == NULL) {
+			break;
+		}
+
+		*val++ = 0;
+		n = -1;
+
+		if (strcmp(tok, "dim") == 0) {
+			sscanf(val, "%d,%d,%d%n", &file->dim[0], &file->dim[1], &file->dim[2], &n);
+		} else if (strcmp(tok, "order") == 0 && strlen(val) == 3) {
+			// a permutation of "xyz"
+			if (strchr(val, 'x') && strchr(val, 'y') && strchr(val, 'z')) {
+				strcpy(file->order, val);
+				n = 3;
+			}
+		} else if (strcmp(tok, "tag") == 0 && 0 < strlen(val) && strlen(val) <= sizeof(file->tag)) {
+			memset(file->tag, 0, sizeof(file->tag));
+			memcpy(file->tag, val, strlen(val));
+			n = strlen(val);
+		} else if (strcmp(tok, "entry") == 0) {
+			sscanf(val, "%ld%n", &file->entry, &n);
+		}
+
+		if (n < 0 || val[n]) {
+			break;
+		}
+	}
+
+	if (tok != NULL || file->dim[0] < 0 || file->dim[1] < 0 || file->dim[2] < 0) {
+		free(file->path);
+		memset(file, 0, sizeof(*file));
+		return -1;
+	}
+
+	return 0;
+}
+
+/* setup_openinitfile : opens the file's volume, mapping raw files, reading lump file volumes in */
+int setup_openinitfile(struct initfile_t *file, ivec3_t grid)
+{
+	struct molt_cfg_t config;
+	sys_file *fd;
+	u64 entries, elems;
+	size_t size;
+	u32 magic;
+	int rc;
+
+	if (file->path == NULL) {
+		return 0;
+	}
+
+	fd = sys_openread(file->path);
+	if (fd == NULL) {
+		fprintf(stderr, "ERR : couldn't open initial condition file '%s'\n", file->path);
+		return -1;
+	}
+
+	magic = 0;
+	sys_read(fd, 0, sizeof(magic), &magic);
+
+	if (magic == *(u32 *)"MOLT") { // it's a lump file, its config says how big its volumes are
+		sys_close(fd);
+		free(fd);
+
+		rc = lump_openmap(file->path);
+		if (rc < 0) {
+			fprintf(stderr, "ERR : couldn't open lump file '%s', %s\n", file->path, lump_strerror(rc));
+			return -1;
+		}
+
+		rc = lump_read(MOLTSTR_CONFIG, 0, &config);
+		if (rc == 0 && file->entry < 0) {
+			rc = lump_getnumentries(file->tag, &entries);
+			file->entry = entries + file->entry;
+			if (file->entry < 0) {
+				rc = -1;
+			}
+		}
+
+		if (rc == 0) {
+			molt_cfg_parampull_xyz(&config, file->dim, MOLT_PARAM_PINC);
+			strcpy(file->order, "xyz");
+
+			elems = file->dim[0] * (u64)file->dim[1] * file->dim[2];
+
+			rc = lump_readsize(file->tag, file->entry, &size);
+			if (rc == 0 && size != elems * sizeof(f64)) {
+				rc = -1;
+			}
+		}
+
+		if (rc == 0) {
+			file->data = malloc(size);
+			rc = lump_read(file->tag, file->entry, file->data);
+		}
+
+		lump_close();
+
+		if (rc < 0) {
+			fprintf(stderr, "ERR : '%s' doesn't have a %.8s[%ld] volume\n", file->path, file->tag, file->entry);
+			free(file->data);
+			file->data = NULL;
+			return -1;
+		}
+
+		return 0;
+	}
+
+	// a raw file without a dim is the same size as our grid
+	if (file->dim[0] == 0 && file->dim[1] == 0 && file->dim[2] == 0) {
+		Vec3Copy(file->dim, grid);
+	}
+
+	elems = file->dim[0] * (u64)file->dim[1] * file->dim[2];
+
+	file->maplen = sys_getsize(fd);
+
+	if (elems == 0 || file->maplen != elems * sizeof(f64)) {
+		fprintf(stderr, "ERR : '%s' is %ld bytes, but dim=%d,%d,%d needs %ld\n",
+				file->path, file->maplen, file->dim[0], file->dim[1], file->dim[2], elems * sizeof(f64));
+		sys_close(fd);
+		free(fd);
+		return -1;
+	}
+
+	file->data = sys_mmap(fd, file->maplen);
+	if (file->data == NULL) {
+		sys_close(fd);
+		free(fd);
+		return -1;
+	}
+
+	file->fd = fd;
+
+	sys_madvise(file->data, file->maplen, SYS_ADVISE_WILLNEED);
+
+	return 0;
+}
+
+/* setup_closeinitfile : unmaps or frees the file's volume */
+void setup_closeinitfile(struct initfile_t *file)
+{
+	if (file->fd) {
+		sys_munmap(file->data, file->maplen);
+		sys_close(file->fd);
+		free(file->fd);
+	} else {
+		free(file->data);
+	}
+
+	file->data = NULL;
+	file->fd = NULL;
+	file->maplen = 0;
+}
+
 /* setup_customprog_write : function for threading setup */
 void *setup_customprog_write(void *arg)
 {
@@ -852,7 +2214,6 @@ void *setup_customprog_write(void *arg)
 	Vec3Copy(fout, cargs->fdim);
 
 	fprintf(cargs->fp, "%lf\t%lf\t%lf\n", fout[0], fout[1], fout[2]);
-	fflush(cargs->fp);
 
 	elements = (u64)cargs->dim[0] * cargs->dim[1] * cargs->dim[2];
 	lines = 0;
@@ -863,7 +2224,6 @@ void *setup_customprog_write(void *arg)
 				Vec3Copy(fout, curr);
 				Vec3Scale(fout, curr, scale);
 				fprintf(cargs->fp, "%lf\t%lf\t%lf\n", fout[0], fout[1], fout[2]);
-				fflush(cargs->fp);
 				lines++;
 			}
 		}
@@ -879,54 +2239,144 @@ void *setup_customprog_write(void *arg)
 	return NULL;
 }
 
-/* setup_customprog_read : function for setup reading (parent <- child) */
-void *setup_customprog_read(void *arg)
+/* setup_customprog_read : function for setup reading (parent <- child) */
+void *setup_customprog_read(void *arg)
+{
+	struct configthreadargs_t *cargs;
+	u64 pos;
+	u64 lines, elements;
+	ivec3_t curr;
+	char buf[BUFLARGE];
+
+	cargs = arg;
+
+	elements = (u64)cargs->dim[0] * cargs->dim[1] * cargs->dim[2];
+	lines = 0;
+
+	for (curr[0] = 0; curr[0] < cargs->dim[0]; curr[0]++) {
+		for (curr[1] = 0; curr[1] < cargs->dim[1]; curr[1]++) {
+			for (curr[2] = 0; curr[2] < cargs->dim[2]; curr[2]++) {
+				if (fgets(buf, sizeof(buf), cargs->fp) != buf) {
+					break;
+				}
+				pos = (curr[2] * (u64)cargs->dim[1] + curr[1]) * cargs->dim[0] + curr[0];
+				cargs->vol[pos] = atof(buf);
+				lines++;
+			}
+		}
+	}
+
+	if (lines != elements) {
+		fprintf(stderr, "ERR : expected to read %ld lines from init program, got %ld\n",
+				elements, lines);
+	}
+
+	fclose(cargs->fp);
+
+	return NULL;
+}
+
+/* dump_getlump : returns a view of the lump, or reads it into buf */
+f64 *dump_getlump(char *tag, u64 entry, f64 *buf)
+{
+	const void *ptr;
+	int rc;
+
+	rc = lump_view(tag, entry, &ptr, NULL);
+	if (rc == 0) {
+		return (f64 *)ptr;
+	}
+
+	rc = lump_read(tag, entry, buf);
+	if (rc < 0) {
+		return NULL;
+	}
+
+	return buf;
+}
+
+/* dump_rows : prints a lump of stats or probe rows */
+int dump_rows(char *tag, u64 entry, struct outstream_t *stream, char *msg)
+{
+	struct outstat_t *stat;
+	struct outprobe_t *probe;
+	size_t size, i;
+	void *rows;
+	int rc;
+
+	rc = lump_readsize(tag, entry, &size);
+	if (rc < 0) {
+		return -1;
+	}
+
+	rows = malloc(size);
+
+	rc = lump_read(tag, entry, rows);
+	if (rc < 0) {
+		free(rows);
+		return -1;
+	}
+
+	for (i = 0; i < size / output_rowsize(stream); i++) {
+		if (stream->kind == OUTPUT_STATS) {
+			stat = (struct outstat_t *)rows + i;
+			printf("%s step %4ld : l2 %e, energy %e, max |u| %e at (%d, %d, %d)\n",
+				msg, stat->step, stat->l2, stat->energy, stat->maxabs, stat->maxat[0], stat->maxat[1], stat->maxat[2]);
+		} else {
+			probe = (struct outprobe_t *)rows + i;
+			printf("%s step %4ld : %e\n", msg, probe->step, probe->value);
+		}
+	}
+
+	free(rows);
+
+	return 0;
+}
+
+/* dump_slice : prints a single plane of a volume lump */
+int dump_slice(char *tag, u64 entry, ivec3_t dim, s32 axis, s32 index, char *msg)
 {
-	struct configthreadargs_t *cargs;
-	u64 pos;
-	u64 lines, elements;
-	ivec3_t curr;
-	char buf[BUFLARGE];
+	ivec3_t start, count;
+	f64 *plane;
+	int rc;
 
-	cargs = arg;
+	Vec3Set(start, 0, 0, 0);
+	Vec3Copy(count, dim);
 
-	elements = (u64)cargs->dim[0] * cargs->dim[1] * cargs->dim[2];
-	lines = 0;
+	start[axis] = index;
+	count[axis] = 1;
 
-	for (curr[0] = 0; curr[0] < cargs->dim[0]; curr[0]++) {
-		for (curr[1] = 0; curr[1] < cargs->dim[1]; curr[1]++) {
-			for (curr[2] = 0; curr[2] < cargs->dim[2]; curr[2]++) {
-				fgets(buf, sizeof(buf), cargs->fp);
-				pos = IDX3D(curr[0], curr[1], curr[2], cargs->dim[1], cargs->dim[2]);
-				cargs->vol[pos] = atof(buf);
-				lines++;
-			}
-		}
-	}
+	plane = calloc(count[0] * (u64)count[1] * count[2], sizeof(f64));
 
-	if (lines != elements) {
-		fprintf(stderr, "ERR : expected to read %ld lines from init program, got %ld\n",
-				elements, lines);
+	rc = lump_read_slab(tag, entry, dim, start, count, plane);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't read %c=%d of %s[%ld]\n", 'x' + axis, index, tag, entry);
+	} else {
+		LOG3DSLAB(plane, start, count, msg);
 	}
 
-	fclose(cargs->fp);
+	free(plane);
 
-	return NULL;
+	return rc;
 }
 
 /* dump_lumps : prints a dump of all the lumps in the lump system */
-int dump_lumps()
+int dump_lumps(s32 axis, s32 index)
 {
 	struct lumpheader_t lheader;
 	struct lumpinfo_t linfo;
 	struct molt_cfg_t config;
 	struct simtimeinfo_t *timeinfo;
-	f64 *fptr;
+	struct profstep_t *profile;
+	struct outstream_t *streams, *stream;
+	s64 nstreams, k;
+	f64 *fptr, *p;
 	u64 i, j;
-	ivec3_t dim;
+	ivec3_t dim, sdim;
 	ivec2_t weight_dim;
 	int rc;
 	char buf[BUFSMALL];
+	char tag[sizeof(linfo.tag) + 1];
 
 	// NOTE
 	// we follow a super easy pattern
@@ -938,11 +2388,16 @@ int dump_lumps()
 	}
 
 	printf("header:\n");
-	printf("\tmagic      : %s\n",   (char *)&lheader.magic);
+	printf("\tmagic      : %.4s\n", (char *)&lheader.magic);
+	printf("\tversion    : %u\n",  lheader.version);
 	printf("\tflags      : 0x%X\n", lheader.flags);
 	printf("\tts_created : %ld\n",  lheader.ts_created);
 	printf("\tsize       : %ld\n",  lheader.size);
 	printf("\tlumps      : %ld\n",  lheader.lumps);
+	printf("\ttable      : 0x%lX\n", lheader.table);
+	if (lheader.shards) {
+		printf("\tshards     : %ld\n", lheader.shards);
+	}
 
 	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
 	if (rc < 0) {
@@ -950,136 +2405,197 @@ int dump_lumps()
 	}
 
 	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
+
+	// a mapped lump file hands out views into itself, but encoded lumps and
+	// unmapped files still need a volume's worth of scratch space to copy into
 	fptr = calloc(sizeof(f64), dim[0] * (u64)dim[1] * dim[2]);
 
+	nstreams = sim_loadoutputs(&streams);
+	if (nstreams < 0) {
+		free(fptr);
+		return -1;
+	}
+
 	// iterate through the lump table to dump the table metadata
 	for (i = 0; i < lheader.lumps; i++) {
 		rc = lump_getinfo(&linfo, i);
 
 		rc = strnlen(linfo.tag, 8); // WARNING UNSAFE FOR 8 CHAR STRINGS!!!
 
-		printf("Lump [%s%*s][%4ld] off: 0x%010lX, entry: %4ld, bytes : %ld\n",
+		printf("Lump [%.8s%*s][%4ld] off: 0x%010lX, entry: %4ld, bytes : %ld",
 				linfo.tag, 8 - rc, "", i, linfo.offset, linfo.entry, linfo.size);
+
+		if (linfo.codec != CODEC_NONE || linfo.flags) {
+			printf(" (%s%s%s%s, %ld raw", codec_tostr(linfo.codec),
+					linfo.flags & LUMP_FLAG_DELTA ? " delta" : "", linfo.flags & LUMP_FLAG_BRICKED ? " bricked" : "",
+					linfo.flags & LUMP_FLAG_SHARDED ? " sharded" : "", linfo.rawsize);
+			if (linfo.maxerr != 0) {
+				printf(", error <= %g", linfo.maxerr);
+			}
+			printf(")");
+		}
+
+		printf("\n");
 	}
 
-	// iterate through the lumps to dump the data
+	// iterate through the lumps to dump the data, stopping on one we can't read
 	for (i = 0; i < lheader.lumps; i++) {
 		rc = lump_getinfo(&linfo, i);
 
 		if (strncmp(linfo.tag, MOLTSTR_CONFIG, sizeof(linfo.tag)) == 0) {
 			molt_cfg_print(&config); // no need to reload the config
 		} else if (strncmp(linfo.tag, MOLTSTR_VLX, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VLX, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VLX, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VLX);
+			LOG1D(p, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VLX);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VRX, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VRX, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VRX, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VRX);
+			LOG1D(p, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VRX);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VLY, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VLY, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VLY, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VLY);
+			LOG1D(p, config.y_params[MOLT_PARAM_PINC], MOLTSTR_VLY);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VRY, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VRY, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VRY, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VRY);
+			LOG1D(p, config.y_params[MOLT_PARAM_PINC], MOLTSTR_VRY);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VLZ, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VLZ, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VLZ, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VLZ);
+			LOG1D(p, config.z_params[MOLT_PARAM_PINC], MOLTSTR_VLZ);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VRZ, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VRZ, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_VRZ, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG1D(fptr, config.x_params[MOLT_PARAM_PINC], MOLTSTR_VRZ);
+			LOG1D(p, config.z_params[MOLT_PARAM_PINC], MOLTSTR_VRZ);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WLX, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WLX, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WLX, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.x_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WLX);
+			LOG2D(p, weight_dim, MOLTSTR_WLX);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WRX, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WRX, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WRX, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.x_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WRX);
+			LOG2D(p, weight_dim, MOLTSTR_WRX);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WLY, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WLY, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WLY, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.y_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WLY);
+			LOG2D(p, weight_dim, MOLTSTR_WLY);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WRY, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WRY, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WRY, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.y_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WRY);
+			LOG2D(p, weight_dim, MOLTSTR_WRY);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WLZ, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WLZ, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WLZ, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.z_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WLZ);
+			LOG2D(p, weight_dim, MOLTSTR_WLZ);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_WRZ, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_WRZ, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			p = dump_getlump(MOLTSTR_WRZ, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
 			Vec2Set(weight_dim, config.z_params[MOLT_PARAM_POINTS], config.spaceacc + 1);
-			LOG2D(fptr, weight_dim, MOLTSTR_WRZ);
+			LOG2D(p, weight_dim, MOLTSTR_WRZ);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_VEL, sizeof(linfo.tag)) == 0) {
-			rc = lump_read(MOLTSTR_VEL, 0, fptr);
-			if (rc < 0) {
-				return -1;
+			if (0 <= axis) {
+				rc = dump_slice(MOLTSTR_VEL, 0, dim, axis, index, MOLTSTR_VEL);
+				if (rc < 0) {
+					break;
+				}
+				continue;
+			}
+
+			p = dump_getlump(MOLTSTR_VEL, 0, fptr);
+			if (p == NULL) {
+				break;
 			}
-			LOG3D(fptr, dim, MOLTSTR_VEL);
+			LOG3D(p, dim, MOLTSTR_VEL);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_AMP, sizeof(linfo.tag)) == 0) {
-			if (rc < 0) { return -1; }
 			snprintf(buf, sizeof buf, "AMP[%ld]", linfo.entry);
-			LOG3D(fptr, dim, buf);
+
+			if (0 <= axis) { // only pull the plane we care about off of disk
+				rc = dump_slice(MOLTSTR_AMP, linfo.entry, dim, axis, index, buf);
+				if (rc < 0) {
+					break;
+				}
+				continue;
+			}
+
+			// timesteps are scanned in order, so have the next one paged in
+			// while we print this one, and drop this one when we're done
+			lump_advise(MOLTSTR_AMP, linfo.entry, SYS_ADVISE_SEQUENTIAL);
+			lump_advise(MOLTSTR_AMP, linfo.entry + 1, SYS_ADVISE_WILLNEED);
+
+			p = dump_getlump(MOLTSTR_AMP, linfo.entry, fptr);
+			if (p == NULL) {
+				break;
+			}
+			LOG3D(p, dim, buf);
+
+			lump_advise(MOLTSTR_AMP, linfo.entry, SYS_ADVISE_DONTNEED);
+
+		} else if (strncmp(linfo.tag, MOLTSTR_CHKPT, sizeof(linfo.tag)) == 0) {
+			struct chkpt_t chkpt;
+
+			rc = lump_read_range(MOLTSTR_CHKPT, linfo.entry, 0, sizeof(chkpt), &chkpt);
+			if (rc < 0) {
+				break;
+			}
+
+			printf("checkpoint[%ld] : seq %ld, t %ld, flags 0x%X, lumps %ld, volumes %d\n",
+				linfo.entry, chkpt.seq, chkpt.t, chkpt.flags, chkpt.lumps, chkpt.volumes);
 
 		} else if (strncmp(linfo.tag, MOLTSTR_TIME, sizeof(linfo.tag)) == 0) {
-			timeinfo = calloc(1, linfo.size);
-			rc = lump_read(MOLTSTR_TIME, 0, timeinfo);
+			timeinfo = calloc(1, linfo.rawsize);
+			rc = lump_read(MOLTSTR_TIME, linfo.entry, timeinfo);
 
 			if (rc < 0) {
 				free(timeinfo);
-				return -1;
+				break;
 			}
 
-			for (j = 0; j < config.t_params[MOLT_PARAM_STOP]; j++) {
+			// restarted runs write one TIME lump per run, each only as long as
+			// the steps that run actually took
+			for (j = 0; j < linfo.rawsize / sizeof(*timeinfo); j++) {
 				struct timeval s, e; 
 				f64 elapsed;
 
@@ -1094,14 +2610,297 @@ int dump_lumps()
 
 			free(timeinfo);
 
+		} else if (strncmp(linfo.tag, MOLTSTR_PROF, sizeof(linfo.tag)) == 0) {
+			profile = calloc(1, linfo.rawsize);
+			rc = lump_read(MOLTSTR_PROF, linfo.entry, profile);
+
+			if (rc < 0) {
+				free(profile);
+				break;
+			}
+
+			// like TIME, one of these per run, so a restarted run gets a table per run
+			printf("profile[%ld] : %ld steps\n", linfo.entry, linfo.rawsize / sizeof(*profile));
+			prof_summary(stdout, profile, linfo.rawsize / sizeof(*profile));
+
+			free(profile);
+
+		} else if (strncmp(linfo.tag, MOLTSTR_OUTPUT, sizeof(linfo.tag)) == 0) {
+			for (k = 0; k < nstreams; k++) {
+				stream = streams + k;
+				output_dim(stream, dim, sdim);
+				printf("output[%ld] : %.8s, %s, every %d", k, stream->tag, output_tostr(stream->kind), stream->every);
+				if (stream->kind == OUTPUT_PROBE) {
+					printf(", at (%d, %d, %d)", stream->start[0], stream->start[1], stream->start[2]);
+				} else if (stream->kind != OUTPUT_STATS) {
+					printf(", start (%d, %d, %d), dim (%d, %d, %d)",
+						stream->start[0], stream->start[1], stream->start[2], sdim[0], sdim[1], sdim[2]);
+				}
+				if (stream->kind == OUTPUT_DOWN) {
+					printf(", factor %d", stream->factor);
+				}
+				printf("\n");
+			}
+
 		} else {
-			printf("Lump [%.*s] doesn't have any logging logic!\n", (int)sizeof(linfo.tag), linfo.tag);
+			for (k = 0; k < nstreams; k++) {
+				if (strncmp(linfo.tag, streams[k].tag, sizeof(linfo.tag)) == 0) {
+					break;
+				}
+			}
+
+			if (k == nstreams) {
+				printf("Lump [%.*s] doesn't have any logging logic!\n", (int)sizeof(linfo.tag), linfo.tag);
+				continue;
+			}
+
+			stream = streams + k;
+
+			snprintf(buf, sizeof buf, "%.8s[%ld]", stream->tag, linfo.entry);
+
+			memset(tag, 0, sizeof(tag));
+			memcpy(tag, stream->tag, sizeof(stream->tag));
+
+			if (output_rowsize(stream)) {
+				rc = dump_rows(tag, linfo.entry, stream, buf);
+				if (rc < 0) {
+					break;
+				}
+				continue;
+			}
+
+			output_dim(stream, dim, sdim);
+
+			if (0 <= axis && stream->kind == OUTPUT_FULL) {
+				rc = dump_slice(tag, linfo.entry, dim, axis, index, buf);
+				if (rc < 0) {
+					break;
+				}
+				continue;
+			}
+
+			p = dump_getlump(tag, linfo.entry, fptr);
+			if (p == NULL) {
+				break;
+			}
+			LOG3DSLAB(p, stream->start, sdim, buf);
 		}
 	}
 
 	free(fptr);
+	free(streams);
 
-	return rc;
+	return i < lheader.lumps ? -1 : 0;
+}
+
+/* watch_live : follows a running simulation's live frame ring, printing frames as they come in */
+int watch_live(char *name, s32 axis, s32 index)
+{
+	struct live_t *live;
+	ivec3_t dim, start, count;
+	f64 *frame, lo, hi;
+	u64 head, step, i, elems;
+	char buf[BUFSMALL];
+	int rc;
+
+	/*
+	 * NOTE
+	 * We poll, and only ever print the newest frame, so a slow terminal just
+	 * skips frames instead of holding the simulation up. With --slice, only
+	 * that plane gets copied out of the ring, and printed, otherwise it's a
+	 * one line summary per frame.
+	 */
+
+	for (i = 0; (live = live_open(name)) == NULL; i++) {
+		if (i == 0) {
+			fprintf(stderr, "waiting for live frame ring '%s'\n", name);
+		}
+		sys_sleep(MOLT_LIVE_POLLMS);
+	}
+
+	live_getdim(live, dim);
+
+	Vec3Set(start, 0, 0, 0);
+	Vec3Copy(count, dim);
+
+	if (0 <= axis) {
+		if (index < 0 || dim[axis] <= index) {
+			fprintf(stderr, "ERR : %c=%d is outside of the frame\n", 'x' + axis, index);
+			live_close(live);
+			return -1;
+		}
+		start[axis] = index;
+		count[axis] = 1;
+	}
+
+	elems = count[0] * (u64)count[1] * count[2];
+	frame = calloc(elems, sizeof(f64));
+
+	for (head = 0; (rc = live_read(live, &head, frame, start, count, &step)) >= 0;) {
+		if (rc == 0) {
+			sys_sleep(MOLT_LIVE_POLLMS);
+			continue;
+		}
+
+		if (0 <= axis) {
+			snprintf(buf, sizeof buf, "LIVE[%ld]", step);
+			LOG3DSLAB(frame, start, count, buf);
+		} else {
+			for (i = 0, lo = hi = frame[0]; i < elems; i++) {
+				lo = frame[i] < lo ? frame[i] : lo;
+				hi = hi < frame[i] ? frame[i] : hi;
+			}
+			printf("frame %ld, step %ld : min %e, max %e\n", head, step, lo, hi);
+		}
+
+		fflush(stdout);
+	}
+
+	free(frame);
+	live_close(live);
+
+	return 0;
+}
+
+/* tail_lumps : follows a lump file while it's being written, printing AMP entries as they land */
+int tail_lumps(char *file, s32 axis, s32 index)
+{
+	struct molt_cfg_t config;
+	struct outstream_t *streams;
+	s64 nstreams;
+	ivec3_t dim;
+	f64 *vol, lo, hi;
+	u64 next, entries, done, step, i, elems;
+	char buf[BUFSMALL];
+	FILE *fp;
+	int rc, failed;
+
+	/*
+	 * NOTE
+	 * Unlike --watch, this reads the lump file itself, so every AMP entry gets
+	 * printed, not just the newest, and it can start (or catch up) at any point
+	 * in the run. The simulation doesn't know we're here. It's done when the
+	 * TIME lump shows up, which is the last thing a run writes.
+	 *
+	 * If the run restarts from a checkpoint, the lumps after it get dropped,
+	 * and we go back to printing from wherever they were dropped to.
+	 *
+	 * We only wait on a file that isn't there yet (or hasn't got its header
+	 * yet). Anything else wrong with it is never going to fix itself.
+	 */
+
+	for (i = 0;; i++) {
+		fp = fopen(file, "rb");
+		if (fp) {
+			fclose(fp);
+
+			rc = lump_openfollow(file);
+			if (rc == 0) {
+				break;
+			}
+
+			if (rc != LUMP_ENOFILE) {
+				fprintf(stderr, "ERR : couldn't follow lump file '%s', %s\n", file, lump_strerror(rc));
+				return -1;
+			}
+		}
+
+		if (i == 0) {
+			fprintf(stderr, "waiting for lump file '%s'\n", file);
+		}
+		sys_sleep(MOLT_TAIL_POLLMS);
+	}
+
+	// AMP[0] is the last thing setup writes, everything we need is there with it
+	for (;;) {
+		lump_getnumentries(MOLTSTR_AMP, &entries);
+		if (0 < entries) {
+			break;
+		}
+		sys_sleep(MOLT_TAIL_POLLMS);
+		lump_refresh();
+	}
+
+	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : couldn't read the config from '%s'\n", file);
+		lump_close();
+		return -1;
+	}
+
+	molt_cfg_parampull_xyz(&config, dim, MOLT_PARAM_PINC);
+
+	if (0 <= axis && (index < 0 || dim[axis] <= index)) {
+		fprintf(stderr, "ERR : %c=%d is outside of the volume\n", 'x' + axis, index);
+		lump_close();
+		return -1;
+	}
+
+	nstreams = sim_loadoutputs(&streams);
+	if (nstreams < 0) {
+		lump_close();
+		return -1;
+	}
+
+	elems = dim[0] * (u64)dim[1] * dim[2];
+	vol = calloc(elems, sizeof(f64));
+
+	failed = 0;
+
+	for (next = 0;;) {
+		lump_getnumentries(MOLTSTR_AMP, &entries);
+		if (entries < next) {
+			next = entries;
+		}
+
+		for (; next < entries; next++) {
+			step = next * streams[0].every;
+
+			if (0 <= axis) {
+				snprintf(buf, sizeof buf, "AMP[%ld] step %ld", next, step);
+				rc = dump_slice(MOLTSTR_AMP, next, dim, axis, index, buf);
+			} else {
+				rc = lump_read(MOLTSTR_AMP, next, vol);
+				if (rc == 0) {
+					for (i = 0, lo = hi = vol[0]; i < elems; i++) {
+						lo = vol[i] < lo ? vol[i] : lo;
+						hi = hi < vol[i] ? vol[i] : hi;
+					}
+					printf("AMP[%ld], step %ld : min %e, max %e\n", next, step, lo, hi);
+				}
+			}
+
+			if (rc < 0) {
+				// while the run's going, it could be in the middle of dropping
+				// lumps, so try again later, but once it's done, it's just broken
+				lump_getnumentries(MOLTSTR_TIME, &done);
+				if (!done) {
+					break;
+				}
+
+				fprintf(stderr, "ERR : couldn't read AMP[%ld], skipping it\n", next);
+				failed = 1;
+			}
+
+			fflush(stdout);
+		}
+
+		lump_getnumentries(MOLTSTR_TIME, &done);
+		if (done && next == entries) {
+			break;
+		}
+
+		sys_sleep(MOLT_TAIL_POLLMS);
+
+		// this fails while a new run is starting the file over, so keep trying
+		lump_refresh();
+	}
+
+	free(vol);
+	free(streams);
+	lump_close();
+
+	return failed ? -1 : 0;
 }
 
 /* print_help : prints some help text */
@@ -1111,6 +2910,14 @@ void print_help(char *prog)
 	fprintf(stderr, "--config <file> specifies a custom config file to load experiment parameters from\n");
 	fprintf(stderr, "--custom <file> specifies a custom library to load sweep and reorg functions from\n");
 	fprintf(stderr, "--nosim         runs everything BUT the simulation itself\n");
+	fprintf(stderr, "--restart       reopens outfile, and continues the run from its last timestep\n");
+	fprintf(stderr, "--dump          maps an existing outfile read only and dumps it (nothing is run)\n");
+	fprintf(stderr, "--slice <a>=<n> only dump the plane a=n (a is x, y or z) of each volume\n");
+	fprintf(stderr, "--watch         follows the live frame ring named outfile, of a run that's going\n");
+	fprintf(stderr, "--tail          follows outfile while a run writes it, printing AMP entries as they land\n");
+	fprintf(stderr, "--rebrick <in>  copies the lump file in to outfile, with volumes bricked per the config\n");
+	fprintf(stderr, "--trace <file>  writes a Chrome trace (chrome://tracing, Perfetto) of the run to file\n");
+	fprintf(stderr, "--counters      adds hardware counters (ipc, cache and branch misses) to PROFILE, if we can have them\n");
 	fprintf(stderr, "-h              prints this help text\n");
 	fprintf(stderr, "-v              displays verbose simulation info\n");
 	fprintf(stderr, USAGE, prog);
@@ -1195,6 +3002,64 @@ int parse_config(struct user_cfg_t *usercfg, char *file)
 			usercfg->initamp = strdup(val);
 		} else if (strcmp("initvel", key) == 0) {
 			usercfg->initvel = strdup(val);
+		} else if (strcmp("initamp_lib", key) == 0) {
+			free(usercfg->initamp_lib);
+			usercfg->initamp_lib = strlen(val) ? strdup(val) : NULL;
+		} else if (strcmp("initvel_lib", key) == 0) {
+			free(usercfg->initvel_lib);
+			usercfg->initvel_lib = strlen(val) ? strdup(val) : NULL;
+		} else if (strcmp("init_protocol", key) == 0) {
+			usercfg->init_binary = strcmp(val, "binary") == 0;
+			if (!usercfg->init_binary && strcmp(val, "text") != 0) {
+				fprintf(stderr, "WRN : unknown init_protocol '%s', using text\n", val);
+			}
+		} else if (strcmp("initamp_file", key) == 0) {
+			if (setup_parseinitfile(&usercfg->initamp_file, val, MOLTSTR_AMP) < 0) {
+				fprintf(stderr, "WRN : couldn't parse initamp_file '%s', skipping it\n", val);
+			}
+		} else if (strcmp("initvel_file", key) == 0) {
+			if (setup_parseinitfile(&usercfg->initvel_file, val, MOLTSTR_VEL) < 0) {
+				fprintf(stderr, "WRN : couldn't parse initvel_file '%s', skipping it\n", val);
+			}
+		} else if (strcmp("weightcache", key) == 0) {
+			free(usercfg->weightcache);
+			usercfg->weightcache = strlen(val) ? strdup(val) : NULL;
+		} else if (strcmp("checkpoint_steps", key) == 0) {
+			usercfg->chkpt_steps = atol(val);
+		} else if (strcmp("checkpoint_secs", key) == 0) {
+			usercfg->chkpt_secs = atof(val);
+		} else if (strcmp("checkpoint_keep", key) == 0) {
+			usercfg->chkpt_keep = atol(val);
+		} else if (strcmp("compress", key) == 0) {
+			usercfg->compress = codec_fromstr(val);
+			if (usercfg->compress < 0) {
+				fprintf(stderr, "WRN : unknown compression '%s', AMP lumps will be stored raw\n", val);
+				usercfg->compress = CODEC_NONE;
+			}
+		} else if (strcmp("compress_abserr", key) == 0) {
+			usercfg->compress_abserr = atof(val);
+		} else if (strcmp("compress_relerr", key) == 0) {
+			usercfg->compress_relerr = atof(val);
+		} else if (strcmp("compress_keyframe", key) == 0) {
+			usercfg->compress_keyframe = atol(val);
+		} else if (strcmp("brick_size", key) == 0) {
+			usercfg->brick_size = strcmp(val, "flat") == 0 ? -1 : atol(val);
+		} else if (strcmp("live", key) == 0) {
+			free(usercfg->live);
+			usercfg->live = strlen(val) ? strdup(val) : NULL;
+		} else if (strcmp("live_slots", key) == 0) {
+			usercfg->live_slots = atol(val);
+		} else if (strcmp("shards", key) == 0) {
+			usercfg->shards = atol(val);
+		} else if (strcmp("output_every", key) == 0) {
+			usercfg->output_every = atol(val);
+		} else if (strcmp("output", key) == 0) {
+			c_resize(&usercfg->streams, &usercfg->streams_len, &usercfg->streams_cap, sizeof(*usercfg->streams));
+			if (output_parse(usercfg->streams + usercfg->streams_len, val) < 0) {
+				fprintf(stderr, "WRN : couldn't parse output stream '%s', skipping it\n", val);
+			} else {
+				usercfg->streams_len++;
+			}
 		} else if (strcmp("library", key) == 0 && val && strlen(val) > 0) {
 			// we only include a library if we actually have one (empty for default)
 			if (usercfg->libname) {
@@ -1342,6 +3207,48 @@ s32 hunklog_3(char *file, int line, char *msg, s32 dim[3], f64 *p)
 	return lines;
 }
 
+/* hunklog_3slab : logs a packed sub-box of a volume, with absolute coordinates */
+s32 hunklog_3slab(char *file, int line, char *msg, ivec3_t start, ivec3_t count, f64 *p)
+{
+	/*
+	 * returns the number of lines printed
+	 * NOTE p holds count[0] * count[1] * count[2] ELEMENTS, x fastest
+	 */
+
+	s32 lines;
+	s32 x, y, z, i, tmp;
+	char fmt[BUFLARGE];
+
+	// find which coordinate is biggest
+	for (i = 0, tmp = 0; i < 3; i++) {
+		if (tmp < start[i] + count[i])
+			tmp = start[i] + count[i];
+	}
+
+	snprintf(fmt, sizeof fmt, "%d", tmp);
+	tmp = strlen(fmt);
+	snprintf(fmt, sizeof fmt, "%s %%%dd %%%dd %%%dd %s\n",
+			msg, tmp, tmp, tmp, LOG_FLOATFMT);
+
+	// print a preamble to stdout
+	printf("%s:%d %s\n", file, line, msg);
+
+	lines = 0;
+	for (z = 0; z < count[2]; z++) {
+		for (y = 0; y < count[1]; y++) {
+			for (x = 0; x < count[0]; x++, lines++) {
+				printf(fmt, start[0] + x, start[1] + y, start[2] + z, *p++);
+			}
+		}
+	}
+
+#ifdef LOG_NEWLINESEP
+	printf("\n");
+#endif
+
+	return lines;
+}
+
 /* hunklog_3ord : hunk log in 3d; however, orders vars by ascii vals in ord */
 s32 hunklog_3ord(char *file, int line, char *msg, s32 dim[3], f64 *p, cvec3_t ord)
 {
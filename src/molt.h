@@ -58,6 +58,20 @@ enum {
 #define MOLT_FLAG_FIRSTSTEP 0x01
 #define MOLT_WORKSTORE_AMT  8
 
+/*
+ * NOTE
+ * Profiling hooks. These go around every operator, sweep, reorg, batch of
+ * gfquad_m, and element wise pass, with the phase's name (COP, DOP, SWEEP,
+ * REORG, GFQUAD or ELEM). They do nothing, unless they're defined before this
+ * file is included with MOLT_IMPLEMENTATION.
+ */
+#ifndef MOLT_PROF_BEGIN
+#define MOLT_PROF_BEGIN(phase) ((void)0)
+#endif
+#ifndef MOLT_PROF_END
+#define MOLT_PROF_END(phase) ((void)0)
+#endif
+
 struct molt_cfg_t {
 	// simulation values are kept as integers, and are scaled by the
 	// following values
@@ -111,6 +125,9 @@ struct molt_custom_t {
 	int (*func_close) (struct molt_custom_t *custom);
 	int (*func_sweep) (f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord, pdvec6_t params, dvec3_t dnu, s32 M);
 	int (*func_reorg) (f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_ord, cvec3_t dst_ord);
+
+	// NULL unless we're tracing, takes spans of sys_nanotime nanoseconds, on any thread
+	void (*func_trace) (char *name, u64 start, u64 end);
 };
 
 // molt_cfg dimension intializer functions
@@ -152,6 +169,12 @@ f64 molt_vect_mul(f64 *veca, f64 *vecb, s32 veclen);
 /* molt_get_exp_weights : construct local weights for int up to order M */
 void molt_get_exp_weights(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm);
 
+/* molt_get_exp_worklen : the f64s of working memory molt_get_exp_rows needs */
+s64 molt_get_exp_worklen(s32 orderm);
+
+/* molt_get_exp_rows : construct rows [start, stop) of the local weights, phi from molt_exp_coeff */
+void molt_get_exp_rows(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm, s32 start, s32 stop, f64 *phi, f64 *work);
+
 /* molt_get_exp_ind : get indexes of X for get_exp_weights */
 int molt_get_exp_ind(int i, int n, int m);
 
@@ -214,6 +237,11 @@ static cvec3_t molt_ord_zyx = {'z', 'y', 'x'};
 /* molt_genericidx : retrieves a generic index from input dimensionality */
 static u64 molt_genericidx(ivec3_t ival, ivec3_t idim, cvec3_t order);
 
+/* molt_sweep_custom : calls the custom library's sweep, timed like molt_sweep is */
+static void molt_sweep_custom(struct molt_custom_t *custom, f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord, pdvec6_t params, dvec3_t dnu, s32 M);
+/* molt_reorg_custom : calls the custom library's reorg, timed like molt_reorg is */
+static void molt_reorg_custom(struct molt_custom_t *custom, f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_ord, cvec3_t dst_ord);
+
 /* molt_cfg_dims_t : initializes, very explicitly, cfg's time parameters */
 void molt_cfg_dims_t(struct molt_cfg_t *cfg, s64 start, s64 stop, s64 step, s64 points, s64 pointsinc)
 {
@@ -437,9 +465,11 @@ void molt_step(struct molt_cfg_t *cfg, pdvec3_t vol, pdvec6_t vw, pdvec6_t ww, u
 	molt_c_op(cfg, opstor, vw, ww);
 
 	// u = u + beta ^ 2 * D1
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		next[i] += cfg->beta_sq * work_d1[i];
 	}
+	MOLT_PROF_END(ELEM);
 
 	if (cfg->timeacc >= 2) { // 4th order method
 		opstor[0] = work_d2;
@@ -450,9 +480,11 @@ void molt_step(struct molt_cfg_t *cfg, pdvec3_t vol, pdvec6_t vw, pdvec6_t ww, u
 		molt_c_op(cfg, opstor, vw, ww);
 
 		// u = u - beta ^ 2 * D2 + beta ^ 4 / 12 * D1
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) {
 			next[i] -= cfg->beta_sq * work_d2[i] + cfg->beta_fo * work_d1[i];
 		}
+		MOLT_PROF_END(ELEM);
 	}
 
 	if (cfg->timeacc >= 3) { // 6th order method
@@ -467,19 +499,25 @@ void molt_step(struct molt_cfg_t *cfg, pdvec3_t vol, pdvec6_t vw, pdvec6_t ww, u
 		molt_c_op(cfg, opstor, vw, ww);
 
 		// u = u + (beta ^ 2 * D3 - 2 * beta ^ 4 / 12 * D2 + beta ^ 6 / 360 * D1)
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) {
 			next[i] += cfg->beta_sq * work_d3[i] - cfg->beta_fo * work_d2[i] + cfg->beta_si * work_d1[i];
 		}
+		MOLT_PROF_END(ELEM);
 	}
 
 	if (!(flags & MOLT_FLAG_FIRSTSTEP)) {
 #if 0
 		// next = next / 2;
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) { next[i] /= 2; }
+		MOLT_PROF_END(ELEM);
 	} else {
 #endif
 		// next = next + 2 * curr - prev
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) { next[i] += 2 * curr[i] - prev[i]; }
+		MOLT_PROF_END(ELEM);
 	}
 }
 
@@ -520,6 +558,8 @@ void molt_d_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 
 	pdvec6_t x_sweep_params, y_sweep_params, z_sweep_params;
 
+	MOLT_PROF_BEGIN(DOP);
+
 	dst = vol[0];
 	src = vol[1];
 
@@ -579,9 +619,13 @@ void molt_d_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 	molt_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
 
 	// dst = (work_ix + work_iy + work_iz) / 2
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		dst[i] = (work_ix[i] + work_iy[i] + work_iz[i]) / 3 - src[i];
 	}
+	MOLT_PROF_END(ELEM);
+
+	MOLT_PROF_END(DOP);
 }
 
 /* molt_c_op : MOLT's C Convolution Operator*/
@@ -604,6 +648,8 @@ void molt_c_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 
 	pdvec6_t x_sweep_params, y_sweep_params, z_sweep_params;
 
+	MOLT_PROF_BEGIN(COP);
+
 	dst = vol[0];
 	src = vol[1];
 
@@ -639,7 +685,9 @@ void molt_c_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 
 	// sweep in x, y, z
 	molt_sweep(work_ix,     src, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_ix[i] -= src[i]; }
+	MOLT_PROF_END(ELEM);
 	molt_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
 	molt_sweep(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
 	molt_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
@@ -650,7 +698,9 @@ void molt_c_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 	molt_reorg(work_iy,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
 	molt_reorg(work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
 	molt_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_iy[i] -= work_tmp_[i]; }
+	MOLT_PROF_END(ELEM);
 	molt_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
 	molt_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
 	molt_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
@@ -660,7 +710,9 @@ void molt_c_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 	molt_reorg(work_iz,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
 	molt_reorg(work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
 	molt_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_iz[i] -= work_tmp_[i]; }
+	MOLT_PROF_END(ELEM);
 	molt_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
 	molt_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
 	molt_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_yzx);
@@ -668,9 +720,13 @@ void molt_c_op(struct molt_cfg_t *cfg, pdvec2_t vol, pdvec6_t vw, pdvec6_t ww)
 	molt_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
 
 	// C = Ix + Iy + Iz
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		dst[i] = (work_ix[i] + work_iy[i] + work_iz[i]);
 	}
+	MOLT_PROF_END(ELEM);
+
+	MOLT_PROF_END(COP);
 }
 
 /* molt_sweep : performs a sweep across the mesh in the dimension specified */
@@ -690,6 +746,8 @@ void molt_sweep(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord, pdvec6_
 	 * 'params' is the sweep parameters as setup in the C and D operators.
 	 */
 
+	MOLT_PROF_BEGIN(SWEEP);
+
 	// NOTE (Brian) I noticed this pretty darn late in development, that I wasn't actually treating
 	// the 'dim' and 'ord' parameters the same way as I was in 'molt_reorg'.
 	//
@@ -729,12 +787,17 @@ void molt_sweep(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord, pdvec6_
 
 	memset(work, 0, sizeof(f64) * rowlen * rownum);
 
+	MOLT_PROF_BEGIN(GFQUAD);
+
 	// walk through the volume, grabbing each row-organized value
 	for (i = 0, ptr = src; i < rownum; i++, ptr += rowlen, work += rowlen) {
 		molt_gfquad_m(work, ptr, usednu, wl, wr, rowlen, M);
 		molt_makel(work, vl, vr, minval, rowlen);
 		memcpy(ptr, work, sizeof(f64) * rowlen);
 	}
+
+	MOLT_PROF_END(GFQUAD);
+	MOLT_PROF_END(SWEEP);
 }
 
 /* molt_gfquad_m : green's function quadriture on the input vector */
@@ -850,6 +913,8 @@ void molt_reorg(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_ord, cve
 	// NOTE (brian): at least one of the output arrays needs to be different
 	assert(dst != work || work != src);
 
+	MOLT_PROF_BEGIN(REORG);
+
 	total = ((u64)dim[0]) * (u64)dim[1] * (u64)dim[2];
 
 	memset(work, 0, sizeof(*work) * total);
@@ -865,6 +930,8 @@ void molt_reorg(f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_ord, cve
 	}
 
 	memcpy(dst, work, sizeof(*dst) * total);
+
+	MOLT_PROF_END(REORG);
 }
 
 /* molt_genericidx : retrieves a generic index from input dimensionality */
@@ -923,6 +990,22 @@ f64 molt_vect_mul(f64 *veca, f64 *vecb, s32 veclen)
 
 // CUSTOM INTERFACE BEGINS
 
+/* molt_sweep_custom : calls the custom library's sweep, timed like molt_sweep is */
+static void molt_sweep_custom(struct molt_custom_t *custom, f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t ord, pdvec6_t params, dvec3_t dnu, s32 M)
+{
+	MOLT_PROF_BEGIN(SWEEP);
+	custom->func_sweep(dst, src, work, dim, ord, params, dnu, M);
+	MOLT_PROF_END(SWEEP);
+}
+
+/* molt_reorg_custom : calls the custom library's reorg, timed like molt_reorg is */
+static void molt_reorg_custom(struct molt_custom_t *custom, f64 *dst, f64 *src, f64 *work, ivec3_t dim, cvec3_t src_ord, cvec3_t dst_ord)
+{
+	MOLT_PROF_BEGIN(REORG);
+	custom->func_reorg(dst, src, work, dim, src_ord, dst_ord);
+	MOLT_PROF_END(REORG);
+}
+
 /* moltcustom_step : the custom library molt stepper */
 void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 {
@@ -951,9 +1034,11 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 	if (flags & MOLT_FLAG_FIRSTSTEP) {
 		// u1 = 2 * (u0 + d1 * v0)
 		tmp = cfg->time_scale * cfg->t_params[MOLT_PARAM_STEP];
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) {
 			next[i] = 2 * (curr[i] + tmp * prev[i]);
 		}
+		MOLT_PROF_END(ELEM);
 	}
 
 	// now we can begin doing work
@@ -962,9 +1047,11 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 	molt_c_op_custom(custom);
 
 	// u = u + beta ^ 2 * D1
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		next[i] = next[i] * cfg->beta_sq * work_d1[i];
 	}
+	MOLT_PROF_END(ELEM);
 
 	if (flags & MOLT_FLAG_FIRSTSTEP) {
 		if (cfg->timeacc >= 2) {
@@ -976,9 +1063,11 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 			molt_d_op_custom(custom);
 
 			// u = u - beta ^ 2 * D2 + beta ^ 4 / 12 * D1
+			MOLT_PROF_BEGIN(ELEM);
 			for (i = 0; i < totalelem; i++) {
 				next[i] -= cfg->beta_sq * work_d2[i] + cfg->beta_fo * work_d1[i];
 			}
+			MOLT_PROF_END(ELEM);
 		}
 
 		if (cfg->timeacc >= 3) {
@@ -993,10 +1082,12 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 			molt_c_op_custom(custom);
 
 			// u = u + (beta ^ 2 * D3 - 2 * beta ^ 4 / 12 * D2 + beta ^ 6 / 360 * D1)
+			MOLT_PROF_BEGIN(ELEM);
 			for (i = 0; i < totalelem; i++) {
 				tmp = cfg->beta_sq * work_d3[i] - cfg->beta_fo * work_d2[i] + cfg->beta_si * work_d1[i];
 				next[i] += tmp;
 			}
+			MOLT_PROF_END(ELEM);
 		}
 	} else {
 		if (cfg->timeacc >= 2) {
@@ -1008,9 +1099,11 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 			molt_c_op_custom(custom);
 
 			// u = u - beta ^ 2 * D2 + beta ^ 4 / 12 * D1
+			MOLT_PROF_BEGIN(ELEM);
 			for (i = 0; i < totalelem; i++) {
 				next[i] -= cfg->beta_sq * work_d2[i] + cfg->beta_fo * work_d1[i];
 			}
+			MOLT_PROF_END(ELEM);
 		}
 
 		if (cfg->timeacc >= 3) {
@@ -1025,19 +1118,25 @@ void molt_step_custom(struct molt_custom_t *custom, u32 flags)
 			molt_c_op_custom(custom);
 
 			// u = u + (beta ^ 2 * D3 - 2 * beta ^ 4 / 12 * D2 + beta ^ 6 / 360 * D1)
+			MOLT_PROF_BEGIN(ELEM);
 			for (i = 0; i < totalelem; i++) {
 				tmp = cfg->beta_sq * work_d3[i] - cfg->beta_fo * work_d2[i] + cfg->beta_si * work_d1[i];
 				next[i] += tmp;
 			}
+			MOLT_PROF_END(ELEM);
 		}
 	}
 
 	if (flags & MOLT_FLAG_FIRSTSTEP) {
 		// next = next / 2;
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) { next[i] /= 2; }
+		MOLT_PROF_END(ELEM);
 	} else {
 		// next = next + 2 * curr - prev
+		MOLT_PROF_BEGIN(ELEM);
 		for (i = 0; i < totalelem; i++) { next[i] += 2 * curr[i] - prev[i]; }
+		MOLT_PROF_END(ELEM);
 	}
 }
 
@@ -1060,6 +1159,8 @@ void molt_c_op_custom(struct molt_custom_t *custom)
 
 	pdvec6_t x_sweep_params, y_sweep_params, z_sweep_params;
 
+	MOLT_PROF_BEGIN(COP);
+
 	cfg = custom->cfg;
 
 	dst = custom->dst;
@@ -1095,39 +1196,49 @@ void molt_c_op_custom(struct molt_custom_t *custom)
 	// TODO (brian) mesh_dim has to be dimensionality aware
 
 	// sweep in x, y, z
-	custom->func_sweep(work_ix,     src, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_sweep_custom(custom, work_ix,     src, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_ix[i] -= src[i]; }
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
-	custom->func_sweep(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
-	custom->func_sweep(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xyz);
+	MOLT_PROF_END(ELEM);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
+	molt_sweep_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xyz);
 
 	// sweep in y, z, x
-	custom->func_reorg(work_iy,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
-	custom->func_reorg(work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
+	molt_reorg_custom(custom, work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_iy[i] -= work_tmp_[i]; }
-	custom->func_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xyz, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_END(ELEM);
+	molt_reorg_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xyz, x_sweep_params, cfg->dnu, cfg->spaceacc);
 
 	// sweep in z, x, y
-	custom->func_reorg(work_iz,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
-	custom->func_reorg(work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iz,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
+	molt_reorg_custom(custom, work_tmp_,   src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) { work_iz[i] -= work_tmp_[i]; }
-	custom->func_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_yzx);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, y_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
+	MOLT_PROF_END(ELEM);
+	molt_reorg_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_yzx);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
 
 	// dst = (work_ix + work_iy + work_iz) / 2
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		dst[i] = (work_ix[i] + work_iy[i] + work_iz[i]) / 3 - src[i];
 	}
+	MOLT_PROF_END(ELEM);
+
+	MOLT_PROF_END(COP);
 }
 
 /* molt_d_op_custom : MOLT's D Convolution Operator*/
@@ -1141,6 +1252,8 @@ void molt_d_op_custom(struct molt_custom_t *custom)
 
 	pdvec6_t x_sweep_params, y_sweep_params, z_sweep_params;
 
+	MOLT_PROF_BEGIN(DOP);
+
 	cfg = custom->cfg;
 
 	dst = custom->dst;
@@ -1176,75 +1289,128 @@ void molt_d_op_custom(struct molt_custom_t *custom)
 	//           : we have a mesh_dim{x,y,z} <-- thinking this one
 
 	// sweep in x, y, z
-	custom->func_sweep(work_ix,     src, work_tmp, mesh_dim, molt_ord_xyz, x_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
-	custom->func_sweep(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
-	custom->func_sweep(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xyz);
+	molt_sweep_custom(custom, work_ix,     src, work_tmp, mesh_dim, molt_ord_xyz, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
+	molt_sweep_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_ix, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xyz);
 
 	// sweep in y, z, x
-	custom->func_reorg(work_iy,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iy, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iy, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
-	custom->func_sweep(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_xyz);
+	molt_reorg_custom(custom, work_iy,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_yxz);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yxz, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy, work_ix, work_tmp, mesh_dim, molt_ord_yxz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy, work_ix, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
+	molt_sweep_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_xyz);
 
 	// sweep in z, x, y
-	custom->func_reorg(work_iz,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_yzx);
-	custom->func_sweep(work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, y_sweep_params, cfg->dnu, cfg->spaceacc);
-	custom->func_reorg(work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
+	molt_reorg_custom(custom, work_iz,     src, work_tmp, mesh_dim, molt_ord_xyz, molt_ord_zxy);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, z_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_zxy, molt_ord_xzy);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, x_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_xzy, molt_ord_yzx);
+	molt_sweep_custom(custom, work_iz, work_iz, work_tmp, mesh_dim, molt_ord_yzx, y_sweep_params, cfg->dnu, cfg->spaceacc);
+	molt_reorg_custom(custom, work_iy, work_iy, work_tmp, mesh_dim, molt_ord_yzx, molt_ord_xyz);
 
 	// dst = (work_ix + work_iy + work_iz) / 2
+	MOLT_PROF_BEGIN(ELEM);
 	for (i = 0; i < totalelem; i++) {
 		dst[i] = (work_ix[i] + work_iy[i] + work_iz[i]) / 3 - src[i];
 	}
+	MOLT_PROF_END(ELEM);
+
+	MOLT_PROF_END(DOP);
 }
 
 /* molt_get_exp_weights : construct local weights for int up to order M */
 void molt_get_exp_weights(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm)
 {
-	int i, j, k;
-	int rowlen, reallen;
-	double *x, *phi, *workvect_r, *workvect_l;
-	double *workmat_r, *workmat_l;
+	f64 *phi, *work;
 
-	rowlen = orderm + 1;
-	reallen = nulen + 1;
-
-	/* retrieve temporary working space from the operating system */
-	x          = (f64 *)calloc(sizeof(double), reallen);
-	phi        = (f64 *)calloc(sizeof(double), rowlen);
-	workvect_r = (f64 *)calloc(sizeof(double), rowlen);
-	workvect_l = (f64 *)calloc(sizeof(double), rowlen);
-	workmat_r  = (f64 *)calloc(sizeof(double), rowlen * rowlen);
-	workmat_l  = (f64 *)calloc(sizeof(double), rowlen * rowlen);
+	/* retrieve temporary working space from the operating system, once */
+	phi  = (f64 *)calloc(sizeof(f64), orderm + 1);
+	work = (f64 *)calloc(sizeof(f64), molt_get_exp_worklen(orderm));
 
-	if (!x || !phi || !workvect_r || !workvect_l || !workmat_r || !workmat_l) {
+	if (!phi || !work) {
 		fprintf(stderr, "Couldn't Get Enough Memory!\n");
 		exit(1);
 	}
 
-	// fetch the cumulative sum of nu
-	molt_cumsum(x, reallen, nu);
+	/* the coefficients only depend on nu, so every row shares them */
+	molt_exp_coeff(phi, orderm + 1, nu);
+
+	molt_get_exp_rows(nu, wl, wr, nulen, orderm, 0, nulen, phi, work);
+
+	free(phi);
+	free(work);
+}
+
+/* molt_get_exp_worklen : the f64s of working memory molt_get_exp_rows needs */
+s64 molt_get_exp_worklen(s32 orderm)
+{
+	s64 rowlen;
+
+	rowlen = orderm + 1;
+
+	// the x window, two Z vectors, and two matricies
+	return 3 * rowlen + 2 * rowlen * rowlen;
+}
+
+/* molt_get_exp_rows : construct rows [start, stop) of the local weights, phi from molt_exp_coeff */
+void molt_get_exp_rows(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm, s32 start, s32 stop, f64 *phi, f64 *work)
+{
+	int i, j, k;
+	int rowlen;
+	s64 base;
+	double xbase;
+	double *x, *workvect_r, *workvect_l;
+	double *workmat_r, *workmat_l;
+
+	/*
+	 * NOTE
+	 * Rows don't depend on each other, so any split of them (over threads,
+	 * say) gives back exactly what one call over all of them would. The only
+	 * thing they share is x, the cumulative sum of nu, and a row only ever
+	 * looks at x[j] through x[j + M] (i and i + 1 are always in there too).
+	 * So instead of the whole sum, we carry x[j] along as j moves, adding nu
+	 * one at a time, the same way the sum does, and every x comes out to the
+	 * very same bits.
+	 *
+	 * The interior rows look like they all have the same stencil, but they
+	 * don't, quite; x[i + 1] - x[j + k] carries whatever rounding the sum had
+	 * at i, so each row still gets its own inverses.
+	 */
+
+	rowlen = orderm + 1;
 
-	for (i = 0; i < nulen; i++) {
-		/* get the current coefficients */
-		molt_exp_coeff(phi, rowlen, nu);
+	x          = work;
+	workvect_l = x + rowlen;
+	workvect_r = workvect_l + rowlen;
+	workmat_l  = workvect_r + rowlen;
+	workmat_r  = workmat_l + rowlen * rowlen;
 
+	base = 0;
+	xbase = 0.0;
+
+	for (i = start; i < stop; i++) {
 		/* determine what indicies we need to operate over */
 		j = molt_get_exp_ind(i, nulen, orderm);
 
+		for (; base < j; base++) {
+			xbase = xbase + nu;
+		}
+
+		/* x[j] through x[j + M] */
+		for (k = 0, x[0] = xbase; k < rowlen - 1; k++) {
+			x[k + 1] = x[k] + nu;
+		}
+
 		/* fill our our Z vectors */
 		for (k = 0; k < rowlen; k++) {
-			workvect_l[k] = (x[i + 1] - x[j + k]) / nu;
-			workvect_r[k] = (x[j + k] - x[i    ]) / nu;
+			workvect_l[k] = (x[i + 1 - j] - x[k]) / nu;
+			workvect_r[k] = (x[k] - x[i - j]) / nu;
 		}
 
 		molt_invvan(workmat_l, workvect_l, rowlen);
@@ -1254,16 +1420,9 @@ void molt_get_exp_weights(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm)
 		molt_matflip(workmat_r, rowlen);
 
 		/* multiply our phi vector with our working matrix, giving the answer */
-		molt_mat_mv_mult(wl + (i * rowlen), workmat_l, phi, rowlen);
-		molt_mat_mv_mult(wr + (i * rowlen), workmat_r, phi, rowlen);
+		molt_mat_mv_mult(wl + ((s64)i * rowlen), workmat_l, phi, rowlen);
+		molt_mat_mv_mult(wr + ((s64)i * rowlen), workmat_r, phi, rowlen);
 	}
-
-	free(x);
-	free(phi);
-	free(workvect_r);
-	free(workvect_l);
-	free(workmat_r);
-	free(workmat_l);
 }
 
 /* molt_cumsum : perform a cumulative sum over elem along dimension dim */
@@ -13,17 +13,150 @@
 #define MOLT_IMPLEMENTATION
 #include "molt.h"
 
+#include "config.h"
+#include "chkpt.h"
+#include "codec.h"
+#include "brick.h"
+#include "init.h"
+#include "output.h"
+#include "restart.h"
+#include "sys.h"
+#include "wcache.h"
+#include "live.h"
+#include "lump.h"
+
 #define REORG_TESTS (100)
 
 /* test_molt_reorg : tests molt reorg */
 int test_molt_reorg(void);
 
+/* test_codec : tests that every codec gives back what it was given */
+int test_codec(void);
+
+/* test_brick : tests bricking volumes, and reading them back */
+int test_brick(void);
+
+/* test_output : tests parsing output streams, and cutting them out of volumes */
+int test_output(void);
+
+/* test_output_advance : tests the time levels rolling over, with the reductions done along the way */
+int test_output_advance(void);
+
+/* test_init : tests parsing the analytic initializers, and filling volumes with them */
+int test_init(void);
+
+/* test_initbinary : tests the binary init protocol's header, and reading answers to it back */
+int test_initbinary(void);
+
+/* test_initanswer : makes an init program's answer, a header line and n values, ready to be read */
+FILE *test_initanswer(char *header, f64 *vol, u64 n);
+
+/* test_initresample : tests copying and resampling volumes in files onto other grids */
+int test_initresample(void);
+
+/* test_initmultilinear : 1 + 2u + 3v + 5w + 7uvw, at point p of a dim grid over the unit cube */
+f64 test_initmultilinear(ivec3_t p, ivec3_t dim);
+
+/* test_molt_weights : tests the weights against the original cumulative sum ones, and a few rows at a time against all at once */
+int test_molt_weights(void);
+
+/* test_exp_weightsref : makes the weights the way molt_get_exp_weights first did, from a cumulative sum of nu */
+void test_exp_weightsref(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm);
+
+/* test_lump : tests writing a lump file, and reading it back, mapped and followed */
+int test_lump(void);
+
+/* test_lumpslabs : reads a few sub-boxes of the volume back with lump_read_slab, returns how many came back wrong */
+int test_lumpslabs(char *tag, f64 *vol, ivec3_t dim);
+
+/* test_lumpfollow : tests a reader following a lump file while it's appended to, truncated and started over */
+int test_lumpfollow(void);
+
+/* test_lumpcheck : checks the open lump file has n ETC lumps, each its index, plus base past truncated, 0 if not */
+int test_lumpcheck(char *when, u64 n, u64 truncated, u64 base);
+
+/* test_restart : tests checking a lump file before restarting it, and picking up from its last AMP entries */
+int test_restart(void);
+
+/* test_restartcfg : fills out a small config, n points on a side, for the restart and checkpoint tests */
+void test_restartcfg(struct molt_cfg_t *cfg, s64 n);
+
+/* test_restartvols : checks prev is all a and curr is all b, 0 if not */
+int test_restartvols(char *when, f64 *prev, f64 *curr, u64 elems, f64 a, f64 b);
+
+/* test_chkpt : tests the checkpoint ring, and restoring the newest whole checkpoint in it */
+int test_chkpt(void);
+
+/* test_chkptcheck : restores a checkpoint, and checks it's the k'th one written, 0 if not */
+int test_chkptcheck(char *when, struct molt_cfg_t *config, f64 **state, u64 elems, u64 k);
+
+/* test_wcache : tests the weight cache's hits, misses, and turning away files that were tampered with */
+int test_wcache(void);
+
+/* test_live : tests the live frame ring, with a reader racing the writer, and headers that don't add up */
+int test_live(void);
+
+/* test_livewriter : publishes frames that are all their own step number, then closes the ring */
+void *test_livewriter(void *arg);
+
 int main(int argc, char **argv)
 {
 	if (!test_molt_reorg()) {
 		printf("test_molt_reorg() failed!\n");
 	}
 
+	if (!test_codec()) {
+		printf("test_codec() failed!\n");
+	}
+
+	if (!test_brick()) {
+		printf("test_brick() failed!\n");
+	}
+
+	if (!test_output()) {
+		printf("test_output() failed!\n");
+	}
+
+	if (!test_init()) {
+		printf("test_init() failed!\n");
+	}
+
+	if (!test_initbinary()) {
+		printf("test_initbinary() failed!\n");
+	}
+
+	if (!test_initresample()) {
+		printf("test_initresample() failed!\n");
+	}
+
+	if (!test_molt_weights()) {
+		printf("test_molt_weights() failed!\n");
+	}
+
+	if (!test_lump()) {
+		printf("test_lump() failed!\n");
+	}
+
+	if (!test_lumpfollow()) {
+		printf("test_lumpfollow() failed!\n");
+	}
+
+	if (!test_restart()) {
+		printf("test_restart() failed!\n");
+	}
+
+	if (!test_chkpt()) {
+		printf("test_chkpt() failed!\n");
+	}
+
+	if (!test_wcache()) {
+		printf("test_wcache() failed!\n");
+	}
+
+	if (!test_live()) {
+		printf("test_live() failed!\n");
+	}
+
 	return 0;
 }
 
@@ -91,3 +224,1692 @@ int test_molt_reorg(void)
 	return rc == i - 1;
 }
 
+/* test_codec : tests that every codec gives back what it was given */
+int test_codec(void)
+{
+	size_t sizes[] = { 0, 1, 7, 8, 1000 * sizeof(f64), 160 * 160 * 160 * sizeof(f64) + 3 };
+	struct codecparams_t params;
+	size_t i, j, n, len;
+	f64 *raw, *out, *prev, *ref;
+	u8 *enc;
+	int codec, frame, bad, rc;
+
+	rc = 1;
+
+	params.tolerance = 1e-3;
+	params.relative = 0;
+
+	for (codec = CODEC_NONE + 1; codec < CODEC_TOTAL; codec++) {
+		for (i = 0; i < ARRSIZE(sizes); i++) {
+			printf("%s - %s %ld\n", __FUNCTION__, codec_tostr(codec), sizes[i]);
+
+			n = sizes[i] / sizeof(f64) + 1;
+
+			raw = calloc(n, sizeof(f64));
+			out = calloc(n, sizeof(f64));
+			prev = calloc(n, sizeof(f64));
+			ref = calloc(n, sizeof(f64));
+			enc = calloc(1, codec_bound(codec, sizes[i]));
+
+			// a few frames of a moving wave, the first on its own, then each
+			// one as a delta from the one before
+			for (frame = 0, bad = 0; !bad && frame < 3; frame++) {
+				// a smooth wave in the back half, and nothing in the front
+				for (j = n / 2; j < n; j++) {
+					raw[j] = sin(j * 0.001 + frame * 0.01) * 1e4;
+				}
+
+				len = codec_encode(codec, &params, enc, codec_bound(codec, sizes[i]), raw, sizes[i], ref, frame != 0);
+
+				bad = len == 0 || codec_decode(out, sizes[i], enc, len, frame != 0 ? prev : NULL) < 0;
+
+				// the lossy codec only has to land within the error bound
+				for (j = 0; !bad && j < sizes[i] / sizeof(f64); j++) {
+					if (codec == CODEC_LOSSY) {
+						bad = params.tolerance < fabs(raw[j] - out[j]);
+					} else {
+						bad = raw[j] != out[j];
+					}
+				}
+
+				bad = bad || memcmp((u8 *)raw + j * sizeof(f64), (u8 *)out + j * sizeof(f64), sizes[i] % sizeof(f64));
+
+				// and the encoder's reference has to be exactly what decoded
+				bad = bad || memcmp(ref, out, sizes[i]);
+
+				memcpy(prev, out, sizes[i]);
+			}
+
+			if (bad) {
+				printf("%s failed on %s, %ld bytes, frame %d\n", __FUNCTION__, codec_tostr(codec), sizes[i], frame - 1);
+				rc = 0;
+			}
+
+			free(raw);
+			free(out);
+			free(prev);
+			free(ref);
+			free(enc);
+		}
+	}
+
+	return rc;
+}
+
+/* test_brick : tests bricking volumes, and reading them back */
+int test_brick(void)
+{
+	ivec3_t dims[] = { { 1, 1, 1 }, { 8, 8, 8 }, { 37, 23, 19 }, { 64, 3, 40 } };
+	s32 bricks[] = { 1, 4, 8, 32 };
+	struct codecparams_t params;
+	size_t i, j, k, n, len, bound;
+	f64 *raw, *out, maxerr;
+	u8 *enc;
+	int codec, used, bad, rc;
+
+	rc = 1;
+
+	params.tolerance = 1e-3;
+	params.relative = 0;
+	params.keyframe = 0;
+
+	for (codec = CODEC_NONE; codec < CODEC_TOTAL; codec++) {
+		for (i = 0; i < ARRSIZE(dims); i++) {
+			for (j = 0; j < ARRSIZE(bricks); j++) {
+				printf("%s - %s %dx%dx%d by %d\n", __FUNCTION__, codec_tostr(codec), dims[i][0], dims[i][1], dims[i][2], bricks[j]);
+
+				n = dims[i][0] * (u64)dims[i][1] * dims[i][2];
+
+				raw = calloc(n, sizeof(f64));
+				out = calloc(n, sizeof(f64));
+
+				for (k = 0; k < n; k++) {
+					raw[k] = sin(k * 0.01) * 1e2;
+				}
+
+				bound = brick_bound(codec, dims[i], bricks[j]);
+				enc = calloc(1, bound);
+
+				len = brick_encode(codec, &params, enc, bound, raw, dims[i], bricks[j], &used, &maxerr);
+
+				bad = len == 0 || brick_decode(out, n * sizeof(f64), enc, len) < 0;
+
+				for (k = 0; !bad && k < n; k++) {
+					if (codec == CODEC_LOSSY) {
+						bad = params.tolerance < fabs(raw[k] - out[k]);
+					} else {
+						bad = raw[k] != out[k];
+					}
+				}
+
+				if (bad) {
+					printf("%s failed on %s, %dx%dx%d by %d\n", __FUNCTION__, codec_tostr(codec), dims[i][0], dims[i][1], dims[i][2], bricks[j]);
+					rc = 0;
+				}
+
+				free(raw);
+				free(out);
+				free(enc);
+			}
+		}
+	}
+
+	return rc;
+}
+
+/* test_output : tests parsing output streams, and cutting them out of volumes */
+int test_output(void)
+{
+	char *good[] = {
+		"SNAP full every=50", "PREVIEW down 4", "ZMID plane z=9 every=2", "YLO plane y=0",
+		"ROI box 3,2,1 10,5,7", "ROI2 box 0,0,0 37,23,19 every=3", "ODD down 5",
+		"STATS stats every=4", "PROBE probe 36,22,18"
+	};
+	char *bad[] = {
+		"", "NOKIND", "TOOLONGTAG full", "X what", "X down", "X down 0", "X plane w=3", "X plane z=19",
+		"X box 1,2,3", "X box 30,0,0 8,1,1", "X box 0,0,0 0,1,1", "X full every=-1", "X full every=x", "X down 2 3",
+		"X stats 3", "X probe 1,2", "X probe 37,0,0"
+	};
+	ivec3_t dim = { 37, 23, 19 };
+	ivec3_t out, p, b;
+	struct outstream_t stream;
+	f64 *vol, *got, want;
+	u64 i, n, elems, cnt;
+	int f, wrong, rc;
+
+	rc = 1;
+
+	for (i = 0; i < ARRSIZE(bad); i++) {
+		if (output_parse(&stream, bad[i]) == 0 && output_check(&stream, dim) == 0) {
+			printf("%s took '%s'\n", __FUNCTION__, bad[i]);
+			rc = 0;
+		}
+	}
+
+	elems = dim[0] * (u64)dim[1] * dim[2];
+
+	vol = calloc(elems, sizeof(f64));
+	got = calloc(elems, sizeof(f64));
+
+	for (i = 0; i < elems; i++) {
+		vol[i] = sin(i * 0.01) * 1e2;
+	}
+
+	for (i = 0; i < ARRSIZE(good); i++) {
+		printf("%s - %s\n", __FUNCTION__, good[i]);
+
+		if (output_parse(&stream, good[i]) < 0 || output_check(&stream, dim) < 0) {
+			printf("%s couldn't take '%s'\n", __FUNCTION__, good[i]);
+			rc = 0;
+			continue;
+		}
+
+		if (output_rowsize(&stream)) {
+			continue; // rows, not volumes, they're checked below
+		}
+
+		n = output_dim(&stream, dim, out);
+
+		output_extract(&stream, got, vol, dim);
+
+		// check every point against the slowest way we can work it out
+		for (wrong = 0, p[2] = 0; !wrong && p[2] < out[2]; p[2]++) {
+			for (p[1] = 0; !wrong && p[1] < out[1]; p[1]++) {
+				for (p[0] = 0; !wrong && p[0] < out[0]; p[0]++) {
+					if (stream.kind == OUTPUT_DOWN) {
+						f = stream.factor;
+						want = 0;
+						cnt = 0;
+						for (b[2] = p[2] * f; b[2] < (p[2] + 1) * f && b[2] < dim[2]; b[2]++) {
+							for (b[1] = p[1] * f; b[1] < (p[1] + 1) * f && b[1] < dim[1]; b[1]++) {
+								for (b[0] = p[0] * f; b[0] < (p[0] + 1) * f && b[0] < dim[0]; b[0]++) {
+									want += vol[(b[2] * (u64)dim[1] + b[1]) * dim[0] + b[0]];
+									cnt++;
+								}
+							}
+						}
+						want /= cnt;
+					} else {
+						VectorAdd(p, stream.start, b);
+						want = vol[(b[2] * (u64)dim[1] + b[1]) * dim[0] + b[0]];
+					}
+
+					wrong = 1e-9 < fabs(want - got[(p[2] * (u64)out[1] + p[1]) * out[0] + p[0]]);
+				}
+			}
+		}
+
+		if (wrong || n != out[0] * (u64)out[1] * out[2]) {
+			printf("%s failed on '%s'\n", __FUNCTION__, good[i]);
+			rc = 0;
+		}
+	}
+
+	if (!test_output_advance()) {
+		rc = 0;
+	}
+
+	free(vol);
+	free(got);
+
+	return rc;
+}
+
+/* test_output_advance : tests the time levels rolling over, with the reductions done along the way */
+int test_output_advance(void)
+{
+	ivec3_t dim = { 7, 5, 4 };
+	dvec3_t h = { 0.5, 0.25, 2.0 };
+	struct outstat_t stat;
+	f64 *vol[3], *keep[2], sum, kinetic, potential, maxabs, d, dt, c;
+	u64 i, elems;
+	s32 x, y, z;
+	int rc;
+
+	rc = 1;
+
+	dt = 0.125;
+	c = 3.0;
+
+	elems = dim[0] * (u64)dim[1] * dim[2];
+
+	for (i = 0; i < 3; i++) {
+		vol[i] = calloc(elems, sizeof(f64));
+	}
+
+	keep[0] = calloc(elems, sizeof(f64));
+	keep[1] = calloc(elems, sizeof(f64));
+
+	for (i = 0; i < elems; i++) {
+		vol[1][i] = keep[0][i] = sin(i * 0.3);
+		vol[2][i] = keep[1][i] = cos(i * 0.7) * (i == 77 ? 9.0 : 1.0);
+	}
+
+	output_advance(&stat, vol[0], vol[1], vol[2], dim, h, dt, c);
+
+	sum = kinetic = potential = maxabs = 0;
+
+	for (z = 0, i = 0; z < dim[2]; z++) {
+		for (y = 0; y < dim[1]; y++) {
+			for (x = 0; x < dim[0]; x++, i++) {
+				sum += keep[1][i] * keep[1][i];
+				kinetic += pow((keep[1][i] - keep[0][i]) / dt, 2);
+
+				if (x + 1 < dim[0]) {
+					d = (keep[1][i + 1] - keep[1][i]) / h[0];
+					potential += d * d;
+				}
+				if (y + 1 < dim[1]) {
+					d = (keep[1][i + dim[0]] - keep[1][i]) / h[1];
+					potential += d * d;
+				}
+				if (z + 1 < dim[2]) {
+					d = (keep[1][i + dim[0] * dim[1]] - keep[1][i]) / h[2];
+					potential += d * d;
+				}
+
+				if (maxabs < fabs(keep[1][i])) {
+					maxabs = fabs(keep[1][i]);
+				}
+			}
+		}
+	}
+
+	if (1e-12 < fabs(stat.l2 - sqrt(sum * h[0] * h[1] * h[2])) / stat.l2) {
+		printf("%s l2 is off\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	if (1e-12 < fabs(stat.energy - 0.5 * (kinetic + c * c * potential) * h[0] * h[1] * h[2]) / stat.energy) {
+		printf("%s energy is off\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	if (stat.maxabs != maxabs || stat.maxat[0] != 77 % dim[0] || stat.maxat[1] != 77 / dim[0] % dim[1] || stat.maxat[2] != 77 / dim[0] / dim[1]) {
+		printf("%s max |u| is off\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	for (i = 0; i < elems; i++) {
+		if (vol[0][i] != keep[0][i] || vol[1][i] != keep[1][i] || vol[2][i] != 0) {
+			printf("%s didn't roll the time levels over\n", __FUNCTION__);
+			rc = 0;
+			break;
+		}
+	}
+
+	for (i = 0; i < 3; i++) {
+		free(vol[i]);
+	}
+
+	free(keep[0]);
+	free(keep[1]);
+
+	return rc;
+}
+
+/* test_init : tests parsing the analytic initializers, and filling volumes with them */
+int test_init(void)
+{
+	char *commands[] = {
+		NULL, "", "experiments/test --amp", "gaussians", "./point"
+	};
+	char *bad[] = {
+		"gaussian width=0", "gaussian width=x", "gaussian center=1,2", "gaussian travel=w", "gaussian travel=+",
+		"gaussian wavelength=2", "gaussian amp", "planewave wavelength=-1", "planewave axis=q", "planewave center=0,0,0",
+		"point travel=x", "point width=3"
+	};
+	char *words[] = {
+		"gaussian", "planewave", "amp=2", "axis=z", "width=0.1", NULL, NULL
+	};
+	char line[2][BUFSMALL];
+	char *tok[7], *save[2];
+	ivec3_t dim = { 23, 17, 11 };
+	struct initfunc_t init;
+	f64 *vol, want, s[3], r, scale, c, k;
+	s32 x, y, z;
+	u64 i, elems, nonzero;
+	int j, rc, wrong;
+
+	rc = 1;
+
+	for (i = 0; i < ARRSIZE(commands); i++) {
+		if (init_parse(&init, commands[i]) != 0) {
+			printf("%s took command '%s'\n", __FUNCTION__, commands[i] ? commands[i] : "(null)");
+			rc = 0;
+		}
+	}
+
+	for (i = 0; i < ARRSIZE(bad); i++) {
+		if (init_parse(&init, bad[i]) != -1) {
+			printf("%s took '%s'\n", __FUNCTION__, bad[i]);
+			rc = 0;
+		}
+	}
+
+	// the setup threads parse initvel and initamp at the same time, so one
+	// tokenizer can't lose its place when another one starts up
+	strcpy(line[0], "  gaussian amp=2\twidth=0.1 ");
+	strcpy(line[1], "planewave axis=z");
+
+	tok[0] = strtoks(line[0], " \t", &save[0]);
+	tok[1] = strtoks(line[1], " \t", &save[1]);
+	tok[2] = strtoks(NULL, " \t", &save[0]);
+	tok[3] = strtoks(NULL, " \t", &save[1]);
+	tok[4] = strtoks(NULL, " \t", &save[0]);
+	tok[5] = strtoks(NULL, " \t", &save[1]);
+	tok[6] = strtoks(NULL, " \t", &save[0]);
+
+	for (i = 0; i < ARRSIZE(tok); i++) {
+		if (tok[i] != words[i] && (tok[i] == NULL || words[i] == NULL || strcmp(tok[i], words[i]) != 0)) {
+			printf("%s token %ld is '%s', not '%s'\n", __FUNCTION__, i, strornull(tok[i]), strornull(words[i]));
+			rc = 0;
+		}
+	}
+
+	elems = dim[0] * (u64)dim[1] * dim[2];
+
+	vol = calloc(elems, sizeof(f64));
+
+	scale = 1e-4;
+	c = 3.0;
+
+	// the defaults are experiments/test's funcf, and traveling +x, its funcg
+	for (j = 0; j < 2; j++) {
+		init_parse(&init, j == 0 ? "gaussian" : "gaussian travel=+x");
+		init_fill(&init, vol, dim, scale, c);
+
+		for (z = 0, i = 0, wrong = 0; z < dim[2]; z++) {
+			for (y = 0; y < dim[1]; y++) {
+				for (x = 0; x < dim[0]; x++, i++) {
+					Vec3Set(s, (f64)x / dim[0], (f64)y / dim[1], (f64)z / dim[2]);
+					r = pow(2 * s[0] - 1, 2) + pow(2 * s[1] - 1, 2) + pow(2 * s[2] - 1, 2);
+					want = exp(-13.0 * r);
+					if (j == 1) {
+						want *= c * 2 * 13 * 2 / (dim[0] * scale) * (2 * s[0] - 1);
+					}
+					if (1e-12 * (fabs(want) + 1e-300) < fabs(want - vol[i]) && 1e-300 < fabs(want)) {
+						wrong = 1;
+					}
+				}
+			}
+		}
+
+		if (wrong) {
+			printf("%s gaussian (%s) is off\n", __FUNCTION__, j == 0 ? "still" : "traveling");
+			rc = 0;
+		}
+	}
+
+	init_parse(&init, "planewave amp=2 wavelength=0.25 phase=0.5 axis=y travel=-y");
+	init_fill(&init, vol, dim, scale, c);
+
+	k = 2 * M_PI / 0.25;
+
+	for (z = 0, i = 0, wrong = 0; z < dim[2]; z++) {
+		for (y = 0; y < dim[1]; y++) {
+			for (x = 0; x < dim[0]; x++, i++) {
+				want = c * 2 * k * cos(k * y / dim[1] + 0.5) / (dim[1] * scale);
+				if (1e-9 < fabs(want - vol[i]) / (2 * c * k / (dim[1] * scale))) {
+					wrong = 1;
+				}
+			}
+		}
+	}
+
+	if (wrong) {
+		printf("%s planewave is off\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	init_parse(&init, "point amp=5 center=0.25,0.5,1");
+	init_fill(&init, vol, dim, scale, c);
+
+	for (i = 0, nonzero = 0; i < elems; i++) {
+		if (vol[i] != 0) {
+			nonzero++;
+		}
+	}
+
+	// the center's clamped into the volume on the far edge
+	if (nonzero != 1 || vol[((dim[2] - 1) * (u64)dim[1] + 9) * dim[0] + 6] != 5) {
+		printf("%s point is off\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	free(vol);
+
+	return rc;
+}
+
+/* test_initbinary : tests the binary init protocol's header, and reading answers to it back */
+int test_initbinary(void)
+{
+	char buf[BUFSMALL];
+	ivec3_t dim = { 5, 4, 3 };
+	ivec3_t got;
+	f64 *vol, *want, scale;
+	u64 elems, i;
+	int version;
+	FILE *fp;
+	int rc;
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	elems = dim[0] * dim[1] * dim[2];
+
+	vol = calloc(elems, sizeof(f64));
+	want = calloc(elems, sizeof(f64));
+
+	for (i = 0; i < elems; i++) {
+		want[i] = i * 0.1 - 1;
+	}
+
+	// the program has to be able to get the dimensions and the scale back out, exactly
+	fp = tmpfile();
+	init_binaryask(fp, dim, 1 / 3.0);
+	rewind(fp);
+
+	if (fgets(buf, sizeof buf, fp) != buf ||
+			sscanf(buf, INIT_MAGIC " %d %d %d %d %lf", &version, &got[0], &got[1], &got[2], &scale) != 5 ||
+			version != INIT_VERSION || memcmp(got, dim, sizeof(dim)) != 0 || scale != 1 / 3.0) {
+		printf("%s header '%s' doesn't parse back\n", __FUNCTION__, buf);
+		rc = 0;
+	}
+
+	fclose(fp);
+
+	fp = test_initanswer(INIT_MAGIC " 1\n", want, elems);
+	if (init_binaryread(fp, vol, dim) != 1 || memcmp(vol, want, sizeof(f64) * elems) != 0) {
+		printf("%s didn't read a good answer back\n", __FUNCTION__);
+		rc = 0;
+	}
+	fclose(fp);
+
+	// a text protocol program answers with a value, and that isn't an error, it's a 0
+	fp = test_initanswer("0.0\n", want, elems);
+	if (init_binaryread(fp, vol, dim) != 0) {
+		printf("%s took a text protocol answer\n", __FUNCTION__);
+		rc = 0;
+	}
+	fclose(fp);
+
+	fp = test_initanswer(INIT_MAGIC "X 1\n", want, elems);
+	if (init_binaryread(fp, vol, dim) != 0) {
+		printf("%s took a header that only starts with " INIT_MAGIC "\n", __FUNCTION__);
+		rc = 0;
+	}
+	fclose(fp);
+
+	fp = test_initanswer(INIT_MAGIC " 2\n", want, elems);
+	if (init_binaryread(fp, vol, dim) != -1) {
+		printf("%s took an answer from a newer protocol\n", __FUNCTION__);
+		rc = 0;
+	}
+	fclose(fp);
+
+	fp = test_initanswer(INIT_MAGIC " 1\n", want, elems - 1);
+	if (init_binaryread(fp, vol, dim) != -1) {
+		printf("%s took an answer that's a value short\n", __FUNCTION__);
+		rc = 0;
+	}
+	fclose(fp);
+
+	free(vol);
+	free(want);
+
+	return rc;
+}
+
+/* test_initanswer : makes an init program's answer, a header line and n values, ready to be read */
+FILE *test_initanswer(char *header, f64 *vol, u64 n)
+{
+	FILE *fp;
+
+	fp = tmpfile();
+
+	fputs(header, fp);
+	fwrite(vol, sizeof(f64), n, fp);
+
+	rewind(fp);
+
+	return fp;
+}
+
+/* test_initresample : tests copying and resampling volumes in files onto other grids */
+int test_initresample(void)
+{
+	char *orders[] = { "xyz", "zyx", "yzx" };
+	ivec3_t sdim = { 5, 4, 3 };
+	ivec3_t dims[] = {
+		{ 5, 4, 3 }, { 9, 7, 5 }, { 8, 6, 7 }, { 3, 2, 2 }, { 17, 1, 6 }
+	};
+	ivec3_t p, stride;
+	f64 *src, *vol, want;
+	s64 i, j, k, n;
+	int rc, axis;
+
+	/*
+	 * NOTE
+	 * Trilinear interpolation gets anything that's linear along each axis
+	 * exactly right, so a multilinear field resampled onto any other grid
+	 * has to come out as that field sampled on the new grid, give or take
+	 * rounding. On the same grid, it's a copy, and has to be bit for bit.
+	 */
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	src = calloc(sdim[0] * sdim[1] * sdim[2], sizeof(f64));
+	vol = calloc(17 * 7 * 7, sizeof(f64));
+
+	for (i = 0; i < ARRSIZE(orders); i++) {
+		for (j = 0, n = 1; j < 3; j++) {
+			axis = orders[i][j] - 'x';
+			stride[axis] = n;
+			n *= sdim[axis];
+		}
+
+		for (p[2] = 0; p[2] < sdim[2]; p[2]++)
+		for (p[1] = 0; p[1] < sdim[1]; p[1]++)
+		for (p[0] = 0; p[0] < sdim[0]; p[0]++) {
+			src[p[0] * stride[0] + p[1] * stride[1] + p[2] * stride[2]] = test_initmultilinear(p, sdim);
+		}
+
+		for (j = 0; j < ARRSIZE(dims); j++) {
+			init_resample(src, sdim, orders[i], vol, dims[j]);
+
+			for (p[2] = 0, k = 0; p[2] < dims[j][2]; p[2]++)
+			for (p[1] = 0; p[1] < dims[j][1]; p[1]++)
+			for (p[0] = 0; p[0] < dims[j][0]; p[0]++, k++) {
+				if (j == 0) {
+					want = src[p[0] * stride[0] + p[1] * stride[1] + p[2] * stride[2]];
+				} else {
+					want = test_initmultilinear(p, dims[j]);
+				}
+
+				if (j == 0 ? vol[k] != want : 1e-12 < fabs(vol[k] - want)) {
+					printf("%s %s onto %dx%dx%d, (%d, %d, %d) is %g, not %g\n", __FUNCTION__, orders[i],
+						dims[j][0], dims[j][1], dims[j][2], p[0], p[1], p[2], vol[k], want);
+					rc = 0;
+					break;
+				}
+			}
+		}
+	}
+
+	free(src);
+	free(vol);
+
+	return rc;
+}
+
+/* test_initmultilinear : 1 + 2u + 3v + 5w + 7uvw, at point p of a dim grid over the unit cube */
+f64 test_initmultilinear(ivec3_t p, ivec3_t dim)
+{
+	dvec3_t u;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		u[i] = dim[i] == 1 ? 0 : p[i] / (f64)(dim[i] - 1);
+	}
+
+	return 1 + 2 * u[0] + 3 * u[1] + 5 * u[2] + 7 * u[0] * u[1] * u[2];
+}
+
+/* test_molt_weights : tests the weights against the original cumulative sum ones, and a few rows at a time against all at once */
+int test_molt_weights(void)
+{
+	f64 nus[] = { 0.3, 0.0123456, 1.7 };
+	s32 lens[] = { 7, 37, 500 };
+	s32 orders[] = { 2, 4, 6 };
+	s32 splits[] = { 1, 2, 3, 7 };
+	f64 *wl, *wr, *pl, *pr, *rl, *rr, *phi, *work;
+	s32 a, b, c, d, i, n, m, rows;
+	int rc;
+
+	rc = 1;
+
+	for (a = 0; a < ARRSIZE(nus); a++) {
+		for (b = 0; b < ARRSIZE(lens); b++) {
+			for (c = 0; c < ARRSIZE(orders); c++) {
+				n = lens[b];
+				m = orders[c];
+				rows = n * (m + 1);
+
+				wl = calloc(rows, sizeof(f64));
+				wr = calloc(rows, sizeof(f64));
+				pl = calloc(rows, sizeof(f64));
+				pr = calloc(rows, sizeof(f64));
+				rl = calloc(rows, sizeof(f64));
+				rr = calloc(rows, sizeof(f64));
+				phi = calloc(m + 1, sizeof(f64));
+				work = calloc(molt_get_exp_worklen(m), sizeof(f64));
+
+				molt_get_exp_weights(nus[a], wl, wr, n, m);
+				molt_exp_coeff(phi, m + 1, nus[a]);
+
+				// every stencil fits in the line here (m + 1 <= n), which is where the old ones were right
+				test_exp_weightsref(nus[a], rl, rr, n, m);
+
+				if (memcmp(wl, rl, rows * sizeof(f64)) || memcmp(wr, rr, rows * sizeof(f64))) {
+					printf("%s nu %g, %d points, order %d doesn't match the original weights\n", __FUNCTION__, nus[a], n, m);
+					rc = 0;
+				}
+
+				for (d = 0; d < ARRSIZE(splits); d++) {
+					memset(pl, 0, rows * sizeof(f64));
+					memset(pr, 0, rows * sizeof(f64));
+
+					// backwards, so no piece can lean on one before it
+					for (i = splits[d] - 1; i >= 0; i--) {
+						molt_get_exp_rows(nus[a], pl, pr, n, m,
+							(s32)((s64)n * i / splits[d]), (s32)((s64)n * (i + 1) / splits[d]), phi, work);
+					}
+
+					if (memcmp(wl, pl, rows * sizeof(f64)) || memcmp(wr, pr, rows * sizeof(f64))) {
+						printf("%s nu %g, %d points, order %d, in %d pieces doesn't match\n", __FUNCTION__, nus[a], n, m, splits[d]);
+						rc = 0;
+					}
+				}
+
+				free(wl);
+				free(wr);
+				free(pl);
+				free(pr);
+				free(rl);
+				free(rr);
+				free(phi);
+				free(work);
+			}
+		}
+	}
+
+	return rc;
+}
+
+/* test_exp_weightsref : makes the weights the way molt_get_exp_weights first did, from a cumulative sum of nu */
+void test_exp_weightsref(f64 nu, f64 *wl, f64 *wr, s32 nulen, s32 orderm)
+{
+	int i, j, k;
+	int rowlen, reallen;
+	double *x, *phi, *workvect_r, *workvect_l;
+	double *workmat_r, *workmat_l;
+
+	// NOTE this is a copy of the original, so keep it that way, it's what the new one's held to
+
+	rowlen = orderm + 1;
+	reallen = nulen + 1;
+
+	x          = (f64 *)calloc(sizeof(double), reallen);
+	phi        = (f64 *)calloc(sizeof(double), rowlen);
+	workvect_r = (f64 *)calloc(sizeof(double), rowlen);
+	workvect_l = (f64 *)calloc(sizeof(double), rowlen);
+	workmat_r  = (f64 *)calloc(sizeof(double), rowlen * rowlen);
+	workmat_l  = (f64 *)calloc(sizeof(double), rowlen * rowlen);
+
+	assert(x && phi && workvect_r && workvect_l && workmat_r && workmat_l);
+
+	molt_cumsum(x, reallen, nu);
+
+	for (i = 0; i < nulen; i++) {
+		molt_exp_coeff(phi, rowlen, nu);
+
+		j = molt_get_exp_ind(i, nulen, orderm);
+
+		for (k = 0; k < rowlen; k++) {
+			workvect_l[k] = (x[i + 1] - x[j + k]) / nu;
+			workvect_r[k] = (x[j + k] - x[i    ]) / nu;
+		}
+
+		molt_invvan(workmat_l, workvect_l, rowlen);
+		molt_invvan(workmat_r, workvect_r, rowlen);
+
+		molt_matflip(workmat_l, rowlen);
+		molt_matflip(workmat_r, rowlen);
+
+		molt_mat_mv_mult(wl + (i * rowlen), workmat_l, phi, rowlen);
+		molt_mat_mv_mult(wr + (i * rowlen), workmat_r, phi, rowlen);
+	}
+
+	free(x);
+	free(phi);
+	free(workvect_r);
+	free(workvect_l);
+	free(workmat_r);
+	free(workmat_l);
+}
+
+/* test_lump : tests writing a lump file, and reading it back, mapped and followed */
+int test_lump(void)
+{
+	char *file = "molttest.dat";
+	struct lump_t *other;
+	ivec3_t dim = { 13, 7, 5 };
+	f64 *vol;
+	u64 i, n, val, entries;
+	int rc;
+
+	/*
+	 * NOTE
+	 * The volume goes in flat as AMP, and bricked as BRK, so lump_read_slab
+	 * takes both paths. There are more ETC lumps than fit in the table's
+	 * first extent, so reading them back walks the chain. Then the file's
+	 * followed, the way --tail does it, while the writer truncates and
+	 * writes new lumps over the old ones.
+	 */
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	remove(file);
+
+	n = dim[0] * (u64)dim[1] * dim[2];
+
+	vol = calloc(n, sizeof(f64));
+	assert(vol);
+
+	for (i = 0; i < n; i++) {
+		vol[i] = sin(i * 0.1) * 1e2;
+	}
+
+	if (lump_open(file) < 0) {
+		printf("%s couldn't open '%s'\n", __FUNCTION__, file);
+		free(vol);
+		return 0;
+	}
+
+	lump_setbrick("BRK", dim, 4);
+
+	lump_write("AMP", n * sizeof(f64), vol, NULL);
+	lump_write("BRK", n * sizeof(f64), vol, NULL);
+
+	for (i = 0; i < 200; i++) {
+		val = i;
+		lump_write("ETC", sizeof(val), &val, NULL);
+	}
+
+	lump_close();
+
+	// mapped, and read back
+	if (lump_openmap(file) < 0) {
+		printf("%s couldn't map '%s'\n", __FUNCTION__, file);
+		rc = 0;
+	} else {
+		lump_getnumentries("ETC", &entries);
+		if (entries != 200) {
+			printf("%s has %ld ETC lumps, not 200\n", __FUNCTION__, entries);
+			rc = 0;
+		}
+
+		for (i = 0; i < entries; i++) {
+			if (lump_read("ETC", i, &val) < 0 || val != i) {
+				printf("%s read ETC[%ld] wrong\n", __FUNCTION__, i);
+				rc = 0;
+			}
+		}
+
+		if (test_lumpslabs("AMP", vol, dim) || test_lumpslabs("BRK", vol, dim)) {
+			rc = 0;
+		}
+
+		lump_close();
+	}
+
+	// the writer's reopened and set aside, while the reader follows it
+	if (lump_reopen(file) < 0) {
+		printf("%s couldn't reopen '%s'\n", __FUNCTION__, file);
+		remove(file);
+		free(vol);
+		return 0;
+	}
+
+	other = lump_detach();
+
+	if (lump_openfollow(file) < 0) {
+		printf("%s couldn't follow '%s'\n", __FUNCTION__, file);
+		lump_release(other);
+		remove(file);
+		free(vol);
+		return 0;
+	}
+
+	lump_swap(other);
+
+	// the first 100 ETC lumps stay, and 10 new ones take the place of the rest
+	if (lump_truncate(2 + 100) < 0) {
+		printf("%s couldn't truncate\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	for (i = 0; i < 10; i++) {
+		val = 1000 + i;
+		lump_write("ETC", sizeof(val), &val, NULL);
+	}
+
+	lump_swap(other);
+
+	if (lump_refresh() < 0) {
+		printf("%s couldn't refresh\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	lump_getnumentries("ETC", &entries);
+	if (entries != 110) {
+		printf("%s follows %ld ETC lumps after the truncate, not 110\n", __FUNCTION__, entries);
+		rc = 0;
+	}
+
+	for (i = 0; i < entries; i++) {
+		if (lump_read("ETC", i, &val) < 0 || val != (i < 100 ? i : 1000 + i - 100)) {
+			printf("%s followed ETC[%ld] wrong\n", __FUNCTION__, i);
+			rc = 0;
+		}
+	}
+
+	if (test_lumpslabs("AMP", vol, dim)) {
+		rc = 0;
+	}
+
+	lump_close();
+	lump_release(other);
+
+	remove(file);
+	free(vol);
+
+	return rc;
+}
+
+/* test_lumpslabs : reads a few sub-boxes of the volume back with lump_read_slab, returns how many came back wrong */
+int test_lumpslabs(char *tag, f64 *vol, ivec3_t dim)
+{
+	ivec3_t starts[] = { { 0, 0, 0 }, { 0, 0, 2 }, { 0, 3, 1 }, { 5, 2, 1 }, { 12, 6, 4 } };
+	ivec3_t counts[] = { { 13, 7, 5 }, { 13, 7, 3 }, { 13, 4, 2 }, { 6, 3, 4 }, { 1, 1, 1 } };
+	ivec3_t p;
+	f64 *box;
+	u64 i, j;
+	int bad;
+
+	bad = 0;
+
+	box = calloc(dim[0] * (u64)dim[1] * dim[2], sizeof(f64));
+	assert(box);
+
+	for (i = 0; i < ARRSIZE(starts); i++) {
+		if (lump_read_slab(tag, 0, dim, starts[i], counts[i], box) < 0) {
+			printf("%s couldn't read %s box %ld\n", __FUNCTION__, tag, i);
+			bad++;
+			continue;
+		}
+
+		j = 0;
+
+		for (p[2] = starts[i][2]; p[2] < starts[i][2] + counts[i][2]; p[2]++)
+		for (p[1] = starts[i][1]; p[1] < starts[i][1] + counts[i][1]; p[1]++)
+		for (p[0] = starts[i][0]; p[0] < starts[i][0] + counts[i][0]; p[0]++, j++) {
+			if (box[j] != vol[(p[2] * (u64)dim[1] + p[1]) * dim[0] + p[0]]) {
+				printf("%s %s box %ld is wrong at %d,%d,%d\n", __FUNCTION__, tag, i, p[0], p[1], p[2]);
+				bad++;
+				break;
+			}
+		}
+	}
+
+	free(box);
+
+	return bad;
+}
+
+/* test_lumpfollow : tests a reader following a lump file while it's appended to, truncated and started over */
+int test_lumpfollow(void)
+{
+	char *file = "molttest_follow.dat";
+	struct lumpheader_t header;
+	struct lump_t *writer;
+	u64 i, val;
+	int rc;
+
+	/*
+	 * NOTE
+	 * The writer and the reader are both in this process, traded back and
+	 * forth with lump_swap. Lumps written i'th hold i, except the ones written
+	 * after the truncate, which hold 1000 + i.
+	 */
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	remove(file);
+
+	if (lump_open(file) < 0) {
+		printf("%s couldn't open '%s'\n", __FUNCTION__, file);
+		return 0;
+	}
+
+	for (i = 0; i < 3; i++) {
+		val = i;
+		lump_write("ETC", sizeof(val), &val, NULL);
+	}
+
+	writer = lump_detach();
+
+	if (lump_openfollow(file) < 0) {
+		printf("%s couldn't follow '%s'\n", __FUNCTION__, file);
+		lump_release(writer);
+		remove(file);
+		return 0;
+	}
+
+	rc &= test_lumpcheck("opened", 3, 3, 0);
+
+	// appended lumps show up, even once they need more of the table than it started with
+	lump_swap(writer);
+	for (i = 3; i < 103; i++) {
+		val = i;
+		lump_write("ETC", sizeof(val), &val, NULL);
+	}
+	lump_swap(writer);
+
+	rc &= lump_refresh() == 0;
+	rc &= test_lumpcheck("appended", 103, 103, 0);
+
+	// nothing new is nothing new
+	rc &= lump_refresh() == 0;
+	rc &= test_lumpcheck("refreshed again", 103, 103, 0);
+
+	// truncating bumps the generation, and the reader starts its table over
+	lump_swap(writer);
+	lump_truncate(50);
+	for (i = 50; i < 52; i++) {
+		val = 1000 + i;
+		lump_write("ETC", sizeof(val), &val, NULL);
+	}
+	lump_swap(writer);
+
+	rc &= lump_refresh() == 0;
+	rc &= test_lumpcheck("truncated", 52, 50, 1000);
+
+	lump_getheader(&header);
+	if (header.gen != 1) {
+		printf("%s reader has generation %ld, not 1\n", __FUNCTION__, header.gen);
+		rc = 0;
+	}
+
+	// a new run over the same name has fewer lumps than we've seen, so that's a reload too
+	lump_swap(writer);
+	lump_close();
+	lump_open(file);
+	val = 1000;
+	lump_write("ETC", sizeof(val), &val, NULL);
+	lump_swap(writer);
+
+	rc &= lump_refresh() == 0;
+	rc &= test_lumpcheck("started over", 1, 0, 1000);
+
+	lump_close();
+	lump_release(writer);
+
+	remove(file);
+
+	return rc;
+}
+
+/* test_lumpcheck : checks the open lump file has n ETC lumps, each its index, plus base past truncated, 0 if not */
+int test_lumpcheck(char *when, u64 n, u64 truncated, u64 base)
+{
+	u64 i, val, want, entries;
+
+	lump_getnumentries("ETC", &entries);
+	if (entries != n) {
+		printf("%s %s, has %ld ETC lumps, not %ld\n", __FUNCTION__, when, entries, n);
+		return 0;
+	}
+
+	for (i = 0; i < entries; i++) {
+		want = i < truncated ? i : base + i;
+		if (lump_read("ETC", i, &val) < 0 || val != want) {
+			printf("%s %s, ETC[%ld] is wrong\n", __FUNCTION__, when, i);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* test_restart : tests checking a lump file before restarting it, and picking up from its last AMP entries */
+int test_restart(void)
+{
+	char *file = "molttest_restart.dat";
+	char *tags[] = {
+		MOLTSTR_VLX, MOLTSTR_VRX, MOLTSTR_VLY, MOLTSTR_VRY, MOLTSTR_VLZ, MOLTSTR_VRZ,
+		MOLTSTR_WLX, MOLTSTR_WRX, MOLTSTR_WLY, MOLTSTR_WRY, MOLTSTR_WLZ, MOLTSTR_WRZ
+	};
+	struct lumpheader_t header;
+	struct molt_cfg_t config, other;
+	ivec3_t pinc, points;
+	f64 *vol, *prev, *curr;
+	u64 elems, i, j, lumps;
+	s64 t, taken;
+	int rc;
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	test_restartcfg(&config, 8);
+
+	molt_cfg_parampull_xyz(&config, pinc, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(&config, points, MOLT_PARAM_POINTS);
+
+	elems = pinc[0] * (u64)pinc[1] * pinc[2];
+
+	vol = calloc(elems, sizeof(f64));
+	prev = calloc(elems, sizeof(f64));
+	curr = calloc(elems, sizeof(f64));
+
+	remove(file);
+
+	if (lump_open(file) < 0) {
+		printf("%s couldn't open '%s'\n", __FUNCTION__, file);
+		return 0;
+	}
+
+	// everything setup writes, with the weights short a row on z
+	lump_write(MOLTSTR_CONFIG, sizeof(config), &config, NULL);
+	for (i = 0; i < ARRSIZE(tags); i++) {
+		j = i < 6 ? pinc[i / 2] : points[(i - 6) / 2] * (config.spaceacc + 1);
+		j -= i == 10;
+		lump_write(tags[i], sizeof(f64) * j, vol, NULL);
+	}
+	lump_write(MOLTSTR_VEL, sizeof(f64) * elems, vol, NULL);
+	lump_write(MOLTSTR_AMP, sizeof(f64) * elems, vol, NULL);
+
+	if (restart_check(NULL) == 0) {
+		printf("%s took a lump file with a short WLZ\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	lump_getheader(&header);
+	lump_truncate(header.lumps - 4);
+	lump_write(MOLTSTR_WLZ, sizeof(f64) * points[2] * (config.spaceacc + 1), vol, NULL);
+	lump_write(MOLTSTR_WRZ, sizeof(f64) * points[2] * (config.spaceacc + 1), vol, NULL);
+	lump_write(MOLTSTR_VEL, sizeof(f64) * elems, vol, NULL);
+
+	if (restart_check(&config) == 0) {
+		printf("%s took a lump file without an AMP\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	lump_write(MOLTSTR_AMP, sizeof(f64) * elems, vol, NULL);
+
+	if (restart_check(NULL) < 0 || restart_check(&config) < 0) {
+		printf("%s turned away a good lump file\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// a config that's off anywhere is a different simulation
+	other = config;
+	other.t_params[MOLT_PARAM_STOP]++;
+	if (restart_check(&other) == 0) {
+		printf("%s took a config with a different t_stop\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	other = config;
+	other.alpha *= 2;
+	if (restart_check(&other) == 0) {
+		printf("%s took a config with a different alpha\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// only the initial conditions, there's nothing to pick up
+	taken = restart_fromamp(&config, prev, curr, &t);
+	if (taken != 0) {
+		printf("%s found %ld steps with only AMP[0]\n", __FUNCTION__, taken);
+		rc = 0;
+	}
+
+	// AMP[i] is all i, and the last step only got as far as its AMP and one stats lump
+	for (i = 1; i < 4; i++) {
+		for (j = 0; j < elems; j++) {
+			vol[j] = i;
+		}
+		if (i == 3) {
+			lump_getheader(&header);
+			lumps = header.lumps;
+		}
+		lump_write(MOLTSTR_AMP, sizeof(f64) * elems, vol, NULL);
+		lump_write("STATS", sizeof(f64), vol, NULL);
+	}
+
+	taken = restart_fromamp(&config, prev, curr, &t);
+	if (taken != 2 || t != config.t_params[MOLT_PARAM_START] + 2 * config.t_params[MOLT_PARAM_STEP]) {
+		printf("%s should have taken 2 steps to t = 2, not %ld to %ld\n", __FUNCTION__, taken, t);
+		rc = 0;
+	}
+
+	rc &= test_restartvols("after a partial step", prev, curr, elems, 1, 2);
+
+	lump_getheader(&header);
+	if (header.lumps != lumps) {
+		printf("%s left %ld lumps, not %ld\n", __FUNCTION__, header.lumps, lumps);
+		rc = 0;
+	}
+
+	// a finished step is left alone, it didn't need anything past its AMP
+	lump_write(MOLTSTR_AMP, sizeof(f64) * elems, vol, NULL);
+
+	taken = restart_fromamp(&config, prev, curr, &t);
+	if (taken != 3) {
+		printf("%s should have taken 3 steps, not %ld\n", __FUNCTION__, taken);
+		rc = 0;
+	}
+
+	rc &= test_restartvols("after a whole step", prev, curr, elems, 2, 3);
+
+	lump_close();
+
+	remove(file);
+
+	free(vol);
+	free(prev);
+	free(curr);
+
+	return rc;
+}
+
+/* test_restartcfg : fills out a small config, n points on a side, for the restart and checkpoint tests */
+void test_restartcfg(struct molt_cfg_t *cfg, s64 n)
+{
+	memset(cfg, 0, sizeof(*cfg));
+
+	molt_cfg_set_spacescale(cfg, 1);
+	molt_cfg_set_timescale(cfg, 1);
+
+	molt_cfg_dims_t(cfg, 0, 10, 1, 10, 11);
+	molt_cfg_dims_x(cfg, 0, n - 1, 1, n - 1, n);
+	molt_cfg_dims_y(cfg, 0, n - 1, 1, n - 1, n);
+	molt_cfg_dims_z(cfg, 0, n - 1, 1, n - 1, n);
+
+	molt_cfg_set_accparams(cfg, 3, 3);
+
+	cfg->alpha = cfg->beta / (MOLT_TISSUESPEED * cfg->t_params[MOLT_PARAM_STEP] * cfg->time_scale);
+
+	molt_cfg_set_nu(cfg);
+}
+
+/* test_restartvols : checks prev is all a and curr is all b, 0 if not */
+int test_restartvols(char *when, f64 *prev, f64 *curr, u64 elems, f64 a, f64 b)
+{
+	u64 i;
+
+	for (i = 0; i < elems; i++) {
+		if (prev[i] != a || curr[i] != b) {
+			printf("%s %s, prev and curr should be %g and %g, not %g and %g at %ld\n",
+				__FUNCTION__, when, a, b, prev[i], curr[i], i);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* test_chkpt : tests the checkpoint ring, and restoring the newest whole checkpoint in it */
+int test_chkpt(void)
+{
+	char *file = "molttest_chkpt.dat";
+	struct lumpheader_t header;
+	struct molt_cfg_t config, other;
+	struct chkpt_t slot;
+	f64 *state[CHKPT_VOLUMES];
+	u64 elems, i, j, k, entries, lumps[4];
+	s64 t;
+	u32 flags;
+	int rc;
+
+	/*
+	 * NOTE
+	 * The k'th checkpoint is taken at t = k, with flags k, after the k'th ETC
+	 * lump, and volume v in it is all 100 * k + v. With a ring of two, the
+	 * third lands on top of the first.
+	 */
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	test_restartcfg(&config, 6);
+
+	elems = 6 * 6 * 6;
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		state[i] = calloc(elems, sizeof(f64));
+	}
+
+	remove(file);
+
+	if (lump_open(file) < 0) {
+		printf("%s couldn't open '%s'\n", __FUNCTION__, file);
+		return 0;
+	}
+
+	lump_write(MOLTSTR_CONFIG, sizeof(config), &config, NULL);
+
+	if (chkpt_restore(&config, state, elems, &t, &flags) != 0) {
+		printf("%s restored a checkpoint from a file without any\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	for (k = 1; k <= 3; k++) {
+		lump_write("ETC", sizeof(k), &k, NULL);
+
+		for (i = 0; i < CHKPT_VOLUMES; i++) {
+			for (j = 0; j < elems; j++) {
+				state[i][j] = 100 * k + i;
+			}
+		}
+
+		if (chkpt_write(2, &config, state, elems, k, k) < 0) {
+			printf("%s couldn't write checkpoint %ld\n", __FUNCTION__, k);
+			rc = 0;
+		}
+
+		lump_getheader(&header);
+		lumps[k] = header.lumps;
+	}
+
+	// the lumps written after the last checkpoint get rolled back
+	lump_write("ETC", sizeof(k), &k, NULL);
+	lump_write(MOLTSTR_AMP, sizeof(f64) * elems, state[0], NULL);
+
+	lump_getnumentries(MOLTSTR_CHKPT, &entries);
+	if (entries != 2) {
+		printf("%s has %ld checkpoint slots, not 2\n", __FUNCTION__, entries);
+		rc = 0;
+	}
+
+	for (i = 0; i < entries; i++) {
+		lump_read_range(MOLTSTR_CHKPT, i, 0, sizeof(slot), &slot);
+		if (slot.seq != 3 - i) {
+			printf("%s slot %ld has seq %ld, not %ld\n", __FUNCTION__, i, slot.seq, 3 - i);
+			rc = 0;
+		}
+	}
+
+	// a different simulation, or volumes of a different size, never match
+	other = config;
+	other.x_params[MOLT_PARAM_STOP]++;
+	if (chkpt_restore(&other, state, elems, &t, &flags) != -1) {
+		printf("%s restored a checkpoint into a different config\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	if (chkpt_restore(&config, state, elems / 2, &t, &flags) != 0) {
+		printf("%s restored a checkpoint into volumes of the wrong size\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	rc &= test_chkptcheck("newest", &config, state, elems, 3);
+
+	lump_getheader(&header);
+	if (header.lumps != lumps[3]) {
+		printf("%s left %ld lumps, not %ld\n", __FUNCTION__, header.lumps, lumps[3]);
+		rc = 0;
+	}
+
+	// a slot that was being written when we went down is skipped over
+	slot.seq = 0;
+	lump_write_range(MOLTSTR_CHKPT, 0, 0, sizeof(slot.seq), &slot.seq);
+
+	rc &= test_chkptcheck("torn", &config, state, elems, 2);
+
+	lump_getheader(&header);
+	if (header.lumps != lumps[2]) {
+		printf("%s left %ld lumps, not %ld\n", __FUNCTION__, header.lumps, lumps[2]);
+		rc = 0;
+	}
+
+	lump_close();
+
+	remove(file);
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		free(state[i]);
+	}
+
+	return rc;
+}
+
+/* test_chkptcheck : restores a checkpoint, and checks it's the k'th one written, 0 if not */
+int test_chkptcheck(char *when, struct molt_cfg_t *config, f64 **state, u64 elems, u64 k)
+{
+	u64 i, j;
+	s64 t, taken;
+	u32 flags;
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		memset(state[i], 0, sizeof(f64) * elems);
+	}
+
+	t = flags = 0;
+
+	taken = chkpt_restore(config, state, elems, &t, &flags);
+	if (taken != k || t != k || flags != k) {
+		printf("%s %s, restored %ld steps, t = %ld, flags %d, not checkpoint %ld\n", __FUNCTION__, when, taken, t, flags, k);
+		return 0;
+	}
+
+	for (i = 0; i < CHKPT_VOLUMES; i++) {
+		for (j = 0; j < elems; j++) {
+			if (state[i][j] != 100 * k + i) {
+				printf("%s %s, volume %ld is wrong at %ld\n", __FUNCTION__, when, i, j);
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/* test_wcache : tests the weight cache's hits, misses, and turning away files that were tampered with */
+int test_wcache(void)
+{
+	char *dir = "molttest_wcache";
+	char path[BUFLARGE];
+	f64 nu = 0.3;
+	s32 nulen = 37, orderm = 4;
+	f64 *wl, *wr, *gl, *gr, junk;
+	size_t rows;
+	FILE *fp;
+	int rc;
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	rows = nulen * (orderm + 1);
+
+	wl = calloc(rows, sizeof(f64));
+	wr = calloc(rows, sizeof(f64));
+	gl = calloc(rows, sizeof(f64));
+	gr = calloc(rows, sizeof(f64));
+
+	molt_get_exp_weights(nu, wl, wr, nulen, orderm);
+
+	wcache_entry(path, sizeof path, dir, nu, nulen, orderm);
+	remove(path);
+
+	if (wcache_load(dir, nu, nulen, orderm, gl, gr) == 0) {
+		printf("%s hit on an empty cache\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	if (wcache_store(dir, nu, nulen, orderm, wl, wr) < 0) {
+		printf("%s couldn't store into '%s'\n", __FUNCTION__, dir);
+		rc = 0;
+	}
+
+	if (wcache_load(dir, nu, nulen, orderm, gl, gr) < 0 ||
+			memcmp(wl, gl, rows * sizeof(f64)) || memcmp(wr, gr, rows * sizeof(f64))) {
+		printf("%s didn't get back what it stored\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// any parameter being off is a different entry
+	if (wcache_load(dir, nu * (1 + DBL_EPSILON), nulen, orderm, gl, gr) == 0 ||
+			wcache_load(dir, nu, nulen, orderm - 1, gl, gr) == 0) {
+		printf("%s hit for the wrong parameters\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// one weight changed, so it won't checksum
+	junk = 12345.0;
+	fp = fopen(path, "r+b");
+	if (fp == NULL || fseek(fp, -(long)sizeof(junk), SEEK_END) || fwrite(&junk, sizeof(junk), 1, fp) != 1) {
+		printf("%s couldn't tamper with '%s'\n", __FUNCTION__, path);
+		rc = 0;
+	}
+	if (fp) {
+		fclose(fp);
+	}
+
+	if (wcache_load(dir, nu, nulen, orderm, gl, gr) == 0) {
+		printf("%s took a file that doesn't checksum\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// and a file that's cut short
+	fp = fopen(path, "wb");
+	if (fp) {
+		fwrite(wl, sizeof(f64), rows, fp);
+		fclose(fp);
+	}
+
+	if (wcache_load(dir, nu, nulen, orderm, gl, gr) == 0) {
+		printf("%s took a file that's the wrong size\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	remove(path);
+	remove(dir);
+
+	free(wl);
+	free(wr);
+	free(gl);
+	free(gr);
+
+	return rc;
+}
+
+#define LIVE_TESTNAME   "/molttest_live"
+#define LIVE_TESTFRAMES 2000
+
+/* test_live : tests the live frame ring, with a reader racing the writer, and headers that don't add up */
+int test_live(void)
+{
+	ivec3_t dim = { 5, 4, 3 };
+	ivec3_t start = { 1, 1, 1 }, count = { 3, 2, 2 };
+	ivec3_t zero = { 0, 0, 0 };
+	ivec3_t p;
+	struct live_t *writer, *reader;
+	struct livehdr_t *hdr;
+	struct sys_thread *thread;
+	f64 *frame, *got;
+	u64 i, n, head, step, last;
+	size_t len;
+	int bad, rd, rc;
+
+	rc = 1;
+
+	printf("%s\n", __FUNCTION__);
+
+	n = dim[0] * (u64)dim[1] * dim[2];
+
+	frame = calloc(n, sizeof(f64));
+	got = calloc(n, sizeof(f64));
+
+	writer = live_create(LIVE_TESTNAME, dim, 3);
+	reader = live_open(LIVE_TESTNAME);
+
+	if (writer == NULL || reader == NULL) {
+		printf("%s couldn't make the ring (no shared memory here?)\n", __FUNCTION__);
+		live_close(reader);
+		live_close(writer);
+		free(frame);
+		free(got);
+		return 0;
+	}
+
+	head = 0;
+
+	if (live_read(reader, &head, got, start, count, &step) != 0) {
+		printf("%s read a frame before one was published\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	// more frames than slots, so the reader only ever sees the newest
+	for (step = 1; step <= 5; step++) {
+		for (i = 0; i < n; i++) {
+			frame[i] = step * 1000 + i;
+		}
+		live_publish(writer, frame, step);
+	}
+
+	if (live_read(reader, &head, got, start, count, &step) != 1 || step != 5 || head != 5) {
+		printf("%s didn't read the newest frame\n", __FUNCTION__);
+		rc = 0;
+	} else {
+		i = 0;
+		for (p[2] = start[2]; p[2] < start[2] + count[2]; p[2]++)
+		for (p[1] = start[1]; p[1] < start[1] + count[1]; p[1]++)
+		for (p[0] = start[0]; p[0] < start[0] + count[0]; p[0]++, i++) {
+			if (got[i] != 5000 + (p[2] * (u64)dim[1] + p[1]) * dim[0] + p[0]) {
+				printf("%s box is wrong at %d,%d,%d\n", __FUNCTION__, p[0], p[1], p[2]);
+				rc = 0;
+			}
+		}
+	}
+
+	if (live_read(reader, &head, got, start, count, &step) != 0) {
+		printf("%s read the same frame twice\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	live_close(writer);
+
+	if (live_read(reader, &head, got, start, count, &step) != -1) {
+		printf("%s didn't see the ring close\n", __FUNCTION__);
+		rc = 0;
+	}
+
+	live_close(reader);
+
+	// a reader racing the writer has to get whole frames, every value its step
+	writer = live_create(LIVE_TESTNAME, dim, 2);
+	reader = live_open(LIVE_TESTNAME);
+
+	if (writer == NULL || reader == NULL) {
+		printf("%s couldn't make the ring again\n", __FUNCTION__);
+		live_close(reader);
+		live_close(writer);
+		free(frame);
+		free(got);
+		return 0;
+	}
+
+	thread = sys_threadcreate();
+	sys_threadsetfunc(thread, test_livewriter);
+	sys_threadsetarg(thread, writer);
+	sys_threadstart(thread);
+
+	head = 0;
+	last = 0;
+	bad = 0;
+
+	while ((rd = live_read(reader, &head, got, zero, dim, &step)) != -1) {
+		if (rd == 0) {
+			continue;
+		}
+
+		if (step <= last) {
+			bad++;
+		}
+		last = step;
+
+		for (i = 0; i < n; i++) {
+			if (got[i] != step) {
+				bad++;
+				break;
+			}
+		}
+	}
+
+	sys_threadwait(thread);
+	sys_threadfree(thread);
+
+	live_close(reader);
+
+	if (bad || last != LIVE_TESTFRAMES) {
+		printf("%s got %d torn or stale frames, and the last was %ld\n", __FUNCTION__, bad, last);
+		rc = 0;
+	}
+
+	// now headers that don't agree with themselves, each has to be turned away
+	for (i = 0; i < 5; i++) {
+		len = 4096 + 2 * 576;
+
+		hdr = sys_shmcreate(LIVE_TESTNAME, len);
+		if (hdr == NULL) {
+			rc = 0;
+			break;
+		}
+
+		hdr->flags = 0;
+		hdr->slots = 2;
+		hdr->framesize = sizeof(f64) * 4 * 4 * 4;
+		hdr->slotsize = 576;
+		Vec3Set(hdr->dim, 4, 4, 4);
+		hdr->head = 0;
+
+		switch (i) {
+		case 1: hdr->framesize -= sizeof(f64); break;
+		case 2: hdr->slotsize = hdr->framesize; break;
+		case 3: hdr->slots = 100; break;
+		case 4: hdr->dim[1] = -4; break;
+		}
+
+		hdr->magic = *(u32 *)"LIVE";
+
+		reader = live_open(LIVE_TESTNAME);
+
+		if ((i == 0) != (reader != NULL)) {
+			printf("%s %s header %ld\n", __FUNCTION__, reader ? "took bad" : "turned away good", i);
+			rc = 0;
+		}
+
+		live_close(reader);
+
+		sys_shmunlink(LIVE_TESTNAME);
+		sys_munmap(hdr, len);
+	}
+
+	free(frame);
+	free(got);
+
+	return rc;
+}
+
+/* test_livewriter : publishes frames that are all their own step number, then closes the ring */
+void *test_livewriter(void *arg)
+{
+	struct live_t *live;
+	ivec3_t dim;
+	f64 *frame;
+	u64 i, n, step;
+
+	live = arg;
+
+	live_getdim(live, dim);
+
+	n = dim[0] * (u64)dim[1] * dim[2];
+
+	frame = calloc(n, sizeof(f64));
+
+	for (step = 1; step <= LIVE_TESTFRAMES; step++) {
+		for (i = 0; i < n; i++) {
+			frame[i] = step;
+		}
+		live_publish(live, frame, step);
+	}
+
+	live_close(live);
+
+	free(frame);
+
+	return NULL;
+}
@@ -0,0 +1,337 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 02:30
+ *
+ * Output Streams
+ *
+ * This only knows how to describe a stream and how to cut its entries out of
+ * a volume. Deciding when to write them, and writing them into the lump file,
+ * is left up to the simulation loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common.h"
+#include "brick.h"
+#include "output.h"
+
+static char *g_kinds[] = {
+	"full", "down", "plane", "box", "stats", "probe"
+};
+
+/* output_parse : parses a stream definition, "<tag> <kind> [args] [every=<n>]" */
+int output_parse(struct outstream_t *stream, char *s)
+{
+	char buf[BUFSMALL];
+	char *tok, *kind, *save;
+	int i, n;
+
+	memset(stream, 0, sizeof(*stream));
+
+	stream->every = 1;
+
+	strncpy(buf, s, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+
+	tok = strtoks(buf, " \t", &save);
+	if (tok == NULL || sizeof(stream->tag) < strlen(tok)) {
+		return -1;
+	}
+
+	memcpy(stream->tag, tok, strlen(tok));
+
+	kind = strtoks(NULL, " \t", &save);
+	if (kind == NULL) {
+		return -1;
+	}
+
+	for (stream->kind = 0; stream->kind < OUTPUT_TOTAL; stream->kind++) {
+		if (strcmp(kind, g_kinds[stream->kind]) == 0) {
+			break;
+		}
+	}
+
+	if (stream->kind == OUTPUT_TOTAL) {
+		return -1;
+	}
+
+	// the kind's own arguments come first, every=<n> can come after them
+	for (i = 0; (tok = strtoks(NULL, " \t", &save)) != NULL; i++) {
+		if (strncmp(tok, "every=", 6) == 0) {
+			if (sscanf(tok + 6, "%d%n", &stream->every, &n) != 1 || tok[6 + n]) {
+				return -1;
+			}
+			continue;
+		}
+
+		n = -1;
+
+		switch (stream->kind) {
+		case OUTPUT_DOWN:
+			if (i == 0) {
+				sscanf(tok, "%d%n", &stream->factor, &n);
+			}
+			break;
+
+		case OUTPUT_PLANE:
+			if (i == 0 && 'x' <= tok[0] && tok[0] <= 'z' && tok[1] == '=') {
+				stream->axis = tok[0] - 'x';
+				sscanf(tok + 2, "%d%n", &stream->start[stream->axis], &n);
+				n += 2;
+			}
+			break;
+
+		case OUTPUT_BOX:
+		case OUTPUT_PROBE:
+			if (i == 0) {
+				sscanf(tok, "%d,%d,%d%n", &stream->start[0], &stream->start[1], &stream->start[2], &n);
+			} else if (i == 1 && stream->kind == OUTPUT_BOX) {
+				sscanf(tok, "%d,%d,%d%n", &stream->count[0], &stream->count[1], &stream->count[2], &n);
+			}
+			break;
+		}
+
+		if (n < 0 || tok[n]) {
+			return -1;
+		}
+	}
+
+	// every kind but full and stats needs all of its arguments
+	if ((stream->kind == OUTPUT_DOWN || stream->kind == OUTPUT_PLANE || stream->kind == OUTPUT_PROBE) && i < 1) {
+		return -1;
+	}
+
+	if (stream->kind == OUTPUT_BOX && i < 2) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* output_check : makes sure the stream fits in a dim volume, filling in what it covers */
+int output_check(struct outstream_t *stream, ivec3_t dim)
+{
+	s32 index;
+	int i;
+
+	if (stream->every < 0) {
+		return -1;
+	}
+
+	switch (stream->kind) {
+	case OUTPUT_FULL:
+	case OUTPUT_STATS:
+	case OUTPUT_DOWN:
+		if (stream->kind == OUTPUT_DOWN && stream->factor < 1) {
+			return -1;
+		}
+
+		Vec3Set(stream->start, 0, 0, 0);
+		Vec3Copy(stream->count, dim);
+		break;
+
+	case OUTPUT_PLANE:
+		if (stream->axis < 0 || 2 < stream->axis) {
+			return -1;
+		}
+
+		index = stream->start[stream->axis];
+		if (index < 0 || dim[stream->axis] <= index) {
+			return -1;
+		}
+
+		Vec3Set(stream->start, 0, 0, 0);
+		Vec3Copy(stream->count, dim);
+
+		stream->start[stream->axis] = index;
+		stream->count[stream->axis] = 1;
+		break;
+
+	case OUTPUT_PROBE:
+		Vec3Set(stream->count, 1, 1, 1);
+		// fallthrough
+
+	case OUTPUT_BOX:
+		for (i = 0; i < 3; i++) {
+			if (stream->start[i] < 0 || stream->count[i] < 1 || dim[i] - stream->start[i] < stream->count[i]) {
+				return -1;
+			}
+		}
+		break;
+
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+/* output_dim : gets the dimensions of the stream's entries, returns their size in f64s */
+u64 output_dim(struct outstream_t *stream, ivec3_t dim, ivec3_t out)
+{
+	int i;
+
+	if (stream->kind == OUTPUT_FULL) {
+		Vec3Copy(out, dim);
+	} else if (stream->kind == OUTPUT_DOWN) {
+		for (i = 0; i < 3; i++) {
+			out[i] = (dim[i] + stream->factor - 1) / stream->factor;
+		}
+	} else {
+		Vec3Copy(out, stream->count);
+	}
+
+	return out[0] * (u64)out[1] * out[2];
+}
+
+/* output_due : returns true if the stream wants an entry at the given step */
+int output_due(struct outstream_t *stream, u64 step)
+{
+	return step == 0 || (0 < stream->every && step % stream->every == 0);
+}
+
+/* output_rowsize : returns the size of one of the stream's rows, 0 if its entries are volumes */
+size_t output_rowsize(struct outstream_t *stream)
+{
+	switch (stream->kind) {
+	case OUTPUT_STATS:
+		return sizeof(struct outstat_t);
+	case OUTPUT_PROBE:
+		return sizeof(struct outprobe_t);
+	default:
+		return 0;
+	}
+}
+
+/* output_extract : cuts the stream's entry out of a dim volume src, into dst */
+void output_extract(struct outstream_t *stream, f64 *dst, f64 *src, ivec3_t dim)
+{
+	ivec3_t out, zero, n;
+	s32 f, x, y, z;
+	u64 i, elems;
+
+	if (stream->kind != OUTPUT_DOWN) {
+		Vec3Set(zero, 0, 0, 0);
+		brick_copy(dst, stream->count, zero, src, dim, stream->start, stream->count);
+		return;
+	}
+
+	/*
+	 * NOTE
+	 * Downsampling is a plain block mean. The blocks on the far edges get
+	 * cut short by the volume, and are only averaged over what's left of them,
+	 * so the edges don't get pulled towards zero.
+	 */
+
+	f = stream->factor;
+
+	elems = output_dim(stream, dim, out);
+
+	memset(dst, 0, elems * sizeof(f64));
+
+	for (z = 0, i = 0; z < dim[2]; z++) {
+		for (y = 0; y < dim[1]; y++) {
+			f64 *row = dst + (z / f * (u64)out[1] + y / f) * out[0];
+			for (x = 0; x < dim[0]; x++, i++) {
+				row[x / f] += src[i];
+			}
+		}
+	}
+
+	for (z = 0, i = 0; z < out[2]; z++) {
+		n[2] = dim[2] - z * f < f ? dim[2] - z * f : f;
+		for (y = 0; y < out[1]; y++) {
+			n[1] = dim[1] - y * f < f ? dim[1] - y * f : f;
+			for (x = 0; x < out[0]; x++, i++) {
+				n[0] = dim[0] - x * f < f ? dim[0] - x * f : f;
+				dst[i] /= n[0] * n[1] * n[2];
+			}
+		}
+	}
+}
+
+/* output_advance : moves curr into prev and next into curr, zeroing next, reducing next into stat on the way */
+void output_advance(struct outstat_t *stat, f64 *prev, f64 *curr, f64 *next, ivec3_t dim, dvec3_t h, f64 dt, f64 c)
+{
+	f64 u, v, d, sum, kinetic, potential;
+	u64 i, elems, sx, sy;
+	s32 x, y, z;
+
+	elems = dim[0] * (u64)dim[1] * dim[2];
+
+	if (stat == NULL) {
+		memcpy(prev, curr, elems * sizeof(f64));
+		memcpy(curr, next, elems * sizeof(f64));
+		memset(next, 0, elems * sizeof(f64));
+		return;
+	}
+
+	/*
+	 * NOTE
+	 * The time levels have to be rolled over every step anyway, so the
+	 * reductions ride along with that, and the volume only gets walked once.
+	 * u_t is the backwards difference from curr, and the gradient takes
+	 * forward differences, which only ever read next ahead of where we're
+	 * zeroing it.
+	 */
+
+	sx = dim[0];
+	sy = dim[0] * (u64)dim[1];
+
+	sum = kinetic = potential = 0;
+
+	stat->maxabs = -1;
+
+	for (z = 0, i = 0; z < dim[2]; z++) {
+		for (y = 0; y < dim[1]; y++) {
+			for (x = 0; x < dim[0]; x++, i++) {
+				u = next[i];
+				v = (u - curr[i]) / dt;
+
+				sum += u * u;
+				kinetic += v * v;
+
+				if (x + 1 < dim[0]) {
+					d = (next[i + 1] - u) / h[0];
+					potential += d * d;
+				}
+
+				if (y + 1 < dim[1]) {
+					d = (next[i + sx] - u) / h[1];
+					potential += d * d;
+				}
+
+				if (z + 1 < dim[2]) {
+					d = (next[i + sy] - u) / h[2];
+					potential += d * d;
+				}
+
+				if (stat->maxabs < fabs(u)) {
+					stat->maxabs = fabs(u);
+					Vec3Set(stat->maxat, x, y, z);
+				}
+
+				prev[i] = curr[i];
+				curr[i] = u;
+				next[i] = 0;
+			}
+		}
+	}
+
+	stat->l2 = sqrt(sum * h[0] * h[1] * h[2]);
+	stat->energy = 0.5 * (kinetic + c * c * potential) * h[0] * h[1] * h[2];
+}
+
+/* output_tostr : returns the name of the stream's kind */
+char *output_tostr(int kind)
+{
+	if (kind < 0 || OUTPUT_TOTAL <= kind) {
+		return "unknown";
+	}
+
+	return g_kinds[kind];
+}
+
@@ -0,0 +1,82 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 02:30
+ *
+ * Output Streams
+ *
+ * An output stream is a series of lumps, under its own tag, cut out of the
+ * amplitude every 'every' steps. It's either the whole volume (which is what
+ * AMP is), a volume downsampled by averaging factor^3 blocks, a single axis
+ * aligned plane, or a sub-box. Every stream's entries are x fastest volumes,
+ * planes are just volumes one point thick.
+ *
+ * Stats and probe streams are different, they're a row per step (an outstat_t
+ * or an outprobe_t), and an entry is however many rows piled up before they
+ * got written out.
+ */
+
+#include "common.h"
+
+enum {
+	OUTPUT_FULL,
+	OUTPUT_DOWN,
+	OUTPUT_PLANE,
+	OUTPUT_BOX,
+	OUTPUT_STATS,
+	OUTPUT_PROBE,
+	OUTPUT_TOTAL
+};
+
+struct outstream_t {
+	char tag[8];
+	s32 kind;      // OUTPUT_*
+	s32 every;     // written every 'every' steps, 0 for only the initial amplitude
+	s32 factor;    // OUTPUT_DOWN's block edge length
+	s32 axis;      // OUTPUT_PLANE's axis, 0, 1 or 2 for x, y or z
+	ivec3_t start; // OUTPUT_PLANE, OUTPUT_BOX and OUTPUT_PROBE's part of the volume
+	ivec3_t count;
+};
+
+struct outstat_t {
+	u64 step;
+	f64 l2;        // sqrt(sum u^2 dV)
+	f64 energy;    // 1/2 sum (u_t^2 + c^2 |grad u|^2) dV
+	f64 maxabs;    // the biggest |u|
+	ivec3_t maxat; // and where it is
+	s32 pad;
+};
+
+struct outprobe_t {
+	u64 step;
+	f64 value;
+};
+
+/* output_parse : parses a stream definition, "<tag> <kind> [args] [every=<n>]" */
+int output_parse(struct outstream_t *stream, char *s);
+
+/* output_check : makes sure the stream fits in a dim volume, filling in what it covers */
+int output_check(struct outstream_t *stream, ivec3_t dim);
+
+/* output_dim : gets the dimensions of the stream's entries, returns their size in f64s */
+u64 output_dim(struct outstream_t *stream, ivec3_t dim, ivec3_t out);
+
+/* output_due : returns true if the stream wants an entry at the given step */
+int output_due(struct outstream_t *stream, u64 step);
+
+/* output_rowsize : returns the size of one of the stream's rows, 0 if its entries are volumes */
+size_t output_rowsize(struct outstream_t *stream);
+
+/* output_extract : cuts the stream's entry out of a dim volume src, into dst */
+void output_extract(struct outstream_t *stream, f64 *dst, f64 *src, ivec3_t dim);
+
+/* output_advance : moves curr into prev and next into curr, zeroing next, reducing next into stat on the way */
+void output_advance(struct outstat_t *stat, f64 *prev, f64 *curr, f64 *next, ivec3_t dim, dvec3_t h, f64 dt, f64 c);
+
+/* output_tostr : returns the name of the stream's kind */
+char *output_tostr(int kind);
+
+#endif // OUTPUT_H
+
@@ -0,0 +1,214 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 03:15
+ *
+ * Phase Timers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "sys.h"
+#include "prof.h"
+#include "trace.h"
+
+static u64 g_start[PROF_TOTAL];
+static u64 g_startcounts[PROF_TOTAL][SYS_COUNTER_TOTAL];
+static int g_startrc[PROF_TOTAL]; // what reading g_startcounts returned
+static struct profstep_t g_curr;
+
+static struct sys_counters *g_counters;
+static u32 g_have;
+
+static char *g_phases[] = {
+	"c_op", "d_op", "sweep", "reorg", "gfquad", "elem", "lump", "step"
+};
+
+/* prof_counteropen : counts hardware events in each phase too, returns -1 if we can't have any */
+int prof_counteropen(void)
+{
+	if (g_counters == NULL) {
+		g_counters = sys_counteropen(&g_have);
+	}
+
+	return g_counters ? 0 : -1;
+}
+
+/* prof_counterclose : goes back to only timing phases */
+void prof_counterclose(void)
+{
+	sys_counterclose(g_counters);
+
+	g_counters = NULL;
+	g_have = 0;
+}
+
+/* prof_begin : starts timing a phase */
+void prof_begin(int phase)
+{
+	if (g_counters) {
+		g_startrc[phase] = sys_counterread(g_counters, g_startcounts[phase]);
+	}
+
+	g_start[phase] = sys_nanotime();
+}
+
+/* prof_end : stops timing a phase, adding the time to the step's total */
+void prof_end(int phase)
+{
+	u64 now, counts[SYS_COUNTER_TOTAL];
+	int i, rc;
+
+	now = sys_nanotime();
+
+	if (g_counters) {
+		rc = sys_counterread(g_counters, counts);
+
+		// a failed read on either edge would make the difference garbage, so the phase just doesn't count
+		if (rc < 0 || g_startrc[phase] < 0) {
+			g_curr.missed |= 1 << phase;
+		} else {
+			for (i = 0; i < SYS_COUNTER_TOTAL; i++) {
+				if (g_startcounts[phase][i] <= counts[i]) { // scaled counts can slip backwards a little
+					g_curr.counts[phase][i] += counts[i] - g_startcounts[phase][i];
+				}
+			}
+			if (rc > 0 || g_startrc[phase] > 0) {
+				g_curr.scaled |= 1 << phase;
+			}
+		}
+	}
+
+	g_curr.ns[phase] += now - g_start[phase];
+	g_curr.calls[phase]++;
+
+	trace_span(g_phases[phase], g_start[phase], now);
+}
+
+/* prof_take : moves the totals so far into out, as the given step, and starts over */
+void prof_take(struct profstep_t *out, u64 step)
+{
+	if (out) {
+		*out = g_curr;
+		out->step = step;
+		out->have = g_have;
+	}
+
+	memset(&g_curr, 0, sizeof(g_curr));
+}
+
+/* prof_countersummary : prints a table of what the counters saw, when we have them */
+static void prof_countersummary(FILE *fp, u64 ns[PROF_TOTAL], u64 counts[PROF_TOTAL][SYS_COUNTER_TOTAL], u64 have, u32 scaled, u32 missed, u64 n)
+{
+	char name[BUFSMALL], ipc[BUFSMALL], cache[BUFSMALL], branch[BUFSMALL], bandwidth[BUFSMALL];
+	u64 *c;
+	int j;
+
+	/*
+	 * NOTE
+	 * There's no per thread counter for memory traffic, so the bandwidth is
+	 * a guess, a cache line for every last level miss, over the phase's time.
+	 * Prefetches and write backs don't show up in it, so it's low, but it's
+	 * the right order, and it's good for comparing one phase to another.
+	 */
+
+#define PROF_HAVE(x) (have & (1 << (x)))
+
+	fprintf(fp, "%-8s %8s %16s %16s %12s\n", "phase", "ipc", "cache miss/step", "branch miss/step", "~MB/s");
+
+	for (j = 0; j < PROF_TOTAL; j++) {
+		c = counts[j];
+
+		strcpy(ipc, "-");
+		strcpy(cache, "-");
+		strcpy(branch, "-");
+		strcpy(bandwidth, "-");
+
+		if (PROF_HAVE(SYS_COUNTER_CYCLES) && PROF_HAVE(SYS_COUNTER_INSTRUCTIONS) && c[SYS_COUNTER_CYCLES]) {
+			snprintf(ipc, sizeof(ipc), "%.2lf", (f64)c[SYS_COUNTER_INSTRUCTIONS] / c[SYS_COUNTER_CYCLES]);
+		}
+		if (PROF_HAVE(SYS_COUNTER_CACHEMISSES)) {
+			snprintf(cache, sizeof(cache), "%.1lf", (f64)c[SYS_COUNTER_CACHEMISSES] / n);
+			if (ns[j]) {
+				snprintf(bandwidth, sizeof(bandwidth), "%.1lf", 64e3 * c[SYS_COUNTER_CACHEMISSES] / ns[j]);
+			}
+		}
+		if (PROF_HAVE(SYS_COUNTER_BRANCHMISSES)) {
+			snprintf(branch, sizeof(branch), "%.1lf", (f64)c[SYS_COUNTER_BRANCHMISSES] / n);
+		}
+
+		snprintf(name, sizeof(name), "%s%s%s", prof_tostr(j),
+			(scaled & (1 << j)) ? "*" : "", (missed & (1 << j)) ? "!" : "");
+
+		fprintf(fp, "%-8s %8s %16s %16s %12s\n", name, ipc, cache, branch, bandwidth);
+	}
+
+	if (scaled) {
+		fprintf(fp, "* the counters were shared with something else, those are estimates\n");
+	}
+	if (missed) {
+		fprintf(fp, "! some counter reads failed, those are missing some of the phase\n");
+	}
+
+#undef PROF_HAVE
+}
+
+/* prof_summary : prints a table of where the time went, over n steps */
+void prof_summary(FILE *fp, struct profstep_t *steps, u64 n)
+{
+	u64 ns[PROF_TOTAL], calls[PROF_TOTAL];
+	u64 counts[PROF_TOTAL][SYS_COUNTER_TOTAL];
+	u64 i, have;
+	u32 scaled, missed;
+	int j, k;
+
+	if (n == 0) {
+		return;
+	}
+
+	memset(ns, 0, sizeof(ns));
+	memset(calls, 0, sizeof(calls));
+	memset(counts, 0, sizeof(counts));
+
+	// only counters every step had are worth adding up
+	have = ~(u64)0;
+	scaled = missed = 0;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < PROF_TOTAL; j++) {
+			ns[j] += steps[i].ns[j];
+			calls[j] += steps[i].calls[j];
+			for (k = 0; k < SYS_COUNTER_TOTAL; k++) {
+				counts[j][k] += steps[i].counts[j][k];
+			}
+		}
+		have &= steps[i].have;
+		scaled |= steps[i].scaled;
+		missed |= steps[i].missed;
+	}
+
+	fprintf(fp, "%-8s %14s %14s %12s %8s\n", "phase", "total (sec)", "per step (ms)", "calls/step", "% step");
+
+	for (j = 0; j < PROF_TOTAL; j++) {
+		fprintf(fp, "%-8s %14.6lf %14.6lf %12.1lf %8.2lf\n", prof_tostr(j),
+			1e-9 * ns[j], 1e-6 * ns[j] / n, (f64)calls[j] / n,
+			ns[PROF_STEP] ? 100.0 * ns[j] / ns[PROF_STEP] : 0.0);
+	}
+
+	if (have) {
+		prof_countersummary(fp, ns, counts, have, scaled, missed, n);
+	}
+}
+
+/* prof_tostr : returns the name of a phase */
+char *prof_tostr(int phase)
+{
+	if (phase < 0 || PROF_TOTAL <= phase) {
+		return "unknown";
+	}
+
+	return g_phases[phase];
+}
+
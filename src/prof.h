@@ -0,0 +1,77 @@
+#ifndef PROF_H
+#define PROF_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 03:15
+ *
+ * Phase Timers
+ *
+ * Time spent in each phase of a step, the C and D operators, the sweeps, the
+ * reorgs, the batches of gfquad_m inside the sweeps, element wise passes, and
+ * lump writes, summed up over the step and saved as a row of the PROFILE
+ * lump. The whole step is a phase too, so the rest can be read as fractions
+ * of it. With --trace, each phase is also a span in the trace (see trace.h).
+ *
+ * The timers are just a monotonic timestamp at the beginning and end of a
+ * phase, a few dozen per step, which is nothing next to what they time. They
+ * keep one running total, so they're only for the thread that's stepping.
+ * Phases can nest (gfquad in sweep in an operator, everything in step), but
+ * a phase can't nest in itself.
+ *
+ * With the hardware counters open, each edge also reads cycles, instructions,
+ * cache misses and branch misses (whichever of them the machine will give us),
+ * which costs a syscall per edge, so it's optional. They only count the
+ * stepping thread, so a custom library's own threads don't show up in them.
+ */
+
+#include <stdio.h>
+
+#include "common.h"
+#include "sys.h"
+
+enum {
+	PROF_COP,
+	PROF_DOP,
+	PROF_SWEEP,
+	PROF_REORG,
+	PROF_GFQUAD, // the row loop of a sweep, so it's part of PROF_SWEEP
+	PROF_ELEM,
+	PROF_LUMP,
+	PROF_STEP,
+	PROF_TOTAL
+};
+
+struct profstep_t {
+	u64 step;
+	u64 ns[PROF_TOTAL];    // nanoseconds spent in each phase
+	u64 calls[PROF_TOTAL]; // and how many times it was entered
+	u64 have;              // a bit per SYS_COUNTER_* in counts, 0 without counters
+	u32 scaled;            // a bit per phase whose counts are estimates, the pmu was shared
+	u32 missed;            // a bit per phase that lost some counts to a failed read
+	u64 counts[PROF_TOTAL][SYS_COUNTER_TOTAL];
+};
+
+/* prof_counteropen : counts hardware events in each phase too, returns -1 if we can't have any */
+int prof_counteropen(void);
+
+/* prof_counterclose : goes back to only timing phases */
+void prof_counterclose(void);
+
+/* prof_begin : starts timing a phase */
+void prof_begin(int phase);
+
+/* prof_end : stops timing a phase, adding the time to the step's total */
+void prof_end(int phase);
+
+/* prof_take : moves the totals so far into out, as the given step, and starts over */
+void prof_take(struct profstep_t *out, u64 step);
+
+/* prof_summary : prints a table of where the time went, over n steps */
+void prof_summary(FILE *fp, struct profstep_t *steps, u64 n);
+
+/* prof_tostr : returns the name of a phase */
+char *prof_tostr(int phase);
+
+#endif // PROF_H
+
@@ -0,0 +1,148 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 01:33
+ *
+ * Restarting From A Lump File
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "molt.h"
+#include "config.h"
+#include "codec.h"
+#include "lump.h"
+#include "restart.h"
+
+/* restart_check : checks the lump file's config matches expect (if there is one), and its volumes are all there */
+int restart_check(struct molt_cfg_t *expect)
+{
+	struct molt_cfg_t config;
+	ivec3_t pinc, points;
+	size_t size, want;
+	u64 elems;
+	int i, rc;
+
+	struct {
+		char *tag;
+		size_t elems;
+	} lumps[14];
+
+	rc = lump_read(MOLTSTR_CONFIG, 0, &config);
+	if (rc < 0) {
+		fprintf(stderr, "ERR : lump file has no config to restart from\n");
+		return -1;
+	}
+
+	// the config we would have written has to match the one we did write,
+	// otherwise we'd be continuing a different simulation
+	if (expect) {
+		if (memcmp(expect, &config, sizeof(config)) != 0) {
+			fprintf(stderr, "ERR : config doesn't match the lump file's config\n");
+			return -1;
+		}
+	}
+
+	molt_cfg_parampull_xyz(&config, pinc, MOLT_PARAM_PINC);
+	molt_cfg_parampull_xyz(&config, points, MOLT_PARAM_POINTS);
+
+	elems = pinc[0] * (u64)pinc[1] * pinc[2];
+
+	lumps[ 0].tag = MOLTSTR_VLX; lumps[ 0].elems = pinc[0];
+	lumps[ 1].tag = MOLTSTR_VRX; lumps[ 1].elems = pinc[0];
+	lumps[ 2].tag = MOLTSTR_VLY; lumps[ 2].elems = pinc[1];
+	lumps[ 3].tag = MOLTSTR_VRY; lumps[ 3].elems = pinc[1];
+	lumps[ 4].tag = MOLTSTR_VLZ; lumps[ 4].elems = pinc[2];
+	lumps[ 5].tag = MOLTSTR_VRZ; lumps[ 5].elems = pinc[2];
+	lumps[ 6].tag = MOLTSTR_WLX; lumps[ 6].elems = points[0] * (config.spaceacc + 1);
+	lumps[ 7].tag = MOLTSTR_WRX; lumps[ 7].elems = points[0] * (config.spaceacc + 1);
+	lumps[ 8].tag = MOLTSTR_WLY; lumps[ 8].elems = points[1] * (config.spaceacc + 1);
+	lumps[ 9].tag = MOLTSTR_WRY; lumps[ 9].elems = points[1] * (config.spaceacc + 1);
+	lumps[10].tag = MOLTSTR_WLZ; lumps[10].elems = points[2] * (config.spaceacc + 1);
+	lumps[11].tag = MOLTSTR_WRZ; lumps[11].elems = points[2] * (config.spaceacc + 1);
+	lumps[12].tag = MOLTSTR_VEL; lumps[12].elems = elems;
+	lumps[13].tag = MOLTSTR_AMP; lumps[13].elems = elems;
+
+	for (i = 0; i < ARRSIZE(lumps); i++) {
+		want = sizeof(f64) * lumps[i].elems;
+
+		rc = lump_readsize(lumps[i].tag, 0, &size);
+		if (rc < 0 || size != want) {
+			fprintf(stderr, "ERR : lump file's %s is missing or the wrong size\n", lumps[i].tag);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* restart_fromamp : loads the last two AMP entries into prev and curr to resume from, returns the steps already taken */
+s64 restart_fromamp(struct molt_cfg_t *config, f64 *prev, f64 *curr, s64 *t)
+{
+	struct lumpheader_t hdr;
+	struct lumpinfo_t info;
+	u64 entries, i;
+	int rc;
+
+	/*
+	 * NOTE
+	 * AMP[0] is the initial amplitude, and every step after that appends the
+	 * next AMP. Once we have taken a single step, the last two entries are
+	 * the prev and curr the time loop would have had, so we can resume from
+	 * them. This is only what we fall back on without checkpoints, as the
+	 * workstore the solver carries between steps is lost, and the resumed run
+	 * won't be bit for bit the same. Returns how many steps were already taken.
+	 */
+
+	rc = lump_getnumentries(MOLTSTR_AMP, &entries);
+	if (rc < 0) {
+		return -1;
+	}
+
+	if (entries < 2) {
+		return 0; // nothing was written past the initial conditions
+	}
+
+	// the other output streams get written after a step's AMP, and we can't
+	// tell if the last step got all of them out, so that step gets taken again
+	rc = lump_getheader(&hdr);
+	if (rc < 0) {
+		return -1;
+	}
+
+	for (i = hdr.lumps; 0 < i; i--) {
+		lump_getinfo(&info, i - 1);
+		if (strncmp(info.tag, MOLTSTR_AMP, sizeof(info.tag)) == 0) {
+			break;
+		}
+	}
+
+	if (i < hdr.lumps) {
+		rc = lump_truncate(i - 1);
+		if (rc < 0) {
+			return -1;
+		}
+
+		if (--entries < 2) {
+			return 0;
+		}
+	}
+
+	rc = lump_read(MOLTSTR_AMP, entries - 2, prev);
+	if (rc < 0) {
+		return -1;
+	}
+
+	rc = lump_read(MOLTSTR_AMP, entries - 1, curr);
+	if (rc < 0) {
+		return -1;
+	}
+
+	*t = config->t_params[MOLT_PARAM_START] + (entries - 1) * config->t_params[MOLT_PARAM_STEP];
+
+	fprintf(stderr, "restarting at t = %ld, after %ld steps\n", *t, entries - 1);
+
+	return entries - 1;
+}
@@ -0,0 +1,25 @@
+#ifndef RESTART_H
+#define RESTART_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 01:33
+ *
+ * Restarting From A Lump File
+ *
+ * What --restart needs to know about a lump file that isn't in a checkpoint;
+ * whether it's the simulation we were asked to run, with every volume the
+ * time loop needs, and, when there aren't any checkpoints, where the AMP
+ * entries it already has leave off. Both work on the open lump file.
+ */
+
+#include "common.h"
+#include "molt.h"
+
+/* restart_check : checks the lump file's config matches expect (if there is one), and its volumes are all there */
+int restart_check(struct molt_cfg_t *expect);
+
+/* restart_fromamp : loads the last two AMP entries into prev and curr to resume from, returns the steps already taken */
+s64 restart_fromamp(struct molt_cfg_t *config, f64 *prev, f64 *curr, s64 *t);
+
+#endif // RESTART_H
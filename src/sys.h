@@ -14,12 +14,35 @@
 
 struct sys_file;
 struct sys_thread;
+struct sys_counters;
 typedef struct sys_file sys_file;
 typedef struct sys_thread sys_thread;
 
+#define SYS_IOVMAX 64 // buffers sys_readv takes at once
+
+// hardware counters, as far as the platform (and its permissions) lets us have them
+enum {
+	SYS_COUNTER_CYCLES,
+	SYS_COUNTER_INSTRUCTIONS,
+	SYS_COUNTER_CACHEMISSES, // last level cache misses, mostly, it's up to the cpu
+	SYS_COUNTER_BRANCHMISSES,
+	SYS_COUNTER_TOTAL
+};
+
+struct sys_iovec {
+	void *base;
+	size_t len;
+};
+
 /* sys_open : system wrapper for open */
 sys_file *sys_open(char *name);
 
+/* sys_openread : system wrapper for open, read only and without truncation */
+sys_file *sys_openread(char *name);
+
+/* sys_reopen : system wrapper for open, read/write on an existing file */
+sys_file *sys_reopen(char *name);
+
 /* sys_open : system wrapper for close */
 int sys_close(sys_file *fd);
 
@@ -29,9 +52,47 @@ u64 sys_getsize(sys_file *fd);
 /* sys_read : wrapper for fread */
 size_t sys_read(sys_file *fd, size_t start, size_t len, void *ptr);
 
+/* sys_readv : reads the file, starting at start, filling each of the n buffers in turn */
+size_t sys_readv(sys_file *fd, size_t start, struct sys_iovec *iov, int n);
+
 /* sys_write : wrapper for fwrite */
 size_t sys_write(sys_file *fd, size_t start, size_t len, void *ptr);
 
+/* sys_mmap : maps the first len bytes of the file into memory, read only */
+void *sys_mmap(sys_file *fd, size_t len);
+
+/* sys_munmap : unmaps memory previously mapped with sys_mmap */
+int sys_munmap(void *ptr, size_t len);
+
+/* sys_madvise : hints to the system how we intend to use the mapped range */
+int sys_madvise(void *ptr, size_t len, int advice);
+
+/* sys_shmcreate : creates (or recreates) a named shared memory object, mapped read/write */
+void *sys_shmcreate(char *name, size_t len);
+
+/* sys_shmopen : maps an existing named shared memory object, read only, len gets its size */
+void *sys_shmopen(char *name, size_t *len);
+
+/* sys_shmunlink : removes the name of a shared memory object, existing mappings stay valid */
+int sys_shmunlink(char *name);
+
+enum {
+	SYS_ADVISE_NORMAL,
+	SYS_ADVISE_SEQUENTIAL,
+	SYS_ADVISE_RANDOM,
+	SYS_ADVISE_WILLNEED,
+	SYS_ADVISE_DONTNEED
+};
+
+/* sys_exists : system wrapper to see if a file currently exists */
+int sys_exists(char *path);
+
+/* sys_rename : renames a file, replacing whatever was at the new name */
+int sys_rename(char *from, char *to);
+
+/* sys_mkdir : makes a directory, it already being there is fine */
+int sys_mkdir(char *path);
+
 /* sys_readfile : reads an entire file into a memory buffer */
 char *sys_readfile(char *path);
 
@@ -47,6 +108,21 @@ int sys_libclose(void *handle);
 /* sys_timestamp : gets the current timestamp */
 int sys_timestamp(u64 *sec, u64 *usec);
 
+/* sys_nanotime : gets a monotonic timestamp in nanoseconds, only good for differences */
+u64 sys_nanotime(void);
+
+/* sys_counteropen : starts counting the calling thread's user space, setting a bit in have per counter we got, NULL for none */
+struct sys_counters *sys_counteropen(u32 *have);
+
+/* sys_counterread : reads every counter into vals, SYS_COUNTER_TOTAL of them, the ones we don't have are 0, returns 1 if they're estimates */
+int sys_counterread(struct sys_counters *counters, u64 *vals);
+
+/* sys_counterclose : stops counting */
+void sys_counterclose(struct sys_counters *counters);
+
+/* sys_sleep : sleeps for the given number of milliseconds */
+void sys_sleep(u64 msec);
+
 /* sys_threadcreate : creates a new thread */
 struct sys_thread *sys_threadcreate();
 
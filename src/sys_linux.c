@@ -15,13 +15,18 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <sys/sysinfo.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <dlfcn.h>
 #include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
 
 #include "common.h"
 #include "sys.h"
@@ -37,6 +42,12 @@ struct sys_thread {
 	void *arg;
 };
 
+struct sys_counters {
+	int fd[SYS_COUNTER_TOTAL]; // fd[0] is the group's leader, the rest are in the order they were added
+	int which[SYS_COUNTER_TOTAL]; // the SYS_COUNTER_* each of those is
+	int len;
+};
+
 static void sys_errorhandle()
 {
 	fprintf(stderr, "%s\n", strerror(errno));
@@ -62,6 +73,46 @@ sys_file *sys_open(char *name)
 	return fd;
 }
 
+/* sys_openread : system wrapper for open, read only and without truncation */
+sys_file *sys_openread(char *name)
+{
+	sys_file *fd;
+
+	fd = calloc(1, sizeof(struct sys_file));
+
+	fd->fd = open(name, O_RDONLY);
+
+	if (fd->fd < 0) {
+		sys_errorhandle();
+		free(fd);
+		fd = NULL;
+	} else {
+		strncpy(fd->name, name, sizeof(fd->name));
+	}
+
+	return fd;
+}
+
+/* sys_reopen : system wrapper for open, read/write on an existing file */
+sys_file *sys_reopen(char *name)
+{
+	sys_file *fd;
+
+	fd = calloc(1, sizeof(struct sys_file));
+
+	fd->fd = open(name, O_RDWR);
+
+	if (fd->fd < 0) {
+		sys_errorhandle();
+		free(fd);
+		fd = NULL;
+	} else {
+		strncpy(fd->name, name, sizeof(fd->name));
+	}
+
+	return fd;
+}
+
 /* sys_open : system wrapper for close */
 int sys_close(sys_file *fd)
 {
@@ -112,6 +163,34 @@ size_t sys_read(sys_file *fd, size_t start, size_t len, void *ptr)
 	return bytes;
 }
 
+/* sys_readv : reads the file, starting at start, filling each of the n buffers in turn */
+size_t sys_readv(sys_file *fd, size_t start, struct sys_iovec *iov, int n)
+{
+	struct iovec vec[SYS_IOVMAX];
+	size_t total;
+	ssize_t bytes;
+	int i;
+
+	if (n < 0 || SYS_IOVMAX < n) {
+		return -1;
+	}
+
+	for (i = 0, total = 0; i < n; i++) {
+		vec[i].iov_base = iov[i].base;
+		vec[i].iov_len = iov[i].len;
+		total += iov[i].len;
+	}
+
+	// unlike sys_read, there's no fsync, reading doesn't need one
+	bytes = preadv(fd->fd, vec, n, start);
+	if (bytes < 0 || (size_t)bytes != total) {
+		sys_errorhandle();
+		return -1;
+	}
+
+	return bytes;
+}
+
 /* sys_write : wrapper for fwrite */
 size_t sys_write(sys_file *fd, size_t start, size_t len, void *ptr)
 {
@@ -139,12 +218,171 @@ size_t sys_write(sys_file *fd, size_t start, size_t len, void *ptr)
 	return bytes;
 }
 
+/* sys_mmap : maps the first len bytes of the file into memory, read only */
+void *sys_mmap(sys_file *fd, size_t len)
+{
+	void *p;
+
+	p = mmap(NULL, len, PROT_READ, MAP_SHARED, fd->fd, 0);
+	if (p == MAP_FAILED) {
+		sys_errorhandle();
+		return NULL;
+	}
+
+	return p;
+}
+
+/* sys_munmap : unmaps memory previously mapped with sys_mmap */
+int sys_munmap(void *ptr, size_t len)
+{
+	int rc;
+
+	rc = munmap(ptr, len);
+	if (rc < 0) {
+		sys_errorhandle();
+	}
+
+	return rc;
+}
+
+/* sys_madvise : hints to the system how we intend to use the mapped range */
+int sys_madvise(void *ptr, size_t len, int advice)
+{
+	uintptr_t base, page;
+	int rc, flag;
+
+	switch (advice) {
+	case SYS_ADVISE_SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+	case SYS_ADVISE_RANDOM:     flag = MADV_RANDOM;     break;
+	case SYS_ADVISE_WILLNEED:   flag = MADV_WILLNEED;   break;
+	case SYS_ADVISE_DONTNEED:   flag = MADV_DONTNEED;   break;
+	default:                    flag = MADV_NORMAL;     break;
+	}
+
+	// madvise wants a page aligned address, so we round the start down, and
+	// grow the length by however much we moved it
+	page = sysconf(_SC_PAGESIZE);
+	base = (uintptr_t)ptr & ~(page - 1);
+	len += (uintptr_t)ptr - base;
+
+	rc = madvise((void *)base, len, flag);
+	if (rc < 0) {
+		sys_errorhandle();
+	}
+
+	return rc;
+}
+
+/* sys_shmcreate : creates (or recreates) a named shared memory object, mapped read/write */
+void *sys_shmcreate(char *name, size_t len)
+{
+	void *p;
+	int fd;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		sys_errorhandle();
+		return NULL;
+	}
+
+	if (ftruncate(fd, len) < 0) {
+		sys_errorhandle();
+		close(fd);
+		return NULL;
+	}
+
+	p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	close(fd); // the mapping keeps the object around
+
+	if (p == MAP_FAILED) {
+		sys_errorhandle();
+		return NULL;
+	}
+
+	return p;
+}
+
+/* sys_shmopen : maps an existing named shared memory object, read only, len gets its size */
+void *sys_shmopen(char *name, size_t *len)
+{
+	struct stat st;
+	void *p;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		return NULL; // quietly, it might just not be there yet
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	close(fd);
+
+	if (p == MAP_FAILED) {
+		sys_errorhandle();
+		return NULL;
+	}
+
+	*len = st.st_size;
+
+	return p;
+}
+
+/* sys_shmunlink : removes the name of a shared memory object, existing mappings stay valid */
+int sys_shmunlink(char *name)
+{
+	int rc;
+
+	rc = shm_unlink(name);
+	if (rc < 0) {
+		sys_errorhandle();
+	}
+
+	return rc;
+}
+
 /* sys_exists : system wrapper to see if a file currently exists */
 int sys_exists(char *path)
 {
 	return access(path, F_OK) == 0;
 }
 
+/* sys_rename : renames a file, replacing whatever was at the new name */
+int sys_rename(char *from, char *to)
+{
+	int rc;
+
+	rc = rename(from, to);
+	if (rc < 0) {
+		sys_errorhandle();
+	}
+
+	return rc;
+}
+
+/* sys_mkdir : makes a directory, it already being there is fine */
+int sys_mkdir(char *path)
+{
+	int rc;
+
+	rc = mkdir(path, 0777);
+	if (rc < 0 && errno == EEXIST) {
+		rc = 0;
+	}
+
+	if (rc < 0) {
+		sys_errorhandle();
+	}
+
+	return rc;
+}
+
 /* sys_readfile : reads an entire file into a memory buffer */
 char *sys_readfile(char *path)
 {
@@ -233,6 +471,141 @@ int sys_timestamp(u64 *sec, u64 *usec)
 	return 0;
 }
 
+/* sys_nanotime : gets a monotonic timestamp in nanoseconds, only good for differences */
+u64 sys_nanotime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* sys_counteropen : starts counting the calling thread's user space, setting a bit in have per counter we got, NULL for none */
+struct sys_counters *sys_counteropen(u32 *have)
+{
+	struct sys_counters *counters;
+	struct perf_event_attr attr;
+	int i, fd;
+
+	static u64 configs[SYS_COUNTER_TOTAL] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	/*
+	 * NOTE
+	 * The counters are one group, so they're all scheduled on the pmu at once,
+	 * and one read gets all of them. Plenty of machines (virtual ones, mostly)
+	 * don't have every counter, so the group is just the ones that open. Only
+	 * counting user space keeps this working at perf_event_paranoid 2, which
+	 * is most distros' default. Containers often don't allow the syscall at
+	 * all, and then we've got nothing.
+	 */
+
+	counters = calloc(1, sizeof(*counters));
+
+	*have = 0;
+
+	for (i = 0; i < SYS_COUNTER_TOTAL; i++) {
+		memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.disabled = counters->len == 0; // the leader starts the whole group
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		fd = syscall(__NR_perf_event_open, &attr, 0, -1, counters->len ? counters->fd[0] : -1, 0);
+		if (fd < 0) {
+			continue;
+		}
+
+		counters->fd[counters->len] = fd;
+		counters->which[counters->len] = i;
+		counters->len++;
+
+		*have |= 1 << i;
+	}
+
+	if (counters->len == 0) {
+		free(counters);
+		return NULL;
+	}
+
+	ioctl(counters->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(counters->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+	return counters;
+}
+
+/* sys_counterread : reads every counter into vals, SYS_COUNTER_TOTAL of them, the ones we don't have are 0, returns 1 if they're estimates */
+int sys_counterread(struct sys_counters *counters, u64 *vals)
+{
+	u64 buf[3 + SYS_COUNTER_TOTAL]; // the number of counters, time enabled, time running, then each one's value
+	u64 enabled, running;
+	ssize_t rc;
+	int i;
+
+	/*
+	 * NOTE
+	 * When there are more events than the pmu has room for (someone else is
+	 * running perf, or the hypervisor took some), the kernel takes turns with
+	 * the group, and it only counts while it's on. Then the counts are scaled
+	 * up by the time it should have been on over the time it was, the way
+	 * perf stat does it, and the caller's told they're estimates.
+	 */
+
+	memset(vals, 0, sizeof(*vals) * SYS_COUNTER_TOTAL);
+
+	rc = read(counters->fd[0], buf, sizeof(buf));
+	if (rc < (ssize_t)(3 * sizeof(u64)) || buf[0] != (u64)counters->len) {
+		return -1;
+	}
+
+	enabled = buf[1];
+	running = buf[2];
+
+	if (running == 0 && enabled != 0) {
+		return -1; // never got on the pmu at all, there's nothing to scale
+	}
+
+	for (i = 0; i < counters->len; i++) {
+		vals[counters->which[i]] = buf[3 + i];
+		if (running < enabled) {
+			vals[counters->which[i]] = (u64)((f64)buf[3 + i] * enabled / running);
+		}
+	}
+
+	return running < enabled ? 1 : 0;
+}
+
+/* sys_counterclose : stops counting */
+void sys_counterclose(struct sys_counters *counters)
+{
+	int i;
+
+	if (counters == NULL) {
+		return;
+	}
+
+	for (i = counters->len - 1; 0 <= i; i--) {
+		close(counters->fd[i]);
+	}
+
+	free(counters);
+}
+
+/* sys_sleep : sleeps for the given number of milliseconds */
+void sys_sleep(u64 msec)
+{
+	usleep(msec * 1000);
+}
+
 /* sys_threadwrap : wrapper to get pairity with the pthread functionality */
 static void *sys_threadwrap(void *arg)
 {
@@ -326,7 +699,7 @@ int sys_bipopen(FILE **readfp, FILE **writefp, char *command)
 	int pipes[4];
 	char *args[BUFSMALL];
 	char buf[BUFLARGE];
-	char *s;
+	char *s, *save;
 	int i, rc;
 
 	strncpy(buf, command, sizeof(buf));
@@ -334,17 +707,19 @@ int sys_bipopen(FILE **readfp, FILE **writefp, char *command)
 	memset(args, 0, sizeof(args));
 
 	// parse our arguments for exec
-	s = strtok(buf, " ");
+	s = strtoks(buf, " ", &save);
 	for (i = 0; s && i < ARRSIZE(args); i++) {
 		args[i] = s;
-		s = strtok(NULL, " ");
+		s = strtoks(NULL, " ", &save);
 	}
 
-	rc = pipe(&pipes[0]); // parent read, child write pipes
+	// close on exec, so a child some other thread starts at the same time
+	// doesn't hold our ends open (dup2 clears it for the child's own stdio)
+	rc = pipe2(&pipes[0], O_CLOEXEC); // parent read, child write pipes
 	if (rc < 0) {
 		sys_errorhandle();
 	}
-	rc = pipe(&pipes[2]); // child read, parent write pipes
+	rc = pipe2(&pipes[2], O_CLOEXEC); // child read, parent write pipes
 	if (rc < 0) {
 		sys_errorhandle();
 	}
@@ -353,12 +728,11 @@ int sys_bipopen(FILE **readfp, FILE **writefp, char *command)
 		// install signal handler to clean up the child
 		signal(SIGCHLD, sigchld_handler);
 
+		// both ends are left fully buffered, callers flush (or close) when they
+		// need the other side to see what they've written
 		*readfp  = fdopen(pipes[0], "r");
 		*writefp = fdopen(pipes[3], "w");
 
-		rc = setvbuf(*readfp, NULL, _IONBF, 0);
-		rc = setvbuf(*writefp, NULL, _IONBF, 0);
-
 		rc = close(pipes[1]);
 		if (rc < 0) {
 			sys_errorhandle();
@@ -79,6 +79,46 @@ sys_file *sys_open(char *name)
 	return fd;
 }
 
+/* sys_openread : system wrapper for open, read only and without truncation */
+sys_file *sys_openread(char *name)
+{
+	struct sys_file *fd;
+
+	fd = calloc(1, sizeof(struct sys_file));
+
+	fd->fd = _open(name, O_RDONLY|O_BINARY);
+
+	if (fd->fd < 0) {
+		sys_errorhandle();
+		free(fd);
+		fd = NULL;
+	} else {
+		strncpy(fd->name, name, sizeof(fd->name));
+	}
+
+	return fd;
+}
+
+/* sys_reopen : system wrapper for open, read/write on an existing file */
+sys_file *sys_reopen(char *name)
+{
+	struct sys_file *fd;
+
+	fd = calloc(1, sizeof(struct sys_file));
+
+	fd->fd = _open(name, O_RDWR|O_BINARY);
+
+	if (fd->fd < 0) {
+		sys_errorhandle();
+		free(fd);
+		fd = NULL;
+	} else {
+		strncpy(fd->name, name, sizeof(fd->name));
+	}
+
+	return fd;
+}
+
 /* sys_open : system wrapper for close */
 int sys_close(sys_file *fd)
 {
@@ -128,6 +168,37 @@ size_t sys_read(sys_file *fd, size_t start, size_t len, void *ptr)
 	return bytes;
 }
 
+/* sys_readv : reads the file, starting at start, filling each of the n buffers in turn */
+size_t sys_readv(sys_file *fd, size_t start, struct sys_iovec *iov, int n)
+{
+	__int64 off;
+	size_t total, bytes;
+	int i;
+
+	if (n < 0 || SYS_IOVMAX < n) {
+		return -1;
+	}
+
+	off = _lseek(fd->fd, start, SEEK_SET);
+	if (off == -1L) {
+		sys_errorhandle();
+		return -1;
+	}
+
+	// there's no scatter read for plain file descriptors, but the seek only
+	// has to happen once, the buffers are all back to back in the file
+	for (i = 0, total = 0; i < n; i++) {
+		bytes = _read(fd->fd, iov[i].base, iov[i].len);
+		if (bytes != iov[i].len) {
+			sys_errorhandle();
+			return -1;
+		}
+		total += bytes;
+	}
+
+	return total;
+}
+
 /* sys_write : wrapper for fwrite */
 size_t sys_write(sys_file *fd, size_t start, size_t len, void *ptr)
 {
@@ -155,10 +226,134 @@ size_t sys_write(sys_file *fd, size_t start, size_t len, void *ptr)
 	return bytes;
 }
 
+/* sys_mmap : maps the first len bytes of the file into memory, read only */
+void *sys_mmap(sys_file *fd, size_t len)
+{
+	HANDLE file, mapping;
+	void *p;
+
+	file = (HANDLE)_get_osfhandle(fd->fd);
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		sys_lasterror();
+		return NULL;
+	}
+
+	p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, len);
+	if (p == NULL) {
+		sys_lasterror();
+	}
+
+	// the view keeps its own reference to the mapping object
+	CloseHandle(mapping);
+
+	return p;
+}
+
+/* sys_munmap : unmaps memory previously mapped with sys_mmap */
+int sys_munmap(void *ptr, size_t len)
+{
+	if (!UnmapViewOfFile(ptr)) {
+		sys_lasterror();
+		return -1;
+	}
+
+	return 0;
+}
+
+/* sys_madvise : hints to the system how we intend to use the mapped range */
+int sys_madvise(void *ptr, size_t len, int advice)
+{
+	// NOTE win32 doesn't have a direct equivalent for most of these,
+	// and the cache manager does a decent job of read-ahead on its own
+	return 0;
+}
+
+/* sys_shmcreate : creates (or recreates) a named shared memory object, mapped read/write */
+void *sys_shmcreate(char *name, size_t len)
+{
+	HANDLE mapping;
+	void *p;
+
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (u64)len >> 32, len & 0xffffffff, name);
+	if (mapping == NULL) {
+		sys_lasterror();
+		return NULL;
+	}
+
+	p = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, len);
+	if (p == NULL) {
+		sys_lasterror();
+	} else {
+		memset(p, 0, len); // an existing object doesn't come back zeroed
+	}
+
+	// the view keeps its own reference to the mapping object
+	CloseHandle(mapping);
+
+	return p;
+}
+
+/* sys_shmopen : maps an existing named shared memory object, read only, len gets its size */
+void *sys_shmopen(char *name, size_t *len)
+{
+	MEMORY_BASIC_INFORMATION info;
+	HANDLE mapping;
+	void *p;
+
+	mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (mapping == NULL) {
+		return NULL; // quietly, it might just not be there yet
+	}
+
+	p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	CloseHandle(mapping);
+
+	if (p == NULL) {
+		sys_lasterror();
+		return NULL;
+	}
+
+	VirtualQuery(p, &info, sizeof(info));
+
+	*len = info.RegionSize;
+
+	return p;
+}
+
+/* sys_shmunlink : removes the name of a shared memory object, existing mappings stay valid */
+int sys_shmunlink(char *name)
+{
+	// NOTE named mappings on win32 go away with the last view of them
+	return 0;
+}
+
 /* sys_exists : system wrapper to see if a file currently exists */
 int sys_exists(char *path)
 {
-	return _access(path, 0);
+	return _access(path, 0) == 0;
+}
+
+/* sys_rename : renames a file, replacing whatever was at the new name */
+int sys_rename(char *from, char *to)
+{
+	if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* sys_mkdir : makes a directory, it already being there is fine */
+int sys_mkdir(char *path)
+{
+	if (!CreateDirectoryA(path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+		return -1;
+	}
+
+	return 0;
 }
 
 /* sys_readfile : reads an entire file into a memory buffer */
@@ -280,6 +475,49 @@ int sys_timestamp(u64 *sec, u64 *usec)
 }
 #endif
 
+/* sys_nanotime : gets a monotonic timestamp in nanoseconds, only good for differences */
+u64 sys_nanotime(void)
+{
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+
+	QueryPerformanceCounter(&now);
+
+	// split up, so the multiply can't overflow
+	return (u64)(now.QuadPart / freq.QuadPart) * 1000000000 +
+		(u64)(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+}
+
+/* sys_counteropen : starts counting the calling thread's user space, setting a bit in have per counter we got, NULL for none */
+struct sys_counters *sys_counteropen(u32 *have)
+{
+	// NOTE windows only hands these out to drivers (or ETW), so we never have any
+	*have = 0;
+	return NULL;
+}
+
+/* sys_counterread : reads every counter into vals, SYS_COUNTER_TOTAL of them, the ones we don't have are 0, returns 1 if they're estimates */
+int sys_counterread(struct sys_counters *counters, u64 *vals)
+{
+	memset(vals, 0, sizeof(*vals) * SYS_COUNTER_TOTAL);
+	return -1;
+}
+
+/* sys_counterclose : stops counting */
+void sys_counterclose(struct sys_counters *counters)
+{
+}
+
+/* sys_sleep : sleeps for the given number of milliseconds */
+void sys_sleep(u64 msec)
+{
+	Sleep(msec);
+}
+
 /* sys_threadwrap : wrapper to get pairity with the pthread functionality */
 static DWORD sys_threadwrap(void *arg)
 {
@@ -324,7 +562,7 @@ int sys_threadsetarg(struct sys_thread *thread, void *arg)
 int sys_threadstart(struct sys_thread *thread)
 {
 	thread->thread = CreateThread(NULL, 0, sys_threadwrap, thread, 0, NULL);
-	return 0;
+	return thread->thread == NULL;
 }
 
 /* sys_threadwait : waits for the given thread to exit, then returns */
@@ -412,13 +650,19 @@ int sys_bipopen(FILE **readfp, FILE **writefp, char *command)
 	CloseHandle(procinfo.hProcess);
 	CloseHandle(procinfo.hThread);
 
+	// the child has its own copies of its ends now, and if we kept ours, we'd
+	// never see the end of its output
+	CloseHandle(cpipe_in);
+	CloseHandle(cpipe_out);
+
 	// now that we've finally done the equivalent of calling fork(),
 	// we have to setup our C-friendly FILE *'s.
 	ppipe_fdin  = _open_osfhandle((intptr_t)ppipe_in, _O_RDONLY);
 	ppipe_fdout = _open_osfhandle((intptr_t)ppipe_out, _O_WRONLY);
 
-	*readfp = _fdopen(ppipe_fdin, "rt");
-	*writefp = _fdopen(ppipe_fdout, "wt");
+	// binary, so raw values from the init program come through untouched
+	*readfp = _fdopen(ppipe_fdin, "rb");
+	*writefp = _fdopen(ppipe_fdout, "wb");
 
 	return 0;
 }
@@ -0,0 +1,177 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 03:21
+ *
+ * Trace Events
+ *
+ * Rings are linked onto a list as threads show up, and never taken off of it,
+ * since a pool's threads can be gone by the time we write the file. Nothing
+ * reads a ring until trace_close, which is only called once every thread
+ * that could be recording is done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "sys.h"
+#include "trace.h"
+
+struct traceevent_t {
+	char *name;
+	u64 start;
+	u64 end;
+};
+
+struct tracering_t {
+	struct tracering_t *next;
+	struct traceevent_t *events;
+	u64 head; // events recorded so far, the newest is at (head - 1) % len
+	u64 len;
+	s32 tid;
+};
+
+static struct tracering_t *g_rings;
+static char g_path[BUFLARGE];
+static u64 g_events;
+static u64 g_epoch;
+static s32 g_tids;
+static int g_on;
+
+static __thread struct tracering_t *t_ring;
+
+/* trace_ring : gets the calling thread's ring, making it the first time */
+static struct tracering_t *trace_ring(void)
+{
+	struct tracering_t *ring;
+
+	if (t_ring) {
+		return t_ring;
+	}
+
+	ring = calloc(1, sizeof(*ring));
+	ring->events = calloc(g_events, sizeof(*ring->events));
+	ring->len = g_events;
+	ring->tid = __atomic_fetch_add(&g_tids, 1, __ATOMIC_RELAXED);
+
+	ring->next = __atomic_load_n(&g_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&g_rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+
+	t_ring = ring;
+
+	return ring;
+}
+
+/* trace_open : starts tracing into the file at path, each thread keeping its last 'events' events */
+int trace_open(char *path, u64 events)
+{
+	if (path == NULL || events == 0) {
+		return -1;
+	}
+
+	strncpy(g_path, path, sizeof(g_path) - 1);
+
+	g_events = events;
+	g_epoch = sys_nanotime();
+	g_on = 1;
+
+	// whoever opens the trace is tid 0, the simulation's thread
+	trace_ring();
+
+	return 0;
+}
+
+/* trace_on : returns true if we're tracing */
+int trace_on(void)
+{
+	return g_on;
+}
+
+/* trace_span : records that the calling thread spent [start, end) in name, a string that has to outlive the trace */
+void trace_span(char *name, u64 start, u64 end)
+{
+	struct tracering_t *ring;
+	struct traceevent_t *event;
+
+	if (!g_on) {
+		return;
+	}
+
+	ring = trace_ring();
+
+	event = ring->events + ring->head % ring->len;
+	event->name = name;
+	event->start = start;
+	event->end = end;
+
+	ring->head++;
+}
+
+/* trace_close : writes out every thread's events, and stops tracing */
+int trace_close(void)
+{
+	struct tracering_t *ring, *next;
+	struct traceevent_t *event;
+	FILE *fp;
+	u64 i, first;
+	int comma;
+
+	if (!g_on) {
+		return 0;
+	}
+
+	g_on = 0;
+
+	fp = fopen(g_path, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "ERR : couldn't open trace file '%s'\n", g_path);
+	}
+
+	if (fp) {
+		fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	}
+
+	comma = 0;
+
+	for (ring = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); ring; ring = next) {
+		next = ring->next;
+
+		if (fp) {
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+				comma ? ",\n" : "", ring->tid, ring->tid ? "worker" : "molt", ring->tid);
+			comma = 1;
+
+			first = ring->head < ring->len ? 0 : ring->head - ring->len;
+			if (first) {
+				fprintf(stderr, "WRN : trace thread %d kept its last %lu events, and dropped %lu\n",
+					ring->tid, (unsigned long)ring->len, (unsigned long)first);
+			}
+
+			// times are microseconds since the trace was opened
+			for (i = first; i < ring->head; i++) {
+				event = ring->events + i % ring->len;
+				fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3lf,\"dur\":%.3lf}",
+					event->name, ring->tid, 1e-3 * (s64)(event->start - g_epoch), 1e-3 * (event->end - event->start));
+			}
+		}
+
+		free(ring->events);
+		free(ring);
+	}
+
+	g_rings = NULL;
+	g_tids = 0;
+	t_ring = NULL;
+
+	if (fp == NULL) {
+		return -1;
+	}
+
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+
+	return 0;
+}
+
@@ -0,0 +1,38 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 03:21
+ *
+ * Trace Events
+ *
+ * With --trace, every timed span (the phases in prof.h, plus whatever the
+ * custom library hands us, like its jobs and its waits on them) is kept as a
+ * Chrome trace event, and written out as JSON at the end of the run, which
+ * chrome://tracing and Perfetto both open.
+ *
+ * Each thread gets a ring of its own the first time it records anything, so
+ * recording is a couple of stores, with nothing shared and nothing to lock.
+ * When a ring fills up, the oldest events get written over, so a long run
+ * only keeps its last stretch, but it never grows, and never slows down.
+ */
+
+#include "common.h"
+
+#define TRACE_EVENTS (1 << 16) // events each thread's ring holds, by default
+
+/* trace_open : starts tracing into the file at path, each thread keeping its last 'events' events */
+int trace_open(char *path, u64 events);
+
+/* trace_on : returns true if we're tracing */
+int trace_on(void);
+
+/* trace_span : records that the calling thread spent [start, end) in name, a string that has to outlive the trace */
+void trace_span(char *name, u64 start, u64 end);
+
+/* trace_close : writes out every thread's events, and stops tracing */
+int trace_close(void);
+
+#endif // TRACE_H
+
@@ -0,0 +1,195 @@
+/*
+ * agent
+ * Mon Oct 19, 2026 03:08
+ *
+ * Weight Cache
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "sys.h"
+#include "wcache.h"
+
+#define WCACHE_MAGIC *(u32 *)"MWGT"
+#define WCACHE_VERSION 1
+
+#define WCACHE_FNVBASIS 0xcbf29ce484222325ULL
+#define WCACHE_FNVPRIME 0x100000001b3ULL
+
+/* wcache_hash : folds len bytes into the running FNV-1a hash h */
+static u64 wcache_hash(u64 h, void *ptr, size_t len)
+{
+	u8 *p;
+	size_t i;
+
+	p = ptr;
+
+	for (i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= WCACHE_FNVPRIME;
+	}
+
+	return h;
+}
+
+/* wcache_header : fills out the header for a set of parameters, the checksum is left to the caller */
+static void wcache_header(struct wcachehdr_t *hdr, f64 nu, s32 nulen, s32 orderm)
+{
+	memset(hdr, 0, sizeof(*hdr));
+
+	hdr->magic = WCACHE_MAGIC;
+	hdr->version = WCACHE_VERSION;
+	hdr->nu = nu;
+	hdr->nulen = nulen;
+	hdr->orderm = orderm;
+	hdr->count = (u64)nulen * (orderm + 1);
+}
+
+/* wcache_path : makes the name of the entry for a header */
+static void wcache_path(char *path, size_t len, char *dir, struct wcachehdr_t *hdr)
+{
+	u64 key;
+
+	// everything up to the checksum is what the weights depend on
+	key = wcache_hash(WCACHE_FNVBASIS, hdr, offsetof(struct wcachehdr_t, checksum));
+
+	snprintf(path, len, "%s/w%016llx.bin", dir, (unsigned long long)key);
+}
+
+/* wcache_entry : makes the name of the file the weights for a set of parameters are cached in */
+void wcache_entry(char *path, size_t len, char *dir, f64 nu, s32 nulen, s32 orderm)
+{
+	struct wcachehdr_t hdr;
+
+	wcache_header(&hdr, nu, nulen, orderm);
+	wcache_path(path, len, dir, &hdr);
+}
+
+/* wcache_load : fills wl and wr from the cache in dir, returns 0 if they were there, -1 if they weren't */
+int wcache_load(char *dir, f64 nu, s32 nulen, s32 orderm, f64 *wl, f64 *wr)
+{
+	struct wcachehdr_t want, *hdr;
+	char path[BUFLARGE];
+	sys_file *fd;
+	f64 *data;
+	size_t len;
+	u64 sum;
+	int rc;
+
+	if (dir == NULL || nulen < 1 || orderm < 0) {
+		return -1;
+	}
+
+	wcache_header(&want, nu, nulen, orderm);
+	wcache_path(path, sizeof path, dir, &want);
+
+	if (!sys_exists(path)) {
+		return -1;
+	}
+
+	fd = sys_openread(path);
+	if (fd == NULL) {
+		return -1;
+	}
+
+	len = sizeof(want) + 2 * want.count * sizeof(f64);
+
+	if (sys_getsize(fd) != len) {
+		sys_close(fd);
+		free(fd);
+		return -1;
+	}
+
+	hdr = sys_mmap(fd, len);
+	if (hdr == NULL) {
+		sys_close(fd);
+		free(fd);
+		return -1;
+	}
+
+	data = (f64 *)(hdr + 1);
+	sum = wcache_hash(WCACHE_FNVBASIS, data, 2 * want.count * sizeof(f64));
+
+	// the hash only picked the file, the header has to actually be what we asked for
+	if (memcmp(hdr, &want, offsetof(struct wcachehdr_t, checksum)) == 0 && hdr->checksum == sum) {
+		memcpy(wl, data, want.count * sizeof(f64));
+		memcpy(wr, data + want.count, want.count * sizeof(f64));
+		rc = 0;
+	} else {
+		fprintf(stderr, "WRN : weight cache entry '%s' is damaged, making the weights again\n", path);
+		rc = -1;
+	}
+
+	sys_munmap(hdr, len);
+	sys_close(fd);
+	free(fd);
+
+	return rc;
+}
+
+/* wcache_store : saves wl and wr into the cache in dir */
+int wcache_store(char *dir, f64 nu, s32 nulen, s32 orderm, f64 *wl, f64 *wr)
+{
+	struct wcachehdr_t *hdr;
+	char path[BUFLARGE], tmp[BUFLARGE + BUFSMALL];
+	sys_file *fd;
+	f64 *data;
+	size_t len, bytes;
+	u64 sec, usec;
+	int rc;
+
+	if (dir == NULL || nulen < 1 || orderm < 0) {
+		return -1;
+	}
+
+	if (sys_mkdir(dir) < 0) {
+		return -1;
+	}
+
+	len = sizeof(*hdr) + 2 * (u64)nulen * (orderm + 1) * sizeof(f64);
+
+	hdr = calloc(1, len);
+	data = (f64 *)(hdr + 1);
+
+	wcache_header(hdr, nu, nulen, orderm);
+	memcpy(data, wl, hdr->count * sizeof(f64));
+	memcpy(data + hdr->count, wr, hdr->count * sizeof(f64));
+	hdr->checksum = wcache_hash(WCACHE_FNVBASIS, data, 2 * hdr->count * sizeof(f64));
+
+	wcache_path(path, sizeof path, dir, hdr);
+
+	/*
+	 * NOTE
+	 * Other runs (and our own other axes) can be storing the very same entry
+	 * right now, so each writer gets a temporary name of its own. Whichever
+	 * rename lands last wins, and they're all the same anyway.
+	 */
+
+	sys_timestamp(&sec, &usec);
+	snprintf(tmp, sizeof tmp, "%s.%llx.%llx.tmp", path,
+		(unsigned long long)(sec * 1000000 + usec), (unsigned long long)(size_t)wl);
+
+	fd = sys_open(tmp);
+	if (fd == NULL) {
+		free(hdr);
+		return -1;
+	}
+
+	bytes = sys_write(fd, 0, len, hdr);
+
+	sys_close(fd);
+	free(fd);
+	free(hdr);
+
+	if (bytes != len) {
+		return -1;
+	}
+
+	rc = sys_rename(tmp, path);
+
+	return rc;
+}
+
@@ -0,0 +1,46 @@
+#ifndef WCACHE_H
+#define WCACHE_H
+
+/*
+ * agent
+ * Mon Oct 19, 2026 03:08
+ *
+ * Weight Cache
+ *
+ * The quadrature weights only depend on nu, the number of points and the
+ * order of accuracy, so a sweep that reruns the same grid over and over makes
+ * the same weights every time. This keeps them in a directory, a file per set
+ * of parameters, named by a hash of them. A file is a wcachehdr_t, then the
+ * left weights, then the right ones, as native doubles, so it can be mapped
+ * and copied straight out.
+ *
+ * Nothing here is ever trusted; the header has to match the parameters we
+ * asked for (not just the hash), the file has to be exactly the right size,
+ * and the weights have to checksum to what the header says, or it's a miss.
+ * Entries are written to a temporary name and renamed into place, so runs
+ * sharing a cache never see half of one.
+ */
+
+#include "common.h"
+
+struct wcachehdr_t {
+	u32 magic;    // "MWGT"
+	u32 version;  // WCACHE_VERSION, bumped whenever the weights would come out differently
+	f64 nu;
+	s32 nulen;
+	s32 orderm;
+	u64 count;    // f64s in each of the two tables, nulen * (orderm + 1)
+	u64 checksum; // of both tables
+};
+
+/* wcache_entry : makes the name of the file the weights for a set of parameters are cached in */
+void wcache_entry(char *path, size_t len, char *dir, f64 nu, s32 nulen, s32 orderm);
+
+/* wcache_load : fills wl and wr from the cache in dir, returns 0 if they were there, -1 if they weren't */
+int wcache_load(char *dir, f64 nu, s32 nulen, s32 orderm, f64 *wl, f64 *wr);
+
+/* wcache_store : saves wl and wr into the cache in dir */
+int wcache_store(char *dir, f64 nu, s32 nulen, s32 orderm, f64 *wl, f64 *wr);
+
+#endif // WCACHE_H
+